@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+// Creates a tree of real audio files for scan benchmarks.
+// The files are copies of the test files with the tags of a synthetic library.
+
+#include <taglib/fileref.h>
+#include <taglib/tpropertymap.h>
+#include <taglib/mpegfile.h>
+#include <taglib/vorbisfile.h>
+#include <taglib/mp4file.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/attachedpictureframe.h>
+#include <taglib/flacpicture.h>
+
+#include <QtCore/qbuffer.h>
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtGui/qimage.h>
+#include <QtGui/qpainter.h>
+
+#include <cstdio>
+#include "SyntheticLibrary.h"
+
+namespace {
+
+    TagLib::String toTagLibString(const QString& s)
+    {
+        return TagLib::String(s.toUtf8().constData(), TagLib::String::UTF8);
+    }
+
+    /**
+    * A gradient in album specific colors, so that every album gets its own cover checksum.
+    */
+    QByteArray createCover(int size, quint16 seed)
+    {
+        QImage image(size, size, QImage::Format_RGB32);
+
+        QLinearGradient gradient(0, 0, size, size);
+        gradient.setColorAt(0, QColor::fromHsv(seed % 360, 200, 230));
+        gradient.setColorAt(1, QColor::fromHsv((seed / 360) % 360, 255, 60));
+
+        QPainter painter(&image);
+        painter.fillRect(image.rect(), gradient);
+        painter.end();
+
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "JPG", 85);
+
+        return bytes;
+    }
+
+    /**
+    * Replaces all pictures in the file. Only the formats with a common picture API in TagLib are supported,
+    * other files keep the picture of their template.
+    */
+    void setCover(TagLib::File* file, const QByteArray& cover)
+    {
+        const TagLib::ByteVector bytes(cover.constData(), static_cast<unsigned int>(cover.size()));
+
+        if (auto mpeg_file = dynamic_cast<TagLib::MPEG::File*>(file))
+        {
+            TagLib::ID3v2::Tag* tag = mpeg_file->ID3v2Tag(true);
+            tag->removeFrames("APIC");
+
+            if (!cover.isEmpty())
+            {
+                auto frame = new TagLib::ID3v2::AttachedPictureFrame();
+                frame->setMimeType("image/jpeg");
+                frame->setType(TagLib::ID3v2::AttachedPictureFrame::FrontCover);
+                frame->setPicture(bytes);
+                tag->addFrame(frame);
+            }
+        }
+        else if (auto vorbis_file = dynamic_cast<TagLib::Ogg::Vorbis::File*>(file))
+        {
+            TagLib::Ogg::XiphComment* tag = vorbis_file->tag();
+            tag->removeAllPictures();
+
+            if (!cover.isEmpty())
+            {
+                auto picture = new TagLib::FLAC::Picture();
+                picture->setMimeType("image/jpeg");
+                picture->setType(TagLib::FLAC::Picture::FrontCover);
+                picture->setData(bytes);
+                tag->addPicture(picture);
+            }
+        }
+        else if (auto mp4_file = dynamic_cast<TagLib::MP4::File*>(file))
+        {
+            TagLib::MP4::CoverArtList cover_art_list;
+            if (!cover.isEmpty())
+                cover_art_list.append(TagLib::MP4::CoverArt(TagLib::MP4::CoverArt::JPEG, bytes));
+
+            mp4_file->tag()->setItem("covr", cover_art_list);
+        }
+    }
+
+    bool writeTags(const QString& filepath, const TrackInfo& info, const QByteArray& cover)
+    {
+#if _WIN32
+        TagLib::FileRef file_ref(TagLib::FileName(filepath.toStdWString().data()), false);
+#else
+        TagLib::FileRef file_ref(TagLib::FileName(filepath.toStdString().data()), false);
+#endif
+
+        if (file_ref.isNull())
+            return false;
+
+        TagLib::Tag* tag = file_ref.tag();
+        tag->setArtist(toTagLibString(info.artist));
+        tag->setAlbum(toTagLibString(info.album));
+        tag->setTitle(toTagLibString(info.title));
+        tag->setGenre(toTagLibString(info.genre));
+        tag->setComment(toTagLibString(info.comment));
+        tag->setYear(info.year);
+        tag->setTrack(info.track_number);
+
+        TagLib::PropertyMap properties = file_ref.file()->properties();
+        properties.erase("ALBUMARTIST");
+        properties.erase("DISCNUMBER");
+        if (!info.album_artist.isEmpty())
+            properties.insert("ALBUMARTIST", TagLib::StringList(toTagLibString(info.album_artist)));
+        if (info.disc_number != 0)
+            properties.insert("DISCNUMBER", TagLib::StringList(TagLib::String::number(info.disc_number)));
+        file_ref.file()->setProperties(properties);
+
+        setCover(file_ref.file(), cover);
+
+        return file_ref.save();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Creates a tree of audio files with synthetic tags, for scan benchmarks.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("output", "Directory to create the files in.");
+
+    const QCommandLineOption files_option("files", "Number of files to create.", "count", "10000");
+    const QCommandLineOption tracks_per_album_option("tracks-per-album", "Number of files per album directory.", "count", "10");
+    const QCommandLineOption templates_option("templates", "Directory with the noise.* test files.", "dir", "test/data");
+    const QCommandLineOption formats_option("formats", "Comma separated list of file formats to use, the albums alternate between them.", "list", "mp3,ogg,m4a");
+    const QCommandLineOption cover_size_option("cover-size", "Width and height of the embedded covers, 0 removes the covers.", "pixels", "500");
+    const QCommandLineOption seed_option("seed", "Seed of the synthetic tags.", "number", "1");
+
+    parser.addOptions({ files_option, tracks_per_album_option, templates_option, formats_option, cover_size_option, seed_option });
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    const QDir output_dir(parser.positionalArguments().front());
+    const int number_of_files = parser.value(files_option).toInt();
+    const int tracks_per_album = std::max(1, parser.value(tracks_per_album_option).toInt());
+    const int cover_size = parser.value(cover_size_option).toInt();
+    const QStringList formats = parser.value(formats_option).split(',', Qt::SkipEmptyParts);
+
+    // the templates are read once, every file is a plain copy before the tags are rewritten
+
+    std::vector<QByteArray> templates;
+    for (const QString& format : formats)
+    {
+        QFile file(QDir(parser.value(templates_option)).filePath("noise." + format));
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            fprintf(stderr, "Cannot read %s\n", qPrintable(file.fileName()));
+            return 1;
+        }
+
+        templates.push_back(file.readAll());
+    }
+
+    if (templates.empty())
+        parser.showHelp(1);
+
+    const int number_of_albums = (number_of_files + tracks_per_album - 1) / tracks_per_album;
+    const std::vector<SyntheticTrack> tracks = SyntheticLibraryGenerator(parser.value(seed_option).toUInt()).createTracks(number_of_albums, tracks_per_album);
+
+    QByteArray cover;
+
+    for (int i = 0; i < number_of_files; ++i)
+    {
+        const SyntheticTrack& track = tracks[i];
+        const int album_index = i / tracks_per_album;
+        const size_t format_index = album_index % templates.size();
+
+        // the synthetic paths start with "/music/" and use the original suffix
+
+        QString relative_path = track.filepath.section('/', 2);
+        relative_path = relative_path.left(relative_path.lastIndexOf('.') + 1) + formats[format_index];
+
+        const QString filepath = output_dir.filePath(relative_path);
+        if (!output_dir.mkpath(QFileInfo(filepath).path()))
+        {
+            fprintf(stderr, "Cannot create the directory for %s\n", qPrintable(filepath));
+            return 1;
+        }
+
+        QFile file(filepath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(templates[format_index]) != templates[format_index].size())
+        {
+            fprintf(stderr, "Cannot write %s\n", qPrintable(filepath));
+            return 1;
+        }
+        file.close();
+
+        if (i % tracks_per_album == 0)
+            cover = cover_size > 0 && !track.info.cover.isEmpty() ? createCover(cover_size, track.info.cover.checksum) : QByteArray();
+
+        if (!writeTags(filepath, track.info, cover))
+        {
+            fprintf(stderr, "Cannot write the tags of %s\n", qPrintable(filepath));
+            return 1;
+        }
+
+        if ((i + 1) % 1000 == 0)
+            printf("%d files created\n", i + 1);
+    }
+
+    printf("%d files created in %s\n", number_of_files, qPrintable(output_dir.absolutePath()));
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,386 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <QtCore/qbuffer.h>
+#include <QtWidgets/qapplication.h>
+
+#include <AudioLibraryModel.h>
+#include <ThreadSafeAudioLibrary.h>
+#include "SyntheticLibrary.h"
+
+namespace {
+
+    std::atomic<int64_t> allocation_count = 0;
+}
+
+// every allocation of the benchmarks is counted, the number of small allocations is what a memory pool saves
+
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = std::malloc(size > 0 ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace {
+
+    /**
+    * Reports the allocations per iteration, only while the timing isn't paused.
+    */
+    class AllocationCounter
+    {
+    public:
+        void start() { _start_count = allocation_count.load(); }
+        void stop() { _allocations += allocation_count.load() - _start_count; }
+
+        void report(benchmark::State& state) const
+        {
+            state.counters["allocations"] = benchmark::Counter(static_cast<double>(_allocations), benchmark::Counter::kAvgIterations);
+        }
+
+    private:
+        int64_t _start_count = 0;
+        int64_t _allocations = 0;
+    };
+
+    const int TRACKS_PER_ALBUM = 10;
+
+    /**
+    * Generating large libraries takes a while, so each size is only created once.
+    */
+    const std::vector<SyntheticTrack>& getTracks(int number_of_tracks, int tracks_per_album = TRACKS_PER_ALBUM)
+    {
+        static std::map<std::pair<int, int>, std::vector<SyntheticTrack>> tracks_for_size;
+
+        const std::pair<int, int> size(number_of_tracks, tracks_per_album);
+
+        auto it = tracks_for_size.find(size);
+        if (it == tracks_for_size.end())
+            it = tracks_for_size.emplace(size, SyntheticLibraryGenerator().createTracks(number_of_tracks / tracks_per_album, tracks_per_album)).first;
+
+        return it->second;
+    }
+
+    const AudioLibrary& getLibrary(int number_of_tracks, int tracks_per_album = TRACKS_PER_ALBUM)
+    {
+        static std::map<std::pair<int, int>, std::unique_ptr<AudioLibrary>> library_for_size;
+
+        const std::pair<int, int> size(number_of_tracks, tracks_per_album);
+
+        auto it = library_for_size.find(size);
+        if (it == library_for_size.end())
+        {
+            auto library = std::make_unique<AudioLibrary>();
+            addSyntheticTracks(*library, getTracks(number_of_tracks, tracks_per_album));
+            it = library_for_size.emplace(size, std::move(library)).first;
+        }
+
+        return *it->second;
+    }
+
+    QByteArray saveLibrary(const AudioLibrary& library)
+    {
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+
+        QDataStream stream(&buffer);
+        library.save(stream);
+
+        return bytes;
+    }
+
+    void addLibrarySizes(benchmark::internal::Benchmark* b)
+    {
+        b->Arg(10000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+    }
+
+    void BM_AddTrack(benchmark::State& state)
+    {
+        const std::vector<SyntheticTrack>& tracks = getTracks(static_cast<int>(state.range(0)));
+
+        AllocationCounter allocation_counter;
+
+        for (auto _ : state)
+        {
+            allocation_counter.start();
+
+            auto library = std::make_unique<AudioLibrary>();
+            addSyntheticTracks(*library, tracks);
+
+            // destroying the library is not part of the measurement
+            state.PauseTiming();
+            allocation_counter.stop();
+            library.reset();
+            state.ResumeTiming();
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tracks.size()));
+        allocation_counter.report(state);
+    }
+
+    void BM_Save(benchmark::State& state)
+    {
+        const AudioLibrary& library = getLibrary(static_cast<int>(state.range(0)));
+
+        qint64 bytes_written = 0;
+
+        for (auto _ : state)
+        {
+            const QByteArray bytes = saveLibrary(library);
+            bytes_written += bytes.size();
+        }
+
+        state.SetBytesProcessed(bytes_written);
+    }
+
+    void BM_Load(benchmark::State& state)
+    {
+        const QByteArray bytes = saveLibrary(getLibrary(static_cast<int>(state.range(0))));
+
+        AllocationCounter allocation_counter;
+
+        for (auto _ : state)
+        {
+            allocation_counter.start();
+
+            QDataStream stream(bytes);
+
+            auto library = std::make_unique<AudioLibrary>();
+            library->load(stream);
+
+            benchmark::DoNotOptimize(library->getNumberOfTracks());
+
+            state.PauseTiming();
+            allocation_counter.stop();
+            library.reset();
+            state.ResumeTiming();
+        }
+
+        state.SetBytesProcessed(state.iterations() * bytes.size());
+        allocation_counter.report(state);
+    }
+
+    /**
+    * Removes every tenth track of a large library, like when a folder with many albums is deleted.
+    * The argument is the number of tracks per album, box sets with many tracks must not make it slower.
+    */
+    void BM_RemoveTracks(benchmark::State& state)
+    {
+        const int NUMBER_OF_TRACKS = 1000000;
+
+        const int tracks_per_album = static_cast<int>(state.range(0));
+        const std::vector<SyntheticTrack>& tracks = getTracks(NUMBER_OF_TRACKS, tracks_per_album);
+        const AudioLibrary& library_to_copy = getLibrary(NUMBER_OF_TRACKS, tracks_per_album);
+
+        std::unordered_set<QString> remaining_files;
+        for (size_t i = 0; i < tracks.size(); ++i)
+            if (i % 10 != 0)
+                remaining_files.insert(tracks[i].filepath);
+
+        const size_t tracks_to_remove = tracks.size() - remaining_files.size();
+
+        for (auto _ : state)
+        {
+            // copying and destroying the library is not part of the measurement
+            state.PauseTiming();
+            auto library = std::make_unique<AudioLibrary>(library_to_copy);
+            state.ResumeTiming();
+
+            library->removeTracksExcept(remaining_files);
+
+            benchmark::DoNotOptimize(library->getNumberOfTracks());
+
+            state.PauseTiming();
+            library.reset();
+            state.ResumeTiming();
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(tracks_to_remove));
+    }
+
+    /**
+    * The deep copy, which snapshots used to make under the library lock.
+    */
+    void BM_CopyLibrary(benchmark::State& state)
+    {
+        const AudioLibrary& library_to_copy = getLibrary(static_cast<int>(state.range(0)));
+
+        for (auto _ : state)
+        {
+            auto library = std::make_unique<AudioLibrary>(library_to_copy);
+
+            benchmark::DoNotOptimize(library->getNumberOfTracks());
+
+            state.PauseTiming();
+            library.reset();
+            state.ResumeTiming();
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(library_to_copy.getNumberOfTracks()));
+    }
+
+    /**
+    * Publishes a snapshot after a batch of tracks has been parsed again, like the scanner does while it runs.
+    */
+    void BM_PublishSnapshot(benchmark::State& state)
+    {
+        const int CHANGED_TRACKS = 1000;
+
+        const std::vector<SyntheticTrack>& tracks = getTracks(static_cast<int>(state.range(0)));
+
+        ThreadSafeAudioLibrary library;
+
+        {
+            ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+            addSyntheticTracks(acc.getLibraryForUpdate(), tracks);
+        }
+
+        size_t next_track = 0;
+
+        auto change_tracks = [&]() {
+            ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+
+            for (int i = 0; i < CHANGED_TRACKS; ++i, next_track = (next_track + 1) % tracks.size())
+                addSyntheticTracks(acc.getLibraryForUpdate(), { tracks[next_track] });
+        };
+
+        // the first snapshot is a copy, the second one catches up with all tracks, then both only lack the last changes
+
+        library.publishSnapshot();
+        change_tracks();
+        library.publishSnapshot();
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            change_tracks();
+            state.ResumeTiming();
+
+            library.publishSnapshot();
+        }
+
+        state.SetItemsProcessed(state.iterations() * CHANGED_TRACKS);
+    }
+
+    void BM_CreateItems(benchmark::State& state, std::function<std::unique_ptr<AudioLibraryView>()> view_factory, AudioLibraryView::DisplayMode display_mode)
+    {
+        const AudioLibrary& library = getLibrary(static_cast<int>(state.range(0)));
+        const std::unique_ptr<AudioLibraryView> view = view_factory();
+
+        AudioLibraryGroupUuidCache group_uuids;
+
+        for (auto _ : state)
+        {
+            AudioLibraryModel model(nullptr, group_uuids);
+            AudioLibraryRowSet rows;
+            view->createItems(library, display_mode, rows);
+            model.addRows(std::move(rows));
+
+            benchmark::DoNotOptimize(model.getModel()->rowCount());
+
+            state.PauseTiming();
+            state.counters["rows"] = model.getModel()->rowCount();
+            state.ResumeTiming();
+        }
+    }
+
+    void BM_Sort(benchmark::State& state, AudioLibraryView::Column column)
+    {
+        const AudioLibrary& library = getLibrary(static_cast<int>(state.range(0)));
+
+        AudioLibraryGroupUuidCache group_uuids;
+        AudioLibraryModel model(nullptr, group_uuids);
+        AudioLibraryRowSet rows;
+        AudioLibraryViewAllTracks(QString()).createItems(library, AudioLibraryView::DisplayMode::TRACKS, rows);
+        model.addRows(std::move(rows));
+
+        // alternate the order, so that every iteration has to move the rows
+
+        bool ascending = true;
+
+        for (auto _ : state)
+        {
+            model.getModel()->sort(column, ascending ? Qt::AscendingOrder : Qt::DescendingOrder);
+            ascending = !ascending;
+        }
+
+        state.SetItemsProcessed(state.iterations() * model.getModel()->rowCount());
+    }
+
+    void registerBenchmarks()
+    {
+        addLibrarySizes(benchmark::RegisterBenchmark("AddTrack", BM_AddTrack));
+        addLibrarySizes(benchmark::RegisterBenchmark("Save", BM_Save));
+        addLibrarySizes(benchmark::RegisterBenchmark("Load", BM_Load));
+        benchmark::RegisterBenchmark("RemoveTracks", BM_RemoveTracks)->Arg(10)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+        addLibrarySizes(benchmark::RegisterBenchmark("CopyLibrary", BM_CopyLibrary));
+        addLibrarySizes(benchmark::RegisterBenchmark("PublishSnapshot", BM_PublishSnapshot));
+
+        // all views, with and without filter, the filter words are common in the generated strings
+
+        using DisplayMode = AudioLibraryView::DisplayMode;
+
+        const std::vector<std::tuple<QString, std::function<std::unique_ptr<AudioLibraryView>()>, DisplayMode>> views = {
+            { "AllArtists", [] { return std::make_unique<AudioLibraryViewAllArtists>(QString()); }, DisplayMode::ARTISTS },
+            { "AllArtists/Filter", [] { return std::make_unique<AudioLibraryViewAllArtists>("the"); }, DisplayMode::ARTISTS },
+            { "AllAlbums", [] { return std::make_unique<AudioLibraryViewAllAlbums>(QString()); }, DisplayMode::ALBUMS },
+            { "AllAlbums/Filter", [] { return std::make_unique<AudioLibraryViewAllAlbums>("night !fire"); }, DisplayMode::ALBUMS },
+            { "AllTracks", [] { return std::make_unique<AudioLibraryViewAllTracks>(QString()); }, DisplayMode::TRACKS },
+            { "AllTracks/Filter", [] { return std::make_unique<AudioLibraryViewAllTracks>("the"); }, DisplayMode::TRACKS },
+            { "AllTracks/FilterNoMatch", [] { return std::make_unique<AudioLibraryViewAllTracks>("xyzzy"); }, DisplayMode::TRACKS },
+            { "AllYears", [] { return std::make_unique<AudioLibraryViewAllYears>(); }, DisplayMode::YEARS },
+            { "AllGenres", [] { return std::make_unique<AudioLibraryViewAllGenres>(QString()); }, DisplayMode::GENRES },
+            { "AllGenres/Filter", [] { return std::make_unique<AudioLibraryViewAllGenres>("metal"); }, DisplayMode::GENRES },
+            { "Artist/Albums", [] { return std::make_unique<AudioLibraryViewArtist>(SyntheticLibraryGenerator::artistName(0)); }, DisplayMode::ALBUMS },
+            { "Artist/Tracks", [] { return std::make_unique<AudioLibraryViewArtist>(SyntheticLibraryGenerator::artistName(0)); }, DisplayMode::TRACKS },
+            { "Year/Albums", [] { return std::make_unique<AudioLibraryViewYear>(1990); }, DisplayMode::ALBUMS },
+            { "Year/Tracks", [] { return std::make_unique<AudioLibraryViewYear>(1990); }, DisplayMode::TRACKS },
+            { "Genre/Albums", [] { return std::make_unique<AudioLibraryViewGenre>("Rock"); }, DisplayMode::ALBUMS },
+            { "Genre/Tracks", [] { return std::make_unique<AudioLibraryViewGenre>("Rock"); }, DisplayMode::TRACKS },
+            { "DuplicateAlbums", [] { return std::make_unique<AudioLibraryViewDuplicateAlbums>(); }, DisplayMode::ALBUMS },
+        };
+
+        for (const auto& [name, view_factory, display_mode] : views)
+            addLibrarySizes(benchmark::RegisterBenchmark(("CreateItems/" + name).toStdString(), BM_CreateItems, view_factory, display_mode));
+
+        for (AudioLibraryView::Column column : { AudioLibraryView::ARTIST, AudioLibraryView::TITLE, AudioLibraryView::LENGTH_SECONDS, AudioLibraryView::DATE_MODIFIED })
+            addLibrarySizes(benchmark::RegisterBenchmark(("Sort/" + AudioLibraryView::getColumnId(column)).toStdString(), BM_Sort, column));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // the model needs a gui application for its icons, but the benchmarks run headless
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    registerBenchmarks();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
\ No newline at end of file
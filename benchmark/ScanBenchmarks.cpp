@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+// End to end scans of a corpus created with corpus_generator.
+// The corpus directory is passed in the environment variable AUDIO_EXPLORER_CORPUS.
+
+#include <benchmark/benchmark.h>
+
+#include <QtCore/qdiriterator.h>
+
+#include <ThreadSafeAudioLibrary.h>
+
+namespace {
+
+    QString getCorpusPath(benchmark::State& state)
+    {
+        const QString corpus_path = qEnvironmentVariable("AUDIO_EXPLORER_CORPUS");
+        if (corpus_path.isEmpty())
+            state.SkipWithError("AUDIO_EXPLORER_CORPUS is not set");
+
+        return corpus_path;
+    }
+
+    void scan(ThreadSafeAudioLibrary& library, const QString& corpus_path)
+    {
+        AudioFilesLoader loader(library);
+        loader.startLoading({ corpus_path });
+
+        while (loader.isLoading())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    /**
+    * Changes the modification time of the given share of the files, so that a rescan has to read them again.
+    */
+    void touchFiles(const QString& corpus_path, int percent, int iteration)
+    {
+        const QDateTime modification_time = QDateTime::currentDateTime().addSecs(iteration);
+
+        int index = 0;
+        for (QDirIterator it(corpus_path, QDir::Files, QDirIterator::Subdirectories); it.hasNext(); ++index)
+        {
+            const QString filepath = it.next();
+            if (index % 100 >= percent)
+                continue;
+
+            QFile file(filepath);
+            if (file.open(QIODevice::ReadWrite))
+                file.setFileTime(modification_time, QFileDevice::FileModificationTime);
+        }
+    }
+
+    void BM_ColdScan(benchmark::State& state)
+    {
+        const QString corpus_path = getCorpusPath(state);
+
+        for (auto _ : state)
+        {
+            ThreadSafeAudioLibrary library;
+            scan(library, corpus_path);
+
+            state.PauseTiming();
+            state.counters["tracks"] = static_cast<double>(ThreadSafeAudioLibrary::LibraryAccessor(library).getLibrary().getNumberOfTracks());
+            state.ResumeTiming();
+        }
+    }
+
+    void BM_Rescan(benchmark::State& state)
+    {
+        const QString corpus_path = getCorpusPath(state);
+        const int changed_percent = static_cast<int>(state.range(0));
+
+        ThreadSafeAudioLibrary library;
+        if (!corpus_path.isEmpty())
+            scan(library, corpus_path);
+
+        int iteration = 0;
+
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            if (changed_percent > 0)
+                touchFiles(corpus_path, changed_percent, ++iteration);
+            state.ResumeTiming();
+
+            scan(library, corpus_path);
+        }
+    }
+}
+
+// the scan runs in the loader thread, so only the wall clock time is meaningful
+
+BENCHMARK(BM_ColdScan)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Rescan)->ArgName("changed_percent")->Arg(0)->Arg(1)->Arg(10)->Unit(benchmark::kMillisecond)->UseRealTime();
\ No newline at end of file
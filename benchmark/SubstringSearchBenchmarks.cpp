@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+// Substring search kernels of the view filters, compared with QString::contains.
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+
+#include <AudioLibrarySearchIndex.h>
+#include <SubstringSearch.h>
+
+#include "SyntheticLibrary.h"
+
+namespace {
+
+    enum Haystack
+    {
+        TITLES,
+        PATHS,
+    };
+
+    const QString NEEDLE = QStringLiteral("eternal");
+
+    struct Haystacks
+    {
+        std::vector<QString> raw[2];
+        std::vector<QString> folded[2];
+    };
+
+    const Haystacks& getHaystacks()
+    {
+        static const Haystacks haystacks = [] {
+            Haystacks result;
+
+            for (const SyntheticTrack& track : SyntheticLibraryGenerator().createTracks(10000, 10))
+            {
+                result.raw[TITLES].push_back(track.info.title);
+                result.raw[PATHS].push_back(track.filepath);
+            }
+
+            for (int i : { TITLES, PATHS })
+                for (const QString& text : result.raw[i])
+                    result.folded[i].push_back(AudioLibrarySearchIndex::foldText(text));
+
+            return result;
+        }();
+
+        return haystacks;
+    }
+
+    void BM_ContainsSubstring(benchmark::State& state, SubstringSearchKernel kernel)
+    {
+        const std::vector<SubstringSearchKernel>& supported_kernels = getSupportedSubstringSearchKernels();
+        if (std::ranges::find(supported_kernels, kernel) == supported_kernels.end())
+        {
+            state.SkipWithError("not supported by this CPU");
+            return;
+        }
+
+        const std::vector<QString>& haystacks = getHaystacks().folded[state.range(0)];
+
+        for (auto _ : state)
+        {
+            int matches = 0;
+            for (const QString& haystack : haystacks)
+                matches += containsSubstring(haystack, NEEDLE, kernel);
+
+            benchmark::DoNotOptimize(matches);
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(haystacks.size()));
+    }
+
+    /**
+    * The filters used to search the raw text case-insensitively, before the folded keys existed.
+    */
+    void BM_QStringContains(benchmark::State& state, Qt::CaseSensitivity case_sensitivity)
+    {
+        const Haystacks& all_haystacks = getHaystacks();
+        const std::vector<QString>& haystacks = case_sensitivity == Qt::CaseSensitive ? all_haystacks.folded[state.range(0)] : all_haystacks.raw[state.range(0)];
+
+        for (auto _ : state)
+        {
+            int matches = 0;
+            for (const QString& haystack : haystacks)
+                matches += haystack.contains(NEEDLE, case_sensitivity);
+
+            benchmark::DoNotOptimize(matches);
+        }
+
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(haystacks.size()));
+    }
+}
+
+BENCHMARK_CAPTURE(BM_ContainsSubstring, scalar, SubstringSearchKernel::SCALAR)->ArgName("paths")->Arg(TITLES)->Arg(PATHS);
+BENCHMARK_CAPTURE(BM_ContainsSubstring, sse2, SubstringSearchKernel::SSE2)->ArgName("paths")->Arg(TITLES)->Arg(PATHS);
+BENCHMARK_CAPTURE(BM_ContainsSubstring, avx2, SubstringSearchKernel::AVX2)->ArgName("paths")->Arg(TITLES)->Arg(PATHS);
+BENCHMARK_CAPTURE(BM_QStringContains, case_sensitive, Qt::CaseSensitive)->ArgName("paths")->Arg(TITLES)->Arg(PATHS);
+BENCHMARK_CAPTURE(BM_QStringContains, case_insensitive, Qt::CaseInsensitive)->ArgName("paths")->Arg(TITLES)->Arg(PATHS);
\ No newline at end of file
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <random>
+#include <vector>
+#include <AudioLibrary.h>
+
+/**
+* A track as the scanner would produce it, without a file behind it.
+*/
+struct SyntheticTrack
+{
+    QString filepath;
+    QDateTime last_modified;
+    qint64 file_size = 0;
+    TrackInfo info;
+};
+
+/**
+* Deterministic generator for large libraries.
+*
+* Artists and genres follow a skewed distribution, so that some groups are large and many are small, like in real collections.
+* Only std::mt19937 is used for randomness, because the distributions of the standard library differ between implementations.
+*/
+class SyntheticLibraryGenerator
+{
+public:
+    SyntheticLibraryGenerator(quint32 seed = 1) : _rng(seed) {}
+
+    std::vector<SyntheticTrack> createTracks(int number_of_albums, int tracks_per_album);
+
+    /**
+    * Artists with small indices have the most albums.
+    */
+    static QString artistName(int index);
+
+private:
+    int random(int n) { return static_cast<int>(_rng() % static_cast<quint32>(n)); }
+    double uniform() { return _rng() / 4294967296.0; }
+
+    /**
+    * Small indices are much more likely than large ones.
+    */
+    int skewed(int n) { return static_cast<int>(n * uniform() * uniform() * uniform()); }
+
+    bool chance(int percent) { return random(100) < percent; }
+
+    QString words(int min_words, int max_words);
+
+    std::mt19937 _rng;
+};
+
+inline QString SyntheticLibraryGenerator::words(int min_words, int max_words)
+{
+    static const char* const WORDS[] = {
+        "the", "of", "night", "fire", "dark", "light", "heart", "dream", "love", "time",
+        "world", "river", "stone", "blood", "road", "sky", "rain", "storm", "shadow", "gold",
+        "silver", "iron", "wild", "lost", "broken", "eternal", "last", "first", "black", "white",
+        "blue", "red", "ocean", "mountain", "winter", "summer", "dance", "song", "ghost", "king",
+        "queen", "angel", "devil", "city", "home", "journey", "secret", "silence", "thunder", "echo",
+        "mirror", "garden", "machine", "electric", "golden", "hollow", "crystal", "velvet", "neon", "midnight",
+        "Straße", "Über", "Schön", "Élan", "Café", "Señor", "Mañana", "Ørsted", "Ångström", "Ça va",
+    };
+    const int number_of_words = static_cast<int>(std::size(WORDS));
+
+    QStringList result;
+
+    for (int i = 0, n = min_words + random(max_words - min_words + 1); i < n; ++i)
+    {
+        // the common words are at the start of the list
+        QString word = QString::fromUtf8(WORDS[skewed(number_of_words)]);
+        if (i == 0 || word.length() > 3)
+            word[0] = word[0].toUpper();
+
+        result.append(word);
+    }
+
+    return result.join(' ');
+}
+
+inline QString SyntheticLibraryGenerator::artistName(int index)
+{
+    static const char* const FIRST_NAMES[] = { "John", "Mary", "David", "Anna", "Lars", "Björn", "Miguel", "Yuki", "Chloé", "Ravi", "Olga", "Kwame" };
+    static const char* const LAST_NAMES[] = { "Smith", "Miller", "Johansson", "Müller", "García", "Tanaka", "Dubois", "Kowalski", "Nakamura", "Okafor", "Ivanova", "Singh" };
+
+    // deterministic per index, so that the same artist keeps the same name
+    std::mt19937 rng(static_cast<quint32>(index) * 2654435761u);
+
+    switch (rng() % 3)
+    {
+    case 0:
+        return QString("The %1 %2").arg(QString::fromUtf8(FIRST_NAMES[rng() % std::size(FIRST_NAMES)]), QString::fromUtf8(LAST_NAMES[rng() % std::size(LAST_NAMES)])) + 's';
+    case 1:
+        return QString("%1 %2").arg(QString::fromUtf8(FIRST_NAMES[rng() % std::size(FIRST_NAMES)]), QString::fromUtf8(LAST_NAMES[rng() % std::size(LAST_NAMES)]));
+    default:
+        return QString("%1 %2").arg(QString::fromUtf8(LAST_NAMES[rng() % std::size(LAST_NAMES)])).arg(index);
+    }
+}
+
+inline std::vector<SyntheticTrack> SyntheticLibraryGenerator::createTracks(int number_of_albums, int tracks_per_album)
+{
+    static const char* const GENRES[] = {
+        "Rock", "Pop", "Metal", "Jazz", "Electronic", "Hip-Hop", "Classical", "Folk", "Blues", "Country",
+        "Power Metal", "Thrash Metal", "Punk", "Reggae", "Soul", "Funk", "Ambient", "Techno", "House", "Indie",
+        "Alternative", "Soundtrack", "Gospel", "Latin", "Ska", "Grunge", "Progressive Rock", "Synthpop", "Trance", "Schlager",
+    };
+    const int number_of_genres = static_cast<int>(std::size(GENRES));
+
+    static const int BITRATES[] = { 128, 192, 256, 320 };
+
+    const int number_of_artists = std::max(1, number_of_albums / 4);
+    const QDateTime base_time = QDateTime::fromSecsSinceEpoch(1577836800); // 2020-01-01
+
+    std::vector<SyntheticTrack> tracks;
+    tracks.reserve(size_t(number_of_albums) * size_t(tracks_per_album));
+
+    for (int album_index = 0; album_index < number_of_albums; ++album_index)
+    {
+        const QString artist = artistName(skewed(number_of_artists));
+        const bool is_compilation = chance(5);
+        const QString album = words(1, 4);
+        const QString genre = QString::fromUtf8(GENRES[skewed(number_of_genres)]);
+        const int year = chance(3) ? 0 : 1960 + random(65);
+        const bool is_flac = chance(20);
+        const QString directory = QString("/music/%1/%2 - %3 (%4)").arg(is_compilation ? QString("Various Artists") : artist).arg(year).arg(album).arg(album_index);
+
+        CoverLocation cover;
+        if (chance(80))
+        {
+            const int size = (chance(70) ? 500 : 1000) + 100 * random(3);
+
+            cover.offset = 10 + random(64);
+            cover.data_size = 20 * 1024 + random(300 * 1024);
+            cover.checksum = static_cast<quint16>(1 + random(65535));
+            cover.format = chance(85) ? "jpg" : "png";
+            cover.image_size = QSize(size, size);
+        }
+
+        for (int track_index = 0; track_index < tracks_per_album; ++track_index)
+        {
+            SyntheticTrack track;
+
+            TrackInfo& info = track.info;
+            info.artist = is_compilation ? artistName(random(number_of_artists)) : artist;
+            info.album_artist = is_compilation ? QString("Various Artists") : QString();
+            info.album = album;
+            info.year = year;
+            info.genre = genre;
+            info.cover = cover;
+            info.disc_number = chance(10) ? 0 : 1;
+            info.title = words(1, 5);
+            info.track_number = track_index + 1;
+            info.comment = chance(5) ? words(3, 8) : QString();
+            info.tag_types = is_flac ? "Vorbis comment" : "ID3v1, ID3v2";
+            info.length_milliseconds = 90000 + random(330000);
+            info.channels = 2;
+            info.bitrate_kbs = is_flac ? 700 + random(500) : BITRATES[random(4)];
+            info.samplerate_hz = chance(80) ? 44100 : 48000;
+
+            track.filepath = QString("%1/%2 %3.%4").arg(directory).arg(track_index + 1, 2, 10, QChar('0')).arg(info.title).arg(is_flac ? "flac" : "mp3");
+            track.last_modified = base_time.addSecs(random(5 * 365 * 24 * 3600));
+            track.file_size = qint64(info.bitrate_kbs) * info.length_milliseconds / 8;
+
+            // the cover is read from the first track of the album
+            if (!cover.isEmpty() && track_index == 0)
+                cover.filepath = track.filepath;
+            info.cover.filepath = cover.filepath;
+
+            tracks.push_back(std::move(track));
+        }
+    }
+
+    return tracks;
+}
+
+inline void addSyntheticTracks(AudioLibrary& library, const std::vector<SyntheticTrack>& tracks)
+{
+    for (const SyntheticTrack& track : tracks)
+        library.addTrack(track.filepath, track.last_modified, track.file_size, track.info);
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+// Scans audio directories and writes the library cache without the GUI.
+
+#include <algorithm>
+#include <cstdio>
+#include <QtCore/qcommandlineparser.h>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qstandardpaths.h>
+#include <QtCore/qthread.h>
+#include "Settings.h"
+#include "ThreadSafeAudioLibrary.h"
+#include "project_version.h"
+#include "Tracing.h"
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(APPLICATION_NAME);
+
+    Settings settings;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Scans audio directories and writes the AudioExplorer library cache.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("dirs", "Directories to scan, by default the ones configured in AudioExplorer.", "[dirs...]");
+
+    const QCommandLineOption threads_option("threads", "Number of threads parsing files.", "count", QString::number(QThread::idealThreadCount()));
+    const QCommandLineOption mode_option("mode", "\"fast\" estimates length and bitrate first and reads exact values afterwards, \"accurate\" reads exact values right away.", "mode", "accurate");
+    const QCommandLineOption cache_option("cache", "Location of the cache file.", "file", QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/AudioLibrary");
+    const QCommandLineOption rebuild_option("rebuild", "Ignore the existing cache and read all files again.");
+
+    parser.addOptions({ threads_option, mode_option, cache_option, rebuild_option });
+    parser.process(app);
+
+    const QStringList audio_dir_paths = !parser.positionalArguments().isEmpty() ? parser.positionalArguments() : settings.audio_dir_paths.getValue();
+    if (audio_dir_paths.isEmpty())
+    {
+        fprintf(stderr, "No directories to scan\n");
+        return 1;
+    }
+
+    const QString mode = parser.value(mode_option);
+    if (mode != "fast" && mode != "accurate")
+    {
+        fprintf(stderr, "Unknown mode \"%s\"\n", qPrintable(mode));
+        return 1;
+    }
+
+    ThreadSafeAudioLibrary library;
+    library.setCacheLocation(parser.value(cache_option));
+
+    if (parser.isSet(rebuild_option))
+        library.setFinishedLoadingFromCache();
+
+    AudioFilesLoaderTuning tuning;
+    tuning.thread_count = std::max(1, parser.value(threads_option).toInt());
+
+    AudioFilesLoader audio_files_loader(library);
+    audio_files_loader.setAudioPropertiesMode(mode == "fast" ? AudioPropertiesMode::FAST : AudioPropertiesMode::ACCURATE);
+    audio_files_loader.setTuning(tuning);
+
+    // there is no event loop, so the progress is printed directly from the loader thread
+
+    QObject::connect(&audio_files_loader, &AudioFilesLoader::libraryLoadProgressed, [](int files_loaded, int files_in_cache, float files_per_sec, float megabytes_per_sec) {
+        printf("%d files loaded, %d from cache (%.0f files/s, %.1f MB/s)\n", files_loaded, files_in_cache, files_per_sec, megabytes_per_sec);
+        fflush(stdout);
+        });
+    QObject::connect(&audio_files_loader, &AudioFilesLoader::libraryAudioPropertiesRefined, [](int tracks_refined) {
+        printf("Exact length and bitrate read for %d files\n", tracks_refined);
+        });
+
+    audio_files_loader.startLoading(audio_dir_paths);
+
+    while (audio_files_loader.isLoading())
+        QThread::msleep(10);
+
+    const bool cache_saved = library.saveToCache();
+
+    // statistics
+
+    const AudioFilesLoader::Statistics statistics = audio_files_loader.getStatistics();
+    const int files_scanned = statistics.files_loaded + statistics.files_in_cache;
+    const float duration_sec = std::max(statistics.duration_sec, 0.001f);
+
+    size_t number_of_albums = 0;
+    size_t number_of_tracks = 0;
+    AudioLibrary::MemoryUsage memory_usage;
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+
+        number_of_albums = acc.getLibrary().getAlbums().size();
+        number_of_tracks = acc.getLibrary().getNumberOfTracks();
+        memory_usage = acc.getLibrary().getMemoryUsage();
+    }
+
+    auto megabytes = [](size_t bytes) { return bytes / (1024.0 * 1024.0); };
+
+    printf("Scanned %d files in %.2fs: %d parsed, %d from cache\n", files_scanned, statistics.duration_sec, statistics.files_loaded, statistics.files_in_cache);
+    printf("Throughput: %.0f files/s, %.1f MB/s with %d threads\n", files_scanned / duration_sec, statistics.bytes_loaded / (1024.0 * 1024.0) / duration_sec, tuning.thread_count);
+    printf("Library lock acquired %d times, %d without batching\n", statistics.lock_acquisitions, statistics.unbatched_lock_acquisitions);
+    printf("Library: %zu albums, %zu tracks\n", number_of_albums, number_of_tracks);
+    printf("Library memory: %.1f MB (strings %.1f MB, tracks %.1f MB, albums %.1f MB, covers %.1f MB, maps %.1f MB, search index %.1f MB), %zu bytes per track\n",
+        megabytes(memory_usage.total()), megabytes(memory_usage.strings), megabytes(memory_usage.tracks),
+        megabytes(memory_usage.albums), megabytes(memory_usage.covers), megabytes(memory_usage.maps), megabytes(memory_usage.search_index),
+        number_of_tracks > 0 ? memory_usage.total() / number_of_tracks : 0);
+
+    saveChromeTraceFromEnvironment();
+
+    // unattended runs only have the exit code to tell that something went wrong
+
+    if (!statistics.completed)
+    {
+        fprintf(stderr, "The scan was stopped before all files were read\n");
+        return 1;
+    }
+
+    if (!cache_saved)
+    {
+        fprintf(stderr, "Could not write the cache to %s\n", qPrintable(library.getCacheLocation()));
+        return 1;
+    }
+
+    printf("Cache written to %s\n", qPrintable(library.getCacheLocation()));
+
+    return 0;
+}
\ No newline at end of file
@@ -1,6 +1,11 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "AudioLibrary.h"
+#include <algorithm>
 #include <cassert>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "MemoryUsage.h"
 
 QDataStream& operator<<(QDataStream& s, const AudioLibraryAlbumKey& key)
 {
@@ -48,7 +53,7 @@ AudioLibraryAlbumKey::AudioLibraryAlbumKey(const TrackInfo& info)
     , _year(info.year)
     , _album(info.album)
     , _genre(info.genre)
-    , _cover_checksum(qChecksum(info.cover))
+    , _cover_checksum(info.cover.checksum)
 {
 }
 
@@ -69,66 +74,69 @@ std::strong_ordering AudioLibraryAlbumKey::operator<=>(const AudioLibraryAlbumKe
 
 //=============================================================================
 
-AudioLibraryAlbum::AudioLibraryAlbum(const AudioLibraryAlbumKey& key, const QByteArray& cover, const QSize& cover_size)
+AudioLibraryAlbum::AudioLibraryAlbum(const AudioLibraryAlbumKey& key, const CoverLocation& cover)
     : _key(key)
     , _cover(cover)
-    , _cover_size(cover_size)
+    , _folded_fields({ key.getArtist(), key.getAlbum(), key.getGenre() })
 {
-    _cover_type = getCoverTypeInternal();
 }
 
-void AudioLibraryAlbum::addTrack(const AudioLibraryTrack* track)
+AudioLibraryAlbum::AudioLibraryAlbum(const AudioLibraryAlbum& other, const std::vector<AudioLibraryTrack*>& tracks)
+    : _key(other._key)
+    , _cover(other._cover)
+    , _folded_fields(other._folded_fields)
+    , _search_index_positions(other._search_index_positions)
+    , _tracks(tracks)
+    , _uuid(other._uuid)
 {
-    _tracks.push_back(track);
-
-    // reset the uuid because data has been modified
-    _uuid = QUuid::createUuid();
 }
 
-void AudioLibraryAlbum::removeTrack(const AudioLibraryTrack* track)
+void AudioLibraryAlbum::relocateCover(const QString& filepath)
 {
-    std::erase(_tracks, track);
-
-    // reset the uuid because data has been modified
-    _uuid = QUuid::createUuid();
+    // the picture may be at a different position in the other file, so it has to be extracted from the tags
+    _cover.filepath = filepath;
+    _cover.offset = -1;
 }
 
-template<class ARRAY>
-bool compareSignature(const ARRAY& signature, const QByteArray& bytes)
+void AudioLibraryAlbum::setCoverAndUuid(const CoverLocation& cover, const QUuid& uuid)
 {
-    const size_t signature_size = std::distance(std::begin(signature), std::end(signature));
-
-    return bytes.size() >= static_cast<int>(signature_size) &&
-        memcmp(bytes.constData(), signature, signature_size) == 0;
+    _cover = cover;
+    _uuid = uuid;
 }
 
-QString AudioLibraryAlbum::getCoverTypeInternal() const
+void AudioLibraryAlbum::addTrack(AudioLibraryTrack* track)
 {
-    const uint8_t JPG_SIGNATURE[] = { 0xff, 0xd8 };
-    const uint8_t PNG_SIGNATURE[] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
-    const uint8_t BMP_SIGNATURE[] = { 0x42, 0x4d };
+    track->setAlbumIndex(static_cast<quint32>(_tracks.size()));
+    _tracks.push_back(track);
 
-    if (compareSignature(JPG_SIGNATURE, _cover))
-        return "jpg";
+    // reset the uuid because data has been modified
+    _uuid = QUuid::createUuid();
+}
 
-    if (compareSignature(PNG_SIGNATURE, _cover))
-        return "png";
+void AudioLibraryAlbum::removeTrack(AudioLibraryTrack* track)
+{
+    const quint32 index = track->getAlbumIndex();
+    assert(index < _tracks.size() && _tracks[index] == track);
 
-    if (compareSignature(BMP_SIGNATURE, _cover))
-        return "bmp";
+    AudioLibraryTrack* last_track = _tracks.back();
+    _tracks[index] = last_track;
+    last_track->setAlbumIndex(index);
+    _tracks.pop_back();
 
-    if (!_cover.isEmpty())
-    {
-        return "unknown signature: " + QString::fromLatin1(_cover.left(32).toHex());
-    }
+    // reset the uuid because data has been modified
+    _uuid = QUuid::createUuid();
+}
 
-    return QString();
+size_t AudioLibraryAlbum::getTracksMemoryUsage() const
+{
+    return MemoryUsageCounter::vectorSize(_tracks);
 }
 
 //=============================================================================
 
 AudioLibraryTrack::AudioLibraryTrack(AudioLibraryAlbum* album,
-    const QString& filepath,
+    AudioLibraryDirectory* directory,
+    const QString& filename,
     const QDateTime& last_modified,
     qint64 file_size,
     const QString& artist,
@@ -141,11 +149,13 @@ AudioLibraryTrack::AudioLibraryTrack(AudioLibraryAlbum* album,
     int length_milliseconds,
     int channels,
     int bitrate_kbs,
-    int samplerate_hz)
+    int samplerate_hz,
+    bool audio_properties_estimated)
     : _album(album)
     , _artist(artist)
     , _album_artist(album_artist)
-    , _filepath(filepath)
+    , _directory(directory)
+    , _filename(filename)
     , _last_modified(last_modified)
     , _file_size(file_size)
     , _title(title)
@@ -157,6 +167,8 @@ AudioLibraryTrack::AudioLibraryTrack(AudioLibraryAlbum* album,
     , _channels(channels)
     , _bitrate_kbs(bitrate_kbs)
     , _samplerate_hz(samplerate_hz)
+    , _audio_properties_estimated(audio_properties_estimated)
+    , _folded_fields({ artist, album_artist, title })
 {
 }
 
@@ -168,7 +180,8 @@ bool AudioLibraryTrack::operator==(const AudioLibraryTrack& other) const
             t._album->getCover(),
             t._artist,
             t._album_artist,
-            t._filepath,
+            t._directory->getPath(),
+            t._filename,
             t._last_modified,
             t._file_size,
             t._title,
@@ -179,7 +192,8 @@ bool AudioLibraryTrack::operator==(const AudioLibraryTrack& other) const
             t._length_milliseconds,
             t._channels,
             t._bitrate_kbs,
-            t._samplerate_hz);
+            t._samplerate_hz,
+            t._audio_properties_estimated);
     };
 
     return tie(*this) == tie(other);
@@ -192,28 +206,90 @@ bool AudioLibraryTrack::operator!=(const AudioLibraryTrack& other) const
 
 //=============================================================================
 
+AudioLibrary::AudioLibrary(const AudioLibrary& other)
+    : _is_modified(other._is_modified)
+    , _generation(other.getGeneration())
+{
+    std::unordered_map<const AudioLibraryTrack*, const AudioLibraryTrack*> track_copies;
+    std::unordered_map<const AudioLibraryAlbum*, const AudioLibraryAlbum*> album_copies;
+
+    track_copies.reserve(other._path_to_track_map.size());
+    album_copies.reserve(other._album_map.size());
+    _path_to_track_map.reserve(other._path_to_track_map.size());
+
+    // every track belongs to an album, so copying the albums copies all tracks.
+    // The tracks of an album are usually in the same directory, so the last one is looked up first.
+
+    const AudioLibraryDirectory* other_directory = nullptr;
+    AudioLibraryDirectory* directory = nullptr;
+
+    for (const auto& [key, other_album] : other._album_map)
+    {
+        std::vector<AudioLibraryTrack*> tracks;
+
+        for (const AudioLibraryTrack* other_track : other_album.getTracks())
+        {
+            if (other_track->getDirectory() != other_directory)
+            {
+                other_directory = other_track->getDirectory();
+                directory = _path_tree.addDirectory(other_directory->getPath());
+            }
+
+            AudioLibraryTrack* track = &_path_to_track_map.try_emplace({ directory, other_track->getFilename() }, *other_track).first->second;
+            track->setDirectoryPtr(directory);
+            _path_tree.addTrack(track);
+
+            tracks.push_back(track);
+            track_copies.emplace(other_track, track);
+        }
+
+        // the copied tracks keep their album index, because the order of the tracks is the same
+        AudioLibraryAlbum* album = &_album_map.try_emplace(_album_map.end(), key, other_album, tracks)->second;
+
+        for (AudioLibraryTrack* track : tracks)
+            track->setAlbumPtr(album);
+
+        album_copies.emplace(&other_album, album);
+    }
+
+    _search_index = AudioLibrarySearchIndex(other._search_index, track_copies, album_copies);
+    _track_table = AudioLibraryTrackTable(other._track_table, track_copies);
+}
+
 const AudioLibraryTrack* AudioLibrary::findTrack(const QString& filepath) const
 {
-    auto it = _filepath_to_track_map.find(filepath);
-    if(it != _filepath_to_track_map.end())
-        return it->second.get();
+    const auto [directory_path, filename] = AudioLibraryPathTree::splitPath(filepath);
+
+    const AudioLibraryDirectory* directory = _path_tree.findDirectory(directory_path);
+    if (!directory)
+        return nullptr;
+
+    auto it = _path_to_track_map.find({ directory, filename });
+    if(it != _path_to_track_map.end())
+        return &it->second;
 
     return nullptr;
 }
 
 void AudioLibrary::addTrack(const QString& filepath, const QDateTime& last_modified, qint64 file_size, const TrackInfo& track_info)
 {
+    const auto [directory_path, filename] = AudioLibraryPathTree::splitPath(filepath);
+
+    if (const AudioLibraryDirectory* directory = _path_tree.findDirectory(directory_path))
     {
-        auto it = _filepath_to_track_map.find(filepath);
-        if (it != _filepath_to_track_map.end())
-            removeTrack(it->second.get()); // clean up old stuff
+        auto it = _path_to_track_map.find({ directory, filename });
+        if (it != _path_to_track_map.end())
+            removeTrack(&it->second); // clean up old stuff
     }
 
     AudioLibraryAlbum* album = addAlbum(AudioLibraryAlbumKey(track_info),
                                         track_info.cover);
 
-    addTrack(album,
-        filepath,
+    // the directory is added after removing the old track, which may have removed it
+
+    addTrack(AudioLibraryTrack(album,
+        _path_tree.addDirectory(directory_path),
+        filename,
         last_modified,
         file_size,
         track_info.artist,
@@ -226,52 +302,217 @@ void AudioLibrary::addTrack(const QString& filepath, const QDateTime& last_modif
         track_info.length_milliseconds,
         track_info.channels,
         track_info.bitrate_kbs,
-        track_info.samplerate_hz);
+        track_info.samplerate_hz,
+        track_info.audio_properties_estimated));
 
     _is_modified = true;
 }
 
 void AudioLibrary::removeTrack(AudioLibraryTrack* track)
 {
+    recordChange(track);
+
     {
-        track->getAlbum()->removeTrack(track);
+        AudioLibraryAlbum* album = track->getAlbum();
+        album->removeTrack(track);
+        _search_index.removeTrack(track);
+        _track_table.remove(track->getTableRow());
 
-        if(track->getAlbum()->getTracks().empty())
+        if(album->getTracks().empty())
         {
-            _album_map.erase(track->getAlbum()->getKey());
+            _search_index.removeAlbum(album);
             track->setAlbumPtr(nullptr);
+
+            // the album lives in the map node, so its key can't be used to erase it
+            _album_map.erase(_album_map.find(album->getKey()));
+        }
+        else if(!album->getCover().isEmpty() && album->getCover().filepath == track->getFilepath())
+        {
+            // all tracks of the album have the same cover checksum
+            album->relocateCover(album->getTracks().front()->getFilepath());
         }
 
-        _filepath_to_track_map.erase(track->getFilepath());
+        // the directory may be removed with the track, so the track is looked up before
+
+        auto it = _path_to_track_map.find({ track->getDirectory(), track->getFilename() });
+        _path_tree.removeTrack(track);
+
+        // destroys the track
+        _path_to_track_map.erase(it);
 
         _is_modified = true;
+        ++_generation;
     }
 }
 
+bool AudioLibrary::removeTrack(const QString& filepath)
+{
+    const auto [directory_path, filename] = AudioLibraryPathTree::splitPath(filepath);
+
+    const AudioLibraryDirectory* directory = _path_tree.findDirectory(directory_path);
+    if (!directory)
+        return false;
+
+    auto it = _path_to_track_map.find({ directory, filename });
+    if (it == _path_to_track_map.end())
+        return false;
+
+    removeTrack(&it->second);
+    return true;
+}
+
 void AudioLibrary::removeTracksWithInvalidPaths()
 {
-    std::vector<AudioLibraryTrack*> tracks_to_remove;
+    const std::atomic_bool abort_flag = false;
+
+    for(const QString& filepath : findMissingFiles(std::max(int(std::thread::hardware_concurrency()), 1), abort_flag))
+    {
+        removeTrack(filepath);
+    }
+}
+
+namespace {
+
+    enum class DirectoryState { READABLE, DELETED, UNREACHABLE };
 
-    for(const auto& filepath_and_track : _filepath_to_track_map)
+    DirectoryState getDirectoryState(const QString& directory_path)
     {
-        if(!QFileInfo::exists(filepath_and_track.first))
+        const QFileInfo directory(directory_path);
+        if (directory.isDir())
+            return directory.isReadable() ? DirectoryState::READABLE : DirectoryState::UNREACHABLE;
+
+        // a directory that doesn't exist has been deleted if the nearest directory above it is readable and has entries.
+        // Otherwise it may be on a drive or share that isn't mounted, whose mount point is missing or empty.
+
+        for (QString path = directory_path, parent_path = QFileInfo(path).path(); parent_path != path; path = parent_path, parent_path = QFileInfo(path).path())
         {
-            tracks_to_remove.push_back(filepath_and_track.second.get());
+            const QFileInfo parent(parent_path);
+            if (!parent.isDir())
+                continue;
+
+            const bool has_entries = parent.isReadable() && !QDir(parent_path).isEmpty(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+            return has_entries ? DirectoryState::DELETED : DirectoryState::UNREACHABLE;
         }
+
+        return DirectoryState::UNREACHABLE;
     }
+}
+
+std::vector<QString> AudioLibrary::findMissingFiles(int thread_count, const std::atomic_bool& abort_flag) const
+{
+    // below this number of tracks, looking up the files is cheaper than listing the directory
+    const size_t MIN_TRACKS_FOR_LISTING = 4;
+
+    std::vector<const AudioLibraryDirectory*> directories = _path_tree.getDirectories();
+    directories.push_back(_path_tree.getRoot());
+
+    std::erase_if(directories, [](const AudioLibraryDirectory* directory) { return directory->getTracks().empty(); });
+
+    std::vector<QString> missing_files;
+    std::mutex missing_files_mutex;
+    std::atomic_size_t next_directory_index = 0;
+
+    auto checkDirectories = [&]() {
+        std::vector<QString> missing_files_of_thread;
+
+        for (size_t i = next_directory_index++; i < directories.size() && !abort_flag; i = next_directory_index++)
+        {
+            const std::span<const AudioLibraryTrack* const> tracks = directories[i]->getTracks();
+
+            // the path is cleaned, so the root directory of relative paths is the current directory
+            const QString directory_path = QDir(directories[i]->getPath()).path();
+
+            // files that can't be found in a directory that can't be reached aren't missing, the drive may only be unmounted
+
+            if (tracks.size() < MIN_TRACKS_FOR_LISTING)
+            {
+                std::vector<QString> missing_files_of_directory;
+
+                for (const AudioLibraryTrack* track : tracks)
+                    if (!QFileInfo::exists(track->getFilepath()))
+                        missing_files_of_directory.push_back(track->getFilepath());
+
+                if (!missing_files_of_directory.empty() && getDirectoryState(directory_path) != DirectoryState::UNREACHABLE)
+                    missing_files_of_thread.insert(missing_files_of_thread.end(), missing_files_of_directory.begin(), missing_files_of_directory.end());
+
+                continue;
+            }
+
+            DirectoryState state = getDirectoryState(directory_path);
+
+            std::unordered_set<QString> existing_filenames;
+
+            if (state == DirectoryState::READABLE)
+            {
+                const QStringList filenames = QDir(directory_path).entryList(QDir::Files | QDir::Hidden, QDir::NoSort);
+                existing_filenames.insert(filenames.begin(), filenames.end());
 
-    for(AudioLibraryTrack* track : tracks_to_remove)
+                // listing a directory that has become unreachable in the meantime returns no entries as well
+                if (existing_filenames.empty())
+                    state = getDirectoryState(directory_path);
+            }
+
+            if (state == DirectoryState::UNREACHABLE)
+                continue;
+
+            for (const AudioLibraryTrack* track : tracks)
+                if (!existing_filenames.contains(track->getFilename()))
+                    missing_files_of_thread.push_back(track->getFilepath());
+        }
+
+        std::lock_guard lock(missing_files_mutex);
+        missing_files.insert(missing_files.end(), missing_files_of_thread.begin(), missing_files_of_thread.end());
+    };
+
+    // the threads mostly wait for the file system, there is no use in more threads than directories
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1, end = std::min(size_t(std::max(thread_count, 1)), directories.size()); i < end; ++i)
+        threads.emplace_back(checkDirectories);
+
+    checkDirectories();
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return missing_files;
+}
+
+namespace {
+
+    QString toDirectoryPath(const QString& path)
     {
-        removeTrack(track);
+        return path.isEmpty() || path.endsWith(QLatin1Char('/')) ? path : path + QLatin1Char('/');
     }
 }
 
+std::vector<const AudioLibraryTrack*> AudioLibrary::findTracksInDirectory(const QString& directory_path) const
+{
+    std::vector<const AudioLibraryTrack*> tracks;
+
+    if (const AudioLibraryDirectory* directory = _path_tree.findDirectory(toDirectoryPath(directory_path)))
+        _path_tree.getTracks(directory, tracks);
+
+    return tracks;
+}
+
+void AudioLibrary::removeTracksInDirectory(const QString& directory_path)
+{
+    std::vector<AudioLibraryTrack*> tracks_to_remove;
+
+    if (const AudioLibraryDirectory* directory = _path_tree.findDirectory(toDirectoryPath(directory_path)))
+        _path_tree.getTracks(directory, tracks_to_remove);
+
+    for (AudioLibraryTrack* track : tracks_to_remove)
+        removeTrack(track);
+}
+
 std::vector<const AudioLibraryAlbum*> AudioLibrary::getAlbums() const
 {
     std::vector<const AudioLibraryAlbum*> result;
 
     for (const auto& album : _album_map)
-        result.push_back(album.second.get());
+        result.push_back(&album.second);
 
     return result;
 }
@@ -280,7 +521,7 @@ const AudioLibraryAlbum* AudioLibrary::getAlbum(const AudioLibraryAlbumKey& key)
 {
     auto it = _album_map.find(key);
     if (it != _album_map.end())
-        return it->second.get();
+        return &it->second;
 
     return nullptr;
 }
@@ -289,14 +530,29 @@ AudioLibraryAlbum* AudioLibrary::getAlbum(const AudioLibraryAlbumKey& key)
 {
     auto it = _album_map.find(key);
     if (it != _album_map.end())
-        return it->second.get();
+        return &it->second;
 
     return nullptr;
 }
 
 size_t AudioLibrary::getNumberOfTracks() const
 {
-    return _filepath_to_track_map.size();
+    return _path_to_track_map.size();
+}
+
+const AudioLibrarySearchIndex& AudioLibrary::getSearchIndex() const
+{
+    return _search_index;
+}
+
+const AudioLibraryTrackTable& AudioLibrary::getTrackTable() const
+{
+    return _track_table;
+}
+
+const AudioLibraryPathTree& AudioLibrary::getPathTree() const
+{
+    return _path_tree;
 }
 
 bool AudioLibrary::isModified() const
@@ -304,15 +560,142 @@ bool AudioLibrary::isModified() const
     return _is_modified;
 }
 
+quint64 AudioLibrary::getGeneration() const
+{
+    return _generation;
+}
+
+AudioLibrary::MemoryUsage AudioLibrary::getMemoryUsage() const
+{
+    MemoryUsageCounter counter;
+    MemoryUsage usage;
+
+    // the tracks and albums are stored in the nodes of the maps, but they are counted on their own
+
+    usage.maps = MemoryUsageCounter::treeMapSize(_album_map) - _album_map.size() * sizeof(AudioLibraryAlbum) +
+        MemoryUsageCounter::hashMapSize(_path_to_track_map) - _path_to_track_map.size() * sizeof(AudioLibraryTrack);
+
+    for (const auto& path_and_track : _path_to_track_map)
+    {
+        const AudioLibraryTrack* track = &path_and_track.second;
+
+        usage.tracks += sizeof(AudioLibraryTrack);
+        usage.strings += counter.addString(path_and_track.first.filename);
+        usage.strings += counter.addString(track->getFilename());
+        usage.strings += counter.addString(track->getArtist());
+        usage.strings += counter.addString(track->getAlbumArtist());
+        usage.strings += counter.addString(track->getTitle());
+        usage.strings += counter.addString(track->getComment());
+        usage.strings += counter.addString(track->getTagTypes());
+        usage.strings += counter.addString(track->getFoldedFields());
+    }
+
+    for (const auto& key_and_album : _album_map)
+    {
+        const AudioLibraryAlbum* album = &key_and_album.second;
+        const AudioLibraryAlbumKey& key = album->getKey();
+
+        usage.albums += sizeof(AudioLibraryAlbum) - sizeof(CoverLocation) + album->getTracksMemoryUsage();
+        usage.strings += counter.addString(key.getArtist());
+        usage.strings += counter.addString(key.getAlbum());
+        usage.strings += counter.addString(key.getGenre());
+        usage.strings += counter.addString(album->getFoldedFields());
+
+        usage.covers += sizeof(CoverLocation);
+        usage.covers += counter.addString(album->getCover().filepath);
+        usage.covers += counter.addString(album->getCover().format);
+    }
+
+    usage.tracks += _track_table.getMemoryUsage(counter);
+    usage.maps += _path_tree.getMemoryUsage(counter);
+    usage.search_index = _search_index.getMemoryUsage(counter);
+
+    return usage;
+}
+
+void AudioLibrary::enableChangeTracking()
+{
+    _is_tracking_changes = true;
+}
+
+AudioLibrary::Changes AudioLibrary::takeChanges()
+{
+    Changes changes;
+    changes.is_cleared = std::exchange(_is_cleared_since_last_changes, false);
+    changes.tracks.reserve(_changed_track_paths.size());
+
+    // a track that was changed several times is only copied in its last state
+
+    for (const QString& filepath : _changed_track_paths)
+    {
+        Changes::TrackChange& change = changes.tracks.emplace_back();
+        change.filepath = filepath;
+
+        if (const AudioLibraryTrack* track = findTrack(filepath))
+        {
+            change.track.emplace(*track);
+            change.track->setAlbumPtr(nullptr);
+            change.track->setDirectoryPtr(nullptr);
+            change.album_key = track->getAlbum()->getKey();
+        }
+    }
+
+    for (const AudioLibraryAlbumKey& key : _changed_album_keys)
+    {
+        if (const AudioLibraryAlbum* album = getAlbum(key))
+            changes.albums.push_back({ key, album->getCover(), album->getUuid() });
+    }
+
+    _changed_track_paths.clear();
+    _changed_album_keys.clear();
+
+    changes.is_modified = _is_modified;
+    changes.generation = getGeneration();
+
+    return changes;
+}
+
+void AudioLibrary::applyChanges(const Changes& changes)
+{
+    if (changes.is_cleared)
+        clear();
+
+    // a changed track is replaced as a whole, removing it also removes an album or directory that became empty
+
+    for (const Changes::TrackChange& change : changes.tracks)
+    {
+        removeTrack(change.filepath);
+
+        if (!change.track)
+            continue;
+
+        AudioLibraryTrack track = *change.track;
+        track.setAlbumPtr(addAlbum(change.album_key, CoverLocation()));
+        track.setDirectoryPtr(_path_tree.addDirectory(AudioLibraryPathTree::splitPath(change.filepath).first));
+        addTrack(std::move(track));
+    }
+
+    // adding and removing the tracks reset the uuids of their albums, and may have relocated their covers
+
+    for (const Changes::AlbumChange& change : changes.albums)
+    {
+        if (AudioLibraryAlbum* album = getAlbum(change.key))
+            album->setCoverAndUuid(change.cover, change.uuid);
+    }
+
+    _is_modified = changes.is_modified;
+    _generation = changes.generation;
+}
+
 void AudioLibrary::removeTracksExcept(const std::unordered_set<QString>& loaded_audio_files)
 {
-    for (auto it = _filepath_to_track_map.begin(), end = _filepath_to_track_map.end(); it != end;)
+    for (auto it = _path_to_track_map.begin(), end = _path_to_track_map.end(); it != end;)
     {
-        if (!loaded_audio_files.contains(it->first))
+        if (!loaded_audio_files.contains(it->second.getFilepath()))
         {
             // track is not one of the loaded files, must be outdated
 
-            AudioLibraryTrack* track = it->second.get();
+            AudioLibraryTrack* track = &it->second;
             ++it;
             removeTrack(track);
         }
@@ -325,21 +708,45 @@ void AudioLibrary::removeTracksExcept(const std::unordered_set<QString>& loaded_
 
 void AudioLibrary::save(QDataStream& s) const
 {
-    s << qint32(7); // version
+    s << qint32(11); // version
 
-    s << quint64(_album_map.size());
+    // the directories come first, each one as the index of its parent and the rest of its path,
+    // so the tracks only need the index of their directory and their file name. The root has index 0.
+
+    const std::vector<const AudioLibraryDirectory*> directories = _path_tree.getDirectories();
+
+    std::unordered_map<const AudioLibraryDirectory*, quint32> directory_indices;
+    directory_indices.reserve(directories.size() + 1);
+    directory_indices.emplace(_path_tree.getRoot(), 0);
 
-    for (const auto& i : _album_map)
+    s << quint64(directories.size());
+
+    for (const AudioLibraryDirectory* directory : directories)
     {
-        s << i.second->getKey();
-        s << i.second->getCover();
-        s << i.second->getCoverSize();
+        const AudioLibraryDirectory* parent = directory->getParent();
+
+        s << directory_indices.at(parent);
+        s << directory->getPath().mid(parent->getPath().size());
 
-        s << quint64(i.second->getTracks().size());
+        directory_indices.emplace(directory, static_cast<quint32>(directory_indices.size()));
+    }
+
+    auto saveAlbum = [&directory_indices](QDataStream& s, const AudioLibraryAlbum& album) {
+        s << album.getKey();
+        const CoverLocation& cover = album.getCover();
+        s << cover.filepath;
+        s << cover.offset;
+        s << cover.data_size;
+        s << cover.checksum;
+        s << cover.format;
+        s << cover.image_size;
+
+        s << quint64(album.getTracks().size());
 
-        for(const AudioLibraryTrack* track : i.second->getTracks())
+        for(const AudioLibraryTrack* track : album.getTracks())
         {
-            s << track->getFilepath();
+            s << directory_indices.at(track->getDirectory());
+            s << track->getFilename();
             s << track->getLastModified();
             s << track->getFileSize();
             s << track->getArtist();
@@ -353,7 +760,31 @@ void AudioLibrary::save(QDataStream& s) const
             s << qint32(track->getChannels());
             s << qint32(track->getBitrateKbs());
             s << qint32(track->getSampleRateHz());
+            s << track->areAudioPropertiesEstimated();
         }
+    };
+
+    // the albums are written in blocks, each one with its number of albums and its size in bytes,
+    // so the loader can pass a block to a thread without decoding the blocks before it
+
+    const quint64 ALBUMS_PER_BLOCK = 64;
+
+    s << quint64(_album_map.size());
+    s << quint64((_album_map.size() + ALBUMS_PER_BLOCK - 1) / ALBUMS_PER_BLOCK);
+
+    auto it = _album_map.begin();
+    while (it != _album_map.end())
+    {
+        QByteArray block;
+        QDataStream block_stream(&block, QIODevice::WriteOnly);
+        block_stream.setVersion(s.version());
+
+        quint64 albums_in_block = 0;
+        for (; it != _album_map.end() && albums_in_block < ALBUMS_PER_BLOCK; ++it, ++albums_in_block)
+            saveAlbum(block_stream, it->second);
+
+        s << albums_in_block;
+        s << block;
     }
 }
 
@@ -361,27 +792,122 @@ void AudioLibrary::load(QDataStream& s)
 {
     Loader loader;
 
-    loader.init(*this, s);
+    loader.init(*this, s, std::max(int(std::thread::hardware_concurrency()), 1));
     while (loader.hasNextAlbum())
         loader.loadNextAlbum(*this);
 }
 
-void AudioLibrary::Loader::init(AudioLibrary& library, QDataStream& s)
+AudioLibrary::Loader::~Loader()
+{
+    {
+        std::lock_guard lock(_blocks_mutex);
+        _abort = true;
+    }
+
+    _block_state_changed.notify_all();
+
+    for (std::thread& thread : _threads)
+        thread.join();
+}
+
+void AudioLibrary::Loader::init(AudioLibrary& library, QDataStream& s, int thread_count)
 {
     _s = &s;
 
-    library._album_map.clear();
-    library._filepath_to_track_map.clear();
-    library._is_modified = false;
+    library.clear();
 
     // for simplicity's sake, don't try to migrate old cache versions
 
     qint32 version;
     s >> version;
-    if (version != 7)
+    if (version != 11)
+        return;
+
+    quint64 num_directories;
+    s >> num_directories;
+
+    _directory_paths.assign(1, QString());
+
+    for (quint64 i = 0; i < num_directories && s.status() == QDataStream::Ok; ++i)
+    {
+        quint32 parent_index;
+        QString name;
+
+        s >> parent_index;
+        s >> name;
+
+        // parents come before their children
+        if (parent_index >= _directory_paths.size())
+            return;
+
+        _directory_paths.push_back(_directory_paths[parent_index] + name);
+    }
+
+    _directories.assign(_directory_paths.size(), nullptr);
+
+    quint64 num_albums;
+    quint64 num_blocks;
+    s >> num_albums;
+    s >> num_blocks;
+
+    // each block takes at least the size of its number of albums, a damaged count must not allocate the memory for it
+    if (s.status() != QDataStream::Ok || num_blocks > num_albums || !s.device() || num_blocks > quint64(s.device()->bytesAvailable()) / sizeof(quint64))
         return;
 
-    s >> _num_albums;
+    _num_albums = num_albums;
+    _blocks = std::vector<Block>(num_blocks);
+
+    if (_blocks.empty())
+        return;
+
+    // enough to keep the threads busy while the albums of the current block are added
+    const size_t READ_AHEAD_BLOCKS_PER_THREAD = 4;
+
+    const size_t num_decoding_threads = std::min(size_t(std::max(thread_count, 1)), _blocks.size());
+    _max_blocks_read_ahead = READ_AHEAD_BLOCKS_PER_THREAD * num_decoding_threads;
+
+    _threads.emplace_back([this]() { readBlocks(); });
+
+    for (size_t i = 0; i < num_decoding_threads; ++i)
+        _threads.emplace_back([this]() { decodeBlocks(); });
+}
+
+void AudioLibrary::Loader::readBlocks()
+{
+    for (size_t i = 0; i < _blocks.size(); ++i)
+    {
+        Block& block = _blocks[i];
+
+        {
+            std::unique_lock lock(_blocks_mutex);
+            _block_state_changed.wait(lock, [this, i]() { return i < _block_index + _max_blocks_read_ahead || _abort; });
+
+            if (_abort)
+                return;
+        }
+
+        quint64 num_albums = 0;
+        QByteArray data;
+
+        // a damaged stream leaves the remaining blocks empty
+        if (_s->status() == QDataStream::Ok)
+        {
+            *_s >> num_albums;
+            *_s >> data;
+
+            if (_s->status() != QDataStream::Ok)
+                num_albums = 0;
+        }
+
+        {
+            std::lock_guard lock(_blocks_mutex);
+            block.num_albums = num_albums;
+            block.data = std::move(data);
+            block.is_read = true;
+        }
+
+        _block_state_changed.notify_all();
+    }
 }
 
 bool AudioLibrary::Loader::hasNextAlbum() const
@@ -389,24 +915,145 @@ bool AudioLibrary::Loader::hasNextAlbum() const
     return _albums_loaded < _num_albums;
 }
 
+void AudioLibrary::Loader::waitForNextAlbum()
+{
+    // a damaged block may have fewer albums than announced
+
+    while (_block_index < _blocks.size())
+    {
+        Block& block = _blocks[_block_index];
+
+        {
+            std::unique_lock lock(_blocks_mutex);
+            _block_state_changed.wait(lock, [&block]() { return block.is_decoded; });
+        }
+
+        if (_album_in_block < block.albums.size())
+            break;
+
+        block.albums.clear();
+        block.albums.shrink_to_fit();
+        _album_in_block = 0;
+
+        // makes room for the next block to be read
+
+        {
+            std::lock_guard lock(_blocks_mutex);
+            ++_block_index;
+        }
+
+        _block_state_changed.notify_all();
+    }
+
+    if (_block_index == _blocks.size())
+        _albums_loaded = _num_albums;
+}
+
 void AudioLibrary::Loader::loadNextAlbum(AudioLibrary& library)
+{
+    waitForNextAlbum();
+
+    if (_block_index == _blocks.size())
+        return;
+
+    DecodedAlbum& decoded_album = _blocks[_block_index].albums[_album_in_block++];
+
+    AudioLibraryAlbum* album = library.addAlbum(std::move(decoded_album.album));
+
+    for (auto& [directory_index, track] : decoded_album.tracks)
+    {
+        if (directory_index >= _directories.size())
+            continue;
+
+        AudioLibraryDirectory*& directory = _directories[directory_index];
+        if (!directory)
+            directory = library._path_tree.addDirectory(_directory_paths[directory_index]);
+
+        track.setAlbumPtr(album);
+        track.setDirectoryPtr(directory);
+        library.addTrack(std::move(track));
+    }
+
+    // an album whose tracks were all rejected, e.g. because another album has their paths, isn't kept empty
+
+    if (album->getTracks().empty())
+    {
+        library._search_index.removeAlbum(album);
+
+        // the album lives in the map node, so its key can't be used to erase it
+        library._album_map.erase(library._album_map.find(album->getKey()));
+    }
+
+    decoded_album.tracks.clear();
+    decoded_album.tracks.shrink_to_fit();
+
+    ++_albums_loaded;
+}
+
+void AudioLibrary::Loader::decodeBlocks()
+{
+    for (size_t i = _next_block_to_decode++; i < _blocks.size(); i = _next_block_to_decode++)
+    {
+        Block& block = _blocks[i];
+
+        {
+            std::unique_lock lock(_blocks_mutex);
+            _block_state_changed.wait(lock, [this, &block]() { return block.is_read || _abort; });
+
+            if (_abort)
+                return;
+        }
+
+        QDataStream s(block.data);
+        s.setVersion(_s->version());
+
+        std::vector<DecodedAlbum> albums;
+        std::set<std::pair<quint32, QString>> paths_in_block;
+
+        for (quint64 a = 0; a < block.num_albums; ++a)
+        {
+            DecodedAlbum album = decodeAlbum(s, paths_in_block);
+            if (s.status() != QDataStream::Ok)
+                break;
+
+            albums.push_back(std::move(album));
+        }
+
+        {
+            std::lock_guard lock(_blocks_mutex);
+            block.data = QByteArray();
+            block.albums = std::move(albums);
+            block.is_decoded = true;
+        }
+
+        _block_state_changed.notify_all();
+    }
+}
+
+AudioLibrary::Loader::DecodedAlbum AudioLibrary::Loader::decodeAlbum(QDataStream& s, std::set<std::pair<quint32, QString>>& paths_in_block)
 {
     AudioLibraryAlbumKey key;
-    QByteArray cover;
-    QSize cover_size;
+    CoverLocation cover;
+
+    s >> key;
+    s >> cover.filepath;
+    s >> cover.offset;
+    s >> cover.data_size;
+    s >> cover.checksum;
+    s >> cover.format;
+    s >> cover.image_size;
 
-    *_s >> key;
-    *_s >> cover;
-    *_s >> cover_size;
+    // the album and the tracks fold their strings for the search here, on the decoding thread
 
-    AudioLibraryAlbum* album = library.addAlbum(key, cover, cover_size);
+    DecodedAlbum decoded_album = { AudioLibraryAlbum(key, cover), {} };
 
     quint64 num_tracks;
-    *_s >> num_tracks;
+    s >> num_tracks;
 
-    for (quint64 ti = 0; ti < num_tracks; ++ti)
+    for (quint64 ti = 0; ti < num_tracks && s.status() == QDataStream::Ok; ++ti)
     {
-        QString filepath;
+        quint32 directory_index;
+        QString filename;
         QDateTime last_modified;
         qint64 file_size;
         QString artist;
@@ -420,93 +1067,111 @@ void AudioLibrary::Loader::loadNextAlbum(AudioLibrary& library)
         qint32 channels;
         qint32 bitrate_kbs;
         qint32 samplerate_hz;
-
-        *_s >> filepath;
-        *_s >> last_modified;
-        *_s >> file_size;
-        *_s >> artist;
-        *_s >> album_artist;
-        *_s >> title;
-        *_s >> track_number;
-        *_s >> disc_number;
-        *_s >> comment;
-        *_s >> tag_types;
-        *_s >> length_milliseconds;
-        *_s >> channels;
-        *_s >> bitrate_kbs;
-        *_s >> samplerate_hz;
-
-        library.addTrack(album, filepath, last_modified, file_size, artist, album_artist, title, track_number, disc_number, comment, tag_types, length_milliseconds, channels, bitrate_kbs, samplerate_hz);
+        bool audio_properties_estimated;
+
+        s >> directory_index;
+        s >> filename;
+        s >> last_modified;
+        s >> file_size;
+        s >> artist;
+        s >> album_artist;
+        s >> title;
+        s >> track_number;
+        s >> disc_number;
+        s >> comment;
+        s >> tag_types;
+        s >> length_milliseconds;
+        s >> channels;
+        s >> bitrate_kbs;
+        s >> samplerate_hz;
+        s >> audio_properties_estimated;
+
+        // a path that is in the block twice only keeps its first track, the library checks the paths of other blocks
+        if (!paths_in_block.emplace(directory_index, filename).second)
+            continue;
+
+        decoded_album.tracks.emplace_back(directory_index, AudioLibraryTrack(nullptr, nullptr, filename, last_modified, file_size, artist, album_artist, title, track_number, disc_number, comment, tag_types, length_milliseconds, channels, bitrate_kbs, samplerate_hz, audio_properties_estimated));
     }
 
-    ++_albums_loaded;
+    return decoded_album;
 }
 
-AudioLibraryAlbum* AudioLibrary::addAlbum(const AudioLibraryAlbumKey& album_key, const QByteArray& cover)
+void AudioLibrary::clear()
 {
-    auto it = _album_map.find(album_key);
-    if (it == _album_map.end())
-    {
-        QPixmap cover_pixmap;
-        cover_pixmap.loadFromData(cover);
+    // the nodes go back to the pool, which keeps the memory for the albums that are added next
 
-        it = _album_map.insert(make_pair(album_key, std::make_unique<AudioLibraryAlbum>(album_key, cover, cover_pixmap.size()))).first;
-    }
+    _album_map.clear();
+    _path_to_track_map.clear();
+    _path_tree.clear();
+    _search_index.clear();
+    _track_table.clear();
+    _is_modified = false;
+    ++_generation;
 
-    return it->second.get();
+    if (_is_tracking_changes)
+    {
+        // the earlier changes don't matter anymore
+        _is_cleared_since_last_changes = true;
+        _changed_track_paths.clear();
+        _changed_album_keys.clear();
+    }
 }
 
-AudioLibraryAlbum* AudioLibrary::addAlbum(const AudioLibraryAlbumKey& album_key, const QByteArray& cover, const QSize& cover_size)
+AudioLibraryAlbum* AudioLibrary::addAlbum(const AudioLibraryAlbumKey& album_key, const CoverLocation& cover)
 {
     auto it = _album_map.find(album_key);
     if (it == _album_map.end())
     {
-        it = _album_map.insert(make_pair(album_key, std::make_unique<AudioLibraryAlbum>(album_key, cover, cover_size))).first;
+        it = _album_map.try_emplace(album_key, album_key, cover).first;
+        _search_index.addAlbum(&it->second);
     }
 
-    return it->second.get();
+    return &it->second;
 }
 
-AudioLibraryTrack* AudioLibrary::addTrack(AudioLibraryAlbum* album,
-    const QString& filepath,
-    const QDateTime& last_modified,
-    qint64 file_size,
-    const QString& artist,
-    const QString& album_artist,
-    const QString& title,
-    int track_number,
-    int disc_number,
-    const QString& comment,
-    const QString& tag_types,
-    int length_milliseconds,
-    int channels,
-    int bitrate_kbs,
-    int samplerate_hz)
+AudioLibraryAlbum* AudioLibrary::addAlbum(AudioLibraryAlbum&& album)
 {
-    auto it = _filepath_to_track_map.find(filepath);
-    if (it != _filepath_to_track_map.end())
+    auto it = _album_map.find(album.getKey());
+    if (it == _album_map.end())
     {
-        // file already added, shouldn't happen
-        assert(false);
+        const AudioLibraryAlbumKey key = album.getKey();
+        it = _album_map.try_emplace(key, std::move(album)).first;
+        _search_index.addAlbum(&it->second);
     }
 
-    it = _filepath_to_track_map.insert(make_pair(filepath, std::make_unique<AudioLibraryTrack>(
-        album,
-        filepath,
-        last_modified,
-        file_size,
-        artist,
-        album_artist,
-        title,
-        track_number,
-        disc_number,
-        comment,
-        tag_types,
-        length_milliseconds,
-        channels,
-        bitrate_kbs,
-        samplerate_hz))).first;
-    album->addTrack(it->second.get());
-
-    return it->second.get();
+    return &it->second;
+}
+
+AudioLibraryTrack* AudioLibrary::addTrack(AudioLibraryTrack&& track)
+{
+    const AudioLibraryTrackPath path = { track.getDirectory(), track.getFilename() };
+
+    // a damaged cache may have a path twice. Registering the existing track again would leave
+    // a dangling pointer behind when it's removed, so it's kept as it is.
+
+    auto it = _path_to_track_map.find(path);
+    if (it != _path_to_track_map.end())
+        return &it->second;
+
+    it = _path_to_track_map.try_emplace(path, std::move(track)).first;
+
+    AudioLibraryTrack* added_track = &it->second;
+    added_track->getAlbum()->addTrack(added_track);
+    _path_tree.addTrack(added_track);
+    _search_index.addTrack(added_track);
+    added_track->setTableRow(_track_table.add(added_track));
+    ++_generation;
+
+    recordChange(added_track);
+
+    return added_track;
+}
+
+void AudioLibrary::recordChange(const AudioLibraryTrack* track)
+{
+    if (!_is_tracking_changes)
+        return;
+
+    _changed_track_paths.insert(track->getFilepath());
+    _changed_album_keys.insert(track->getAlbum()->getKey());
 }
\ No newline at end of file
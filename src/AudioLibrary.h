@@ -1,10 +1,17 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
 #include <set>
+#include <span>
+#include <thread>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
@@ -15,6 +22,9 @@
 #include <QtCore/qstring.h>
 #include <QtCore/QUuid>
 #include <QtGui/qpixmap.h>
+#include "AudioLibraryPathTree.h"
+#include "AudioLibrarySearchIndex.h"
+#include "AudioLibraryTrackTable.h"
 #include "TrackInfoReader.h"
 
 class AudioLibraryTrack;
@@ -73,39 +83,68 @@ private:
 class AudioLibraryAlbum
 {
 public:
-    AudioLibraryAlbum(const AudioLibraryAlbumKey& key, const QByteArray& cover, const QSize& cover_size);
+    AudioLibraryAlbum(const AudioLibraryAlbumKey& key, const CoverLocation& cover);
+
+    /**
+    * Copy with the same uuid, but with other tracks.
+    */
+    AudioLibraryAlbum(const AudioLibraryAlbum& other, const std::vector<AudioLibraryTrack*>& tracks);
 
     const AudioLibraryAlbumKey& getKey() const { return _key; }
-    const QByteArray& getCover() const { return _cover; }
-    const QSize& getCoverSize() const { return _cover_size; }
+    const CoverLocation& getCover() const { return _cover; }
+    const QSize& getCoverSize() const { return _cover.image_size; }
 
     const QUuid& getUuid() const { return _uuid; }
 
-    const QString& getCoverType() const { return _cover_type; }
+    const QString& getCoverType() const { return _cover.format; }
+
+    QStringView getFoldedText(AudioLibrarySearchIndex::AlbumField field) const { return _folded_fields.get(field); }
+    const QString& getFoldedFields() const { return _folded_fields.getText(); }
+
+    /**
+    * The position in the entry of each field in the search index, so the album can be removed in constant time.
+    * The index only holds const pointers, and the positions don't change the album.
+    */
+    quint32 getSearchIndexPosition(AudioLibrarySearchIndex::AlbumField field) const { return _search_index_positions[size_t(field)]; }
+    void setSearchIndexPosition(AudioLibrarySearchIndex::AlbumField field, quint32 position) const { _search_index_positions[size_t(field)] = position; }
+
+    /**
+    * Points the cover to another file with the same picture, e.g. when the original file is removed from the library.
+    */
+    void relocateCover(const QString& filepath);
+
+    /**
+    * Takes over the state of the same album in another library, see AudioLibrary::applyChanges.
+    */
+    void setCoverAndUuid(const CoverLocation& cover, const QUuid& uuid);
+
+    /**
+    * The tracks remember their position in the album, so they can be removed in constant time.
+    * Removing a track moves the last track into its place, so the order of the tracks is not preserved.
+    */
+    void addTrack(AudioLibraryTrack* track);
+    void removeTrack(AudioLibraryTrack* track);
+    std::span<const AudioLibraryTrack* const> getTracks() const { return { _tracks.data(), _tracks.size() }; }
 
-    void addTrack(const AudioLibraryTrack* track);
-    void removeTrack(const AudioLibraryTrack* track);
-    const std::vector<const AudioLibraryTrack*>& getTracks() const { return _tracks; }
+    size_t getTracksMemoryUsage() const;
 
 private:
-    QString getCoverTypeInternal() const;
-
     AudioLibraryAlbumKey _key;
-    QByteArray _cover;
-    QSize _cover_size;
+    CoverLocation _cover;
+    FoldedFields<AudioLibrarySearchIndex::AlbumField, 3> _folded_fields;
+    mutable std::array<quint32, 3> _search_index_positions = {};
 
-    std::vector<const AudioLibraryTrack*> _tracks;
+    std::vector<AudioLibraryTrack*> _tracks;
 
     QUuid _uuid = QUuid::createUuid();
-
-    QString _cover_type;
 };
 
 class AudioLibraryTrack
 {
 public:
     AudioLibraryTrack(AudioLibraryAlbum* album,
-        const QString& filepath,
+        AudioLibraryDirectory* directory,
+        const QString& filename,
         const QDateTime& last_modified,
         qint64 file_size,
         const QString& artist,
@@ -118,7 +157,8 @@ public:
         int length_milliseconds,
         int channels,
         int bitrate_kbs,
-        int samplerate_hz);
+        int samplerate_hz,
+        bool audio_properties_estimated);
 
     bool operator==(const AudioLibraryTrack& other) const;
     bool operator!=(const AudioLibraryTrack& other) const;
@@ -126,7 +166,9 @@ public:
     const AudioLibraryAlbum* getAlbum() const { return _album; }
     const QString& getArtist() const { return _artist; }
     const QString& getAlbumArtist() const { return _album_artist; }
-    const QString& getFilepath() const { return _filepath; }
+    const AudioLibraryDirectory* getDirectory() const { return _directory; }
+    const QString& getFilename() const { return _filename; }
+    QString getFilepath() const { return _directory->getPath() + _filename; }
     const QDateTime& getLastModified() const { return _last_modified; }
     qint64 getFileSize() const { return _file_size; }
     const QString& getTitle() const { return _title; }
@@ -138,17 +180,40 @@ public:
     int getChannels() const { return _channels; }
     int getBitrateKbs() const { return _bitrate_kbs; }
     int getSampleRateHz() const { return _samplerate_hz; }
+    bool areAudioPropertiesEstimated() const { return _audio_properties_estimated; }
 
     const QUuid& getUuid() const { return _uuid; }
 
+    QStringView getFoldedText(AudioLibrarySearchIndex::TrackField field) const { return _folded_fields.get(field); }
+    const QString& getFoldedFields() const { return _folded_fields.getText(); }
+
+    /**
+    * See AudioLibraryAlbum::getSearchIndexPosition.
+    */
+    quint32 getSearchIndexPosition(AudioLibrarySearchIndex::TrackField field) const { return _search_index_positions[size_t(field)]; }
+    void setSearchIndexPosition(AudioLibrarySearchIndex::TrackField field, quint32 position) const { _search_index_positions[size_t(field)] = position; }
+
     AudioLibraryAlbum* getAlbum() { return _album; }
     void setAlbumPtr(AudioLibraryAlbum* album) { _album = album; }
 
+    AudioLibraryDirectory* getDirectory() { return _directory; }
+    void setDirectoryPtr(AudioLibraryDirectory* directory) { _directory = directory; }
+
+    quint32 getTableRow() const { return _table_row; }
+    void setTableRow(quint32 row) { _table_row = row; }
+
+    quint32 getAlbumIndex() const { return _album_index; }
+    void setAlbumIndex(quint32 index) { _album_index = index; }
+
+    quint32 getDirectoryIndex() const { return _directory_index; }
+    void setDirectoryIndex(quint32 index) { _directory_index = index; }
+
 private:
     AudioLibraryAlbum* _album = nullptr;
     QString _artist;
     QString _album_artist;
-    QString _filepath;
+    AudioLibraryDirectory* _directory = nullptr;
+    QString _filename;
     QDateTime _last_modified;
     qint64 _file_size;
     QString _title;
@@ -160,6 +225,12 @@ private:
     int _channels;
     int _bitrate_kbs;
     int _samplerate_hz;
+    bool _audio_properties_estimated;
+    FoldedFields<AudioLibrarySearchIndex::TrackField, 3> _folded_fields;
+    mutable std::array<quint32, 3> _search_index_positions = {};
+    quint32 _table_row = 0;
+    quint32 _album_index = 0;
+    quint32 _directory_index = 0;
 
     const QUuid _uuid = QUuid::createUuid();
 };
@@ -167,57 +238,223 @@ private:
 class AudioLibrary
 {
 public:
+    /**
+    * Approximate memory in bytes, see MemoryUsageCounter.
+    */
+    struct MemoryUsage
+    {
+        size_t covers = 0;  //!< cover locations, the picture data is not held in memory
+        size_t strings = 0; //!< string data of tracks and album keys
+        size_t tracks = 0;  //!< track objects without their strings
+        size_t albums = 0;  //!< album objects without their strings and covers
+        size_t maps = 0;    //!< nodes and buckets of the lookup maps, and the directory tree with its paths
+        size_t search_index = 0;
+
+        size_t total() const { return covers + strings + tracks + albums + maps + search_index; }
+    };
+
+    AudioLibrary() = default;
+
+    /**
+    * Deep copy, the tracks and albums keep their uuids. It's used for the snapshots of ThreadSafeAudioLibrary.
+    */
+    AudioLibrary(const AudioLibrary& other);
+    AudioLibrary& operator=(const AudioLibrary& other) = delete;
+
     const AudioLibraryTrack* findTrack(const QString& filepath) const;
     void addTrack(const QString& filepath, const QDateTime& last_modified, qint64 file_size, const TrackInfo& track_info);
 
     void removeTrack(AudioLibraryTrack* track);
+
+    /**
+    * Returns false if there is no track with the path.
+    */
+    bool removeTrack(const QString& filepath);
+
     void removeTracksWithInvalidPaths();
 
+    /**
+    * Checks whether the files of the tracks still exist, one directory at a time on several threads.
+    * A directory with many tracks is listed once, instead of looking up each of its files.
+    * The files of a directory that can't be reached, e.g. on a drive that isn't mounted, don't count as missing.
+    * Returns the paths of the missing files, or what was found until the abort flag was set.
+    */
+    std::vector<QString> findMissingFiles(int thread_count, const std::atomic_bool& abort_flag) const;
+
+    /**
+    * Finds or removes the tracks in the directory and its subdirectories, without looking at the other tracks.
+    * A missing slash at the end of the path is added.
+    */
+    std::vector<const AudioLibraryTrack*> findTracksInDirectory(const QString& directory_path) const;
+    void removeTracksInDirectory(const QString& directory_path);
+
     std::vector<const AudioLibraryAlbum*> getAlbums() const;
     const AudioLibraryAlbum* getAlbum(const AudioLibraryAlbumKey& key) const;
     AudioLibraryAlbum* getAlbum(const AudioLibraryAlbumKey& key);
     size_t getNumberOfTracks() const;
+    const AudioLibrarySearchIndex& getSearchIndex() const;
+    const AudioLibraryTrackTable& getTrackTable() const;
+    const AudioLibraryPathTree& getPathTree() const;
 
     bool isModified() const;
 
+    /**
+    * Changes with every modification, so results computed from the library can be reused as long as it stays the same.
+    * It may be read without holding the library lock.
+    */
+    quint64 getGeneration() const;
+
+    MemoryUsage getMemoryUsage() const;
+
+    /**
+    * What changed since the previous call of takeChanges, with copies of the changed tracks and albums,
+    * so a copy of the library can be brought up to date without looking at the library again.
+    */
+    struct Changes
+    {
+        struct TrackChange
+        {
+            QString filepath;
+            std::optional<AudioLibraryTrack> track;     //!< without album and directory, empty if the track was removed
+            AudioLibraryAlbumKey album_key;
+        };
+
+        struct AlbumChange
+        {
+            AudioLibraryAlbumKey key;
+            CoverLocation cover;
+            QUuid uuid;
+        };
+
+        bool is_cleared = false;                        //!< the library was cleared before the other changes
+        std::vector<TrackChange> tracks;
+        std::vector<AlbumChange> albums;                //!< only the albums that still exist
+        bool is_modified = false;
+        quint64 generation = 0;
+    };
+
+    /**
+    * Changes are only recorded after this has been called, copies of the library don't record them.
+    */
+    void enableChangeTracking();
+
+    /**
+    * Takes the recorded changes, its cost only depends on the number of changed tracks.
+    */
+    Changes takeChanges();
+
+    /**
+    * Brings a copy of the library up to date, the tracks and albums get the uuids of the original.
+    * The copy must have been up to date when the changes started to be recorded.
+    */
+    void applyChanges(const Changes& changes);
+
     void removeTracksExcept(const std::unordered_set<QString>& loaded_audio_files);
 
     void save(QDataStream& s) const;
     void load(QDataStream& s);
 
+    /**
+    * Loads the cache album by album, so the library can be used in between.
+    *
+    * The albums are stored in blocks, which are decoded on several threads into albums and tracks
+    * that don't belong to the library yet. Adding them only inserts them into the maps.
+    */
     class Loader
     {
     public:
-        void init(AudioLibrary& library, QDataStream& s);
+        ~Loader();
+
+        /**
+        * Clears the library and starts to read the blocks from the stream on another thread, which must not
+        * be used otherwise until the loader is destroyed. They are decoded on the given number of threads.
+        * Only a few blocks per thread are read ahead of the next album, so reading, decoding and adding the
+        * albums overlap, and the memory for the blocks stays bounded.
+        */
+        void init(AudioLibrary& library, QDataStream& s, int thread_count);
+
         bool hasNextAlbum() const;
+
+        /**
+        * Waits until the block of the next album is decoded. It doesn't need the library, so a caller that
+        * shares the library with other threads should wait before taking the lock for loadNextAlbum.
+        */
+        void waitForNextAlbum();
+
+        /**
+        * Adds the next album, waits for it first if waitForNextAlbum hasn't been called.
+        */
         void loadNextAlbum(AudioLibrary& library);
 
     private:
+        struct DecodedAlbum
+        {
+            AudioLibraryAlbum album;
+            std::vector<std::pair<quint32, AudioLibraryTrack>> tracks; //!< with the index of their directory
+        };
+
+        struct Block
+        {
+            quint64 num_albums = 0;
+            QByteArray data;
+            std::vector<DecodedAlbum> albums;
+            bool is_read = false;
+            bool is_decoded = false;
+        };
+
+        void readBlocks();
+        void decodeBlocks();
+        static DecodedAlbum decodeAlbum(QDataStream& s, std::set<std::pair<quint32, QString>>& paths_in_block);
+
         QDataStream* _s = nullptr;
         quint64 _num_albums = 0;
         quint64 _albums_loaded = 0;
+
+        // the directories are created when their first track is loaded, nothing removes them while loading
+        std::vector<QString> _directory_paths;
+        std::vector<AudioLibraryDirectory*> _directories;
+
+        std::vector<Block> _blocks;
+        size_t _block_index = 0;                        //!< only changed by loadNextAlbum, under the mutex
+        size_t _album_in_block = 0;
+        size_t _max_blocks_read_ahead = 0;
+
+        std::vector<std::thread> _threads;
+        std::atomic_size_t _next_block_to_decode = 0;
+        std::mutex _blocks_mutex;                       //!< guards the states of the blocks
+        std::condition_variable _block_state_changed;
+        bool _abort = false;
     };
 
 private:
-    AudioLibraryAlbum* addAlbum(const AudioLibraryAlbumKey& album_key, const QByteArray& cover);
-    AudioLibraryAlbum* addAlbum(const AudioLibraryAlbumKey& album_key, const QByteArray& cover, const QSize& cover_size);
-    AudioLibraryTrack* addTrack(AudioLibraryAlbum* album,
-        const QString& filepath,
-        const QDateTime& last_modified,
-        qint64 file_size,
-        const QString& artist,
-        const QString& album_artist,
-        const QString& title,
-        int track_number,
-        int disc_number,
-        const QString& comment,
-        const QString& tag_types,
-        int length_milliseconds,
-        int channels,
-        int bitrate_kbs,
-        int samplerate_hz);
-
-    std::map<AudioLibraryAlbumKey, std::unique_ptr<AudioLibraryAlbum>> _album_map;
-    std::unordered_map<QString, std::unique_ptr<AudioLibraryTrack>> _filepath_to_track_map;
+    void clear();
+
+    AudioLibraryAlbum* addAlbum(const AudioLibraryAlbumKey& album_key, const CoverLocation& cover);
+    AudioLibraryAlbum* addAlbum(AudioLibraryAlbum&& album);
+
+    /**
+    * The track must already point to its album and directory.
+    * If its path is already in the library, nothing is changed and the existing track is returned.
+    */
+    AudioLibraryTrack* addTrack(AudioLibraryTrack&& track);
+
+    void recordChange(const AudioLibraryTrack* track);
+
+    // the albums and tracks are stored in the nodes of the maps, which are allocated from a pool of the library,
+    // so loading a large cache doesn't need several small allocations per track. The library is only changed
+    // under its lock, so the pool doesn't need to be synchronized. It's declared first to outlive the maps.
+    std::pmr::unsynchronized_pool_resource _memory_pool;
+    std::pmr::map<AudioLibraryAlbumKey, AudioLibraryAlbum> _album_map{ &_memory_pool };
+    std::pmr::unordered_map<AudioLibraryTrackPath, AudioLibraryTrack> _path_to_track_map{ &_memory_pool };
+    AudioLibraryPathTree _path_tree;
+    AudioLibrarySearchIndex _search_index;
+    AudioLibraryTrackTable _track_table;
     bool _is_modified = false;
+    std::atomic<quint64> _generation = 0;
+
+    // the paths of the added and removed tracks and the keys of their albums since the last takeChanges
+    bool _is_tracking_changes = false;
+    bool _is_cleared_since_last_changes = false;
+    std::unordered_set<QString> _changed_track_paths;
+    std::set<AudioLibraryAlbumKey> _changed_album_keys;
 };
\ No newline at end of file
@@ -1,11 +1,15 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "AudioLibraryModel.h"
 
+#include <algorithm>
 #include <array>
 #include <ranges>
 #include <QtCore/qabstractitemmodel.h>
 #include <QtCore/qcollator.h>
 #include <QtCore/qtimer.h>
+#include "MemoryUsage.h"
+#include "PerformanceCounters.h"
+#include "Tracing.h"
 
 class AudioLibraryModelImpl : public QAbstractTableModel
 {
@@ -14,8 +18,6 @@ public:
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     int columnCount(const QModelIndex& parent = QModelIndex()) const override;
-    void setDataInternal(int row, AudioLibraryView::Column column, const QVariant& data, int role = Qt::DisplayRole);
-    void setDecoration(int row, const AudioLibraryAlbum* album);
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
     void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
@@ -32,7 +34,7 @@ public:
 
     struct Decoration
     {
-        QByteArray bytes;
+        CoverLocation cover; //!< the picture data is only read when the decoration is loaded
         LoadState load_state = LoadState::NotLoaded;
         QPixmap pixmap;
         QVariant variant;
@@ -59,9 +61,13 @@ public:
         int index = -1;
     };
 
-    Row* createRow(const QUuid& id);
+    /**
+    * Inserts the rows with one notification. The rows must be complete, except for their index.
+    */
+    void appendRows(std::vector<std::unique_ptr<Row>> rows);
     void removeRow(const QUuid& id);
     Row* findRowForId(const QUuid& id) const;
+    std::shared_ptr<Decoration> getDecoration(const QUuid& album_id, const CoverLocation& cover);
     QModelIndex findIndexForId(const QUuid& id) const;
     const AudioLibraryView* getViewForIndex(const QModelIndex& index) const;
 
@@ -73,6 +79,9 @@ public:
 
     void updateDecoration(const QModelIndex& index);
 
+    AudioLibraryModel::DecorationStatistics getDecorationStatistics() const;
+    AudioLibraryModel::MemoryUsage getMemoryUsage() const;
+
 private:
     void updateRowIndexes();
 
@@ -112,59 +121,18 @@ int AudioLibraryModelImpl::columnCount(const QModelIndex& /*parent*/) const
     return AudioLibraryView::NUMBER_OF_COLUMNS;
 }
 
-void AudioLibraryModelImpl::setDataInternal(int row, AudioLibraryView::Column column, const QVariant& data, int role)
+std::shared_ptr<AudioLibraryModelImpl::Decoration> AudioLibraryModelImpl::getDecoration(const QUuid& album_id, const CoverLocation& cover)
 {
-    if (row >= 0 &&
-        row < static_cast<int>(_rows.size()))
+    auto it = _decorations_for_album_ids.find(album_id);
+    if (it == _decorations_for_album_ids.end())
     {
-        Row* row_data = _rows[row].get();
-
-        if (role == Qt::DisplayRole)
-        {
-            if (column >= 0 &&
-                column < AudioLibraryView::NUMBER_OF_COLUMNS)
-            {
-                row_data->display_role_data[column] = data;
-                row_data->sort_role_data[column] = data.toString();
-            }
-        }
-        else if (role == AudioLibraryView::MULTILINE_DISPLAY_ROLE && column == AudioLibraryView::ZERO)
-        {
-            row_data->multiline_display_role = data;
-        }
-        else if (role == AudioLibraryView::ID_ROLE)
-        {
-            row_data->id = data;
-        }
-        else if (role == AudioLibraryView::SORT_ROLE)
-        {
-            if (column >= 0 &&
-                column < AudioLibraryView::NUMBER_OF_COLUMNS)
-            {
-                row_data->sort_role_data[column] = data.toString();
-            }
-        }
+        auto decoration = std::make_shared<Decoration>();
+        decoration->cover = cover;
+        decoration->variant = _default_icon;
+        it = _decorations_for_album_ids.emplace(std::make_pair(album_id, decoration)).first;
     }
-}
-
-void AudioLibraryModelImpl::setDecoration(int row, const AudioLibraryAlbum* album)
-{
-    if (row >= 0 &&
-        row < static_cast<int>(_rows.size()))
-    {
-        Row* row_data = _rows[row].get();
-
-        auto it = _decorations_for_album_ids.find(album->getUuid());
-        if (it == _decorations_for_album_ids.end())
-        {
-            auto decoration = std::make_shared<Decoration>();
-            decoration->bytes = album->getCover();
-            decoration->variant = _default_icon;
-            it = _decorations_for_album_ids.emplace(std::make_pair(album->getUuid(), decoration)).first;
-        }
 
-        row_data->decoration = it->second;
-    }
+    return it->second;
 }
 
 QVariant AudioLibraryModelImpl::data(const QModelIndex& index, int role) const
@@ -241,6 +209,9 @@ void AudioLibraryModelImpl::sort(int column, Qt::SortOrder order)
         rowCount() == 0)
         return;
 
+    TraceSpan span("sort");
+    ScopedDurationCounter duration_counter(getPerformanceCounters().last_sort_ns);
+
     QList<QPersistentModelIndex> parents;
     layoutAboutToBeChanged(parents, QAbstractItemModel::VerticalSortHint);
 
@@ -292,24 +263,26 @@ void AudioLibraryModelImpl::sort(int column, Qt::SortOrder order)
     layoutChanged(parents, QAbstractItemModel::VerticalSortHint);
 }
 
-AudioLibraryModelImpl::Row* AudioLibraryModelImpl::createRow(const QUuid& id)
+void AudioLibraryModelImpl::appendRows(std::vector<std::unique_ptr<Row>> rows)
 {
-    if (_rows.size() + 1 > INT_MAX)
-        return nullptr; // QModelIndex uses int, so we can't have more than INT_MAX rows
+    // QModelIndex uses int, so we can't have more than INT_MAX rows
+    rows.resize(std::min(rows.size(), static_cast<size_t>(INT_MAX) - _rows.size()));
+
+    if (rows.empty())
+        return;
 
-    auto row = std::make_unique<Row>();
-    row->id = id;
-    row->index = static_cast<int>(_rows.size());
+    const int first_index = static_cast<int>(_rows.size());
 
-    beginInsertRows(QModelIndex(), row->index, row->index);
+    beginInsertRows(QModelIndex(), first_index, first_index + static_cast<int>(rows.size()) - 1);
 
-    Row* result = row.get();
-    _id_to_row_map[id] = result;
-    _rows.push_back(std::move(row));
+    for (std::unique_ptr<Row>& row : rows)
+    {
+        row->index = static_cast<int>(_rows.size());
+        _id_to_row_map[row->id.toUuid()] = row.get();
+        _rows.push_back(std::move(row));
+    }
 
     endInsertRows();
-
-    return result;
 }
 
 void AudioLibraryModelImpl::removeRow(const QUuid& id)
@@ -398,8 +371,71 @@ void AudioLibraryModelImpl::updateRowIndexes()
         _rows[i]->index = static_cast<int>(i);
 }
 
+AudioLibraryModel::DecorationStatistics AudioLibraryModelImpl::getDecorationStatistics() const
+{
+    AudioLibraryModel::DecorationStatistics statistics;
+
+    for (const auto& album_id_and_decoration : _decorations_for_album_ids)
+    {
+        const Decoration* decoration = album_id_and_decoration.second.get();
+
+        if (decoration->load_state == LoadState::Requested)
+        {
+            ++statistics.pending;
+        }
+        else if (decoration->load_state == LoadState::Done)
+        {
+            ++statistics.decoded;
+            statistics.memory_bytes += qint64(decoration->pixmap.width()) * decoration->pixmap.height() * decoration->pixmap.depth() / 8;
+        }
+    }
+
+    return statistics;
+}
+
+AudioLibraryModel::MemoryUsage AudioLibraryModelImpl::getMemoryUsage() const
+{
+    MemoryUsageCounter counter;
+    AudioLibraryModel::MemoryUsage usage;
+
+    usage.rows = MemoryUsageCounter::vectorSize(_rows) + MemoryUsageCounter::hashMapSize(_id_to_row_map);
+
+    for (const auto& row : _rows)
+    {
+        usage.rows += sizeof(Row);
+
+        for (const QVariant& data : row->display_role_data)
+            usage.display_strings += counter.addVariant(data);
+        usage.display_strings += counter.addVariant(row->multiline_display_role);
+    }
+
+    // after the display strings, so that only sort keys with their own data are counted
+
+    for (const auto& row : _rows)
+        for (const QString& sort_string : row->sort_role_data)
+            usage.sort_strings += counter.addString(sort_string);
+
+    usage.decorations = MemoryUsageCounter::hashMapSize(_decorations_for_album_ids) + MemoryUsageCounter::vectorSize(_requested_decorations);
+
+    for (const auto& album_id_and_decoration : _decorations_for_album_ids)
+    {
+        const Decoration* decoration = album_id_and_decoration.second.get();
+
+        usage.decorations += sizeof(Decoration);
+        usage.decorations += counter.addString(decoration->cover.filepath);
+        usage.decorations += counter.addString(decoration->cover.format);
+
+        if (decoration->load_state == LoadState::Done)
+            usage.decorations += size_t(decoration->pixmap.width()) * decoration->pixmap.height() * decoration->pixmap.depth() / 8;
+    }
+
+    return usage;
+}
+
 void AudioLibraryModelImpl::loadRequestedDecorations()
 {
+    TraceSpan span("loadRequestedDecorations");
+
     // first, load requested decorations until we either run out of time or out of work
     // the most recently requested decoration should always be loaded first
 
@@ -439,7 +475,7 @@ bool AudioLibraryModelImpl::Decoration::load()
 {
     if (load_state == LoadState::Requested)
     {
-        const bool ok = pixmap.loadFromData(bytes);
+        const bool ok = pixmap.loadFromData(readCover(cover));
         if (ok)
             variant = QIcon(pixmap);
 
@@ -460,122 +496,31 @@ AudioLibraryModel::AudioLibraryModel(QObject* parent, AudioLibraryGroupUuidCache
     _item_model = new AudioLibraryModelImpl(this);
 }
 
-void AudioLibraryModel::addItemInternal(const QUuid& id,
-    const std::function<void(int row)>& item_factory,
-    const std::function<std::unique_ptr<AudioLibraryView>()>& view_factory)
+void AudioLibraryModel::addRows(AudioLibraryRowSet&& rows)
 {
-    _requested_ids.insert(id);
+    std::vector<std::unique_ptr<AudioLibraryModelImpl::Row>> new_rows;
 
-    if (_item_model->findRowForId(id))
+    for (AudioLibraryRowSet::Row& row : rows.takeRows())
     {
-        // already exists, nothing to do
-        return;
-    }
-    AudioLibraryModelImpl::Row* row = _item_model->createRow(id);
-    if (!row)
-        return;
-
-    item_factory(row->index);
-
-    row->view = view_factory();
-
-    _item_model->dataChanged(_item_model->index(row->index, 0), _item_model->index(row->index, AudioLibraryView::NUMBER_OF_COLUMNS - 1));
-}
-
-void AudioLibraryModel::addGroupItem(const QString& name, const AudioLibraryAlbum* showcase_album, int number_of_albums, int number_of_tracks, const std::function<std::unique_ptr<AudioLibraryView>()>& view_factory)
-{
-    const QUuid id = _group_uuids.getUuidForGroup(name, showcase_album, number_of_albums, number_of_tracks);
-
-    auto item_factory = [this, name, showcase_album, number_of_albums, number_of_tracks](int row) {
-
-        _item_model->setDataInternal(row, AudioLibraryView::ZERO, name);
-        _item_model->setDecoration(row, showcase_album);
-
-        _item_model->setDataInternal(row, AudioLibraryView::NUMBER_OF_ALBUMS, QString::number(number_of_albums));
-        _item_model->setDataInternal(row, AudioLibraryView::NUMBER_OF_TRACKS, QString::number(number_of_tracks));
-    };
-
-    addItemInternal(id, item_factory, view_factory);
-}
-
-void AudioLibraryModel::addAlbumItem(const AudioLibraryAlbum* album)
-{
-    const QUuid id = album->getUuid();
-
-    auto item_factory = [this, album](int row) {
-
-        QLatin1Char sep(' ');
-
-        QString sort_key = album->getKey().getArtist() + sep +
-            QString::number(album->getKey().getYear()) + sep +
-            album->getKey().getAlbum();
+        const QUuid id = row.id.isNull() ? _group_uuids.getUuidForGroup(row.group_name, row.decoration_album_id, row.number_of_albums, row.number_of_tracks) : row.id;
 
-        _item_model->setDataInternal(row, AudioLibraryView::ZERO, album->getKey().getArtist() + " - " + album->getKey().getAlbum());
-        _item_model->setDecoration(row, album);
-        _item_model->setDataInternal(row, AudioLibraryView::ZERO, album->getKey().getArtist() + QChar(QChar::LineSeparator) + album->getKey().getAlbum(), AudioLibraryView::MULTILINE_DISPLAY_ROLE);
-        _item_model->setDataInternal(row, AudioLibraryView::ZERO, sort_key, AudioLibraryView::SORT_ROLE);
+        // rows which have already been added stay as they are
 
-        setAlbumColumns(row, album);
-        _item_model->setDataInternal(row, AudioLibraryView::ARTIST, album->getKey().getArtist());
-        _item_model->setDataInternal(row, AudioLibraryView::NUMBER_OF_TRACKS, QString::number(album->getTracks().size()));
+        if (!_requested_ids.insert(id).second || _item_model->findRowForId(id))
+            continue;
 
-        int length_milliseconds = 0;
-        for (const AudioLibraryTrack* track : album->getTracks())
-            length_milliseconds += track->getLengthMs();
+        auto new_row = std::make_unique<AudioLibraryModelImpl::Row>();
+        new_row->id = id;
+        new_row->display_role_data = std::move(row.display_role_data);
+        new_row->sort_role_data = std::move(row.sort_role_data);
+        new_row->multiline_display_role = std::move(row.multiline_display_role);
+        new_row->decoration = _item_model->getDecoration(row.decoration_album_id, row.decoration_cover);
+        new_row->view = std::move(row.view);
 
-        setLengthColumn(row, length_milliseconds);
-    };
-
-    addItemInternal(id, item_factory, [album](){
-        return std::make_unique<AudioLibraryViewAlbum>(album->getKey());
-    });
-}
-
-void AudioLibraryModel::addTrackItem(const AudioLibraryTrack* track)
-{
-    const QUuid id = track->getUuid();
-
-    auto item_factory = [this, track](int row) {
-
-        QLatin1Char sep(' ');
-
-        QString sort_key = track->getAlbum()->getKey().getArtist() + sep +
-            QString::number(track->getAlbum()->getKey().getYear()) + sep +
-            track->getAlbum()->getKey().getAlbum() + sep +
-            QString::number(track->getDiscNumber()) + sep +
-            QString::number(track->getTrackNumber());
-
-        _item_model->setDataInternal(row, AudioLibraryView::ZERO, track->getArtist() + " - " + track->getTitle());
-        _item_model->setDecoration(row, track->getAlbum());
-        _item_model->setDataInternal(row, AudioLibraryView::ZERO, track->getArtist() + QChar(QChar::LineSeparator) + track->getTitle(), AudioLibraryView::MULTILINE_DISPLAY_ROLE);
-        _item_model->setDataInternal(row, AudioLibraryView::ZERO, sort_key, AudioLibraryView::SORT_ROLE);
-
-        setAlbumColumns(row, track->getAlbum());
-        _item_model->setDataInternal(row, AudioLibraryView::ARTIST, track->getArtist());
-        _item_model->setDataInternal(row, AudioLibraryView::TITLE, track->getTitle());
-        if(track->getTrackNumber() != 0)
-            _item_model->setDataInternal(row, AudioLibraryView::TRACK_NUMBER, QString::number(track->getTrackNumber()));
-        if(track->getDiscNumber() != 0)
-            _item_model->setDataInternal(row, AudioLibraryView::DISC_NUMBER, QString::number(track->getDiscNumber()));
-        _item_model->setDataInternal(row, AudioLibraryView::ALBUM_ARTIST, track->getAlbumArtist());
-        _item_model->setDataInternal(row, AudioLibraryView::COMMENT, track->getComment());
-        _item_model->setDataInternal(row, AudioLibraryView::PATH, track->getFilepath());
-        setDateTimeColumn(row, AudioLibraryView::DATE_MODIFIED, track->getLastModified());
-        QString file_size = QLocale().formattedDataSize(track->getFileSize());
-        _item_model->setDataInternal(row, AudioLibraryView::FILE_SIZE, file_size);
-        _item_model->setDataInternal(row, AudioLibraryView::FILE_SIZE, QString::number(track->getFileSize()), AudioLibraryView::SORT_ROLE);
-        _item_model->setDataInternal(row, AudioLibraryView::TAG_TYPES, track->getTagTypes());
-        setLengthColumn(row, track->getLengthMs());
-        _item_model->setDataInternal(row, AudioLibraryView::CHANNELS, QString::number(track->getChannels()));
-        _item_model->setDataInternal(row, AudioLibraryView::BITRATE_KBS, QString::number(track->getBitrateKbs()) + QLatin1String(" kbit/s"));
-        _item_model->setDataInternal(row, AudioLibraryView::SAMPLERATE_HZ, QString::number(track->getSampleRateHz()) + QLatin1String(" Hz"));
-    };
-
-    // no view for track items
+        new_rows.push_back(std::move(new_row));
+    }
 
-    addItemInternal(id, item_factory, []() {
-        return nullptr;
-    });
+    _item_model->appendRows(std::move(new_rows));
 }
 
 QAbstractItemModel* AudioLibraryModel::getModel()
@@ -625,6 +570,16 @@ void AudioLibraryModel::updateDecoration(const QModelIndex& index)
     _item_model->updateDecoration(index);
 }
 
+AudioLibraryModel::DecorationStatistics AudioLibraryModel::getDecorationStatistics() const
+{
+    return _item_model->getDecorationStatistics();
+}
+
+AudioLibraryModel::MemoryUsage AudioLibraryModel::getMemoryUsage() const
+{
+    return _item_model->getMemoryUsage();
+}
+
 void AudioLibraryModel::removeId(const QUuid& id)
 {
     _item_model->removeRow(id);
@@ -660,49 +615,6 @@ void AudioLibraryModel::onUpdateFinished()
         removeId(id);
 }
 
-void AudioLibraryModel::setDateTimeColumn(int row, AudioLibraryView::Column column, const QDateTime& date)
-{
-    _item_model->setDataInternal(row, column, QLocale::system().toString(date, QLocale::ShortFormat));
-    _item_model->setDataInternal(row, column, date.toString(Qt::ISODate), AudioLibraryView::SORT_ROLE);
-}
-
-void AudioLibraryModel::setLengthColumn(int row, int length_milliseconds)
-{
-    int length_seconds = length_milliseconds / 1000;
-
-    QTime length_time = QTime(0, 0).addMSecs(length_milliseconds);
-
-    QString formatted_length = length_time.toString(length_seconds < 3600 ? "mm:ss" : "hh:mm:ss");
-
-    _item_model->setDataInternal(row, AudioLibraryView::LENGTH_SECONDS, formatted_length);
-    _item_model->setDataInternal(row, AudioLibraryView::LENGTH_SECONDS, QString::number(length_seconds), AudioLibraryView::SORT_ROLE);
-}
-
-void AudioLibraryModel::setAlbumColumns(int row, const AudioLibraryAlbum* album)
-{
-    _item_model->setDataInternal(row, AudioLibraryView::ALBUM, album->getKey().getAlbum());
-
-    if (album->getKey().getYear() != 0)
-        _item_model->setDataInternal(row, AudioLibraryView::YEAR, QString::number(album->getKey().getYear()));
-
-    _item_model->setDataInternal(row, AudioLibraryView::GENRE, album->getKey().getGenre());
-
-    if (!album->getCover().isEmpty())
-    {
-        _item_model->setDataInternal(row, AudioLibraryView::COVER_CHECKSUM, QString::number(album->getKey().getCoverChecksum()));
-
-        QString data_size = QLocale().formattedDataSize(album->getCover().size());
-
-        _item_model->setDataInternal(row, AudioLibraryView::COVER_DATASIZE, data_size);
-        _item_model->setDataInternal(row, AudioLibraryView::COVER_DATASIZE, QString::number(album->getCover().size()), AudioLibraryView::SORT_ROLE);
-    }
-
-    _item_model->setDataInternal(row, AudioLibraryView::COVER_TYPE, album->getCoverType());
-
-    _item_model->setDataInternal(row, AudioLibraryView::COVER_WIDTH, QString::number(album->getCoverSize().width()));
-    _item_model->setDataInternal(row, AudioLibraryView::COVER_HEIGHT, QString::number(album->getCoverSize().height()));
-}
-
 //=============================================================================
 
 class AudioLibraryGroupUuidCache::Private
@@ -731,11 +643,11 @@ AudioLibraryGroupUuidCache::~AudioLibraryGroupUuidCache() = default;
 /**
 * Assigns a persistent uuid for a group with the given parameters.
 */
-QUuid AudioLibraryGroupUuidCache::getUuidForGroup(const QString& name, const AudioLibraryAlbum* showcase_album, int number_of_albums, int number_of_tracks)
+QUuid AudioLibraryGroupUuidCache::getUuidForGroup(const QString& name, const QUuid& showcase_album_id, int number_of_albums, int number_of_tracks)
 {
     // the uuid is only inserted if the group does not already exist in the map
     auto it = _p->_group_uuids.insert({
-        Private::GroupData{name, showcase_album->getUuid(), number_of_albums, number_of_tracks},
+        Private::GroupData{name, showcase_album_id, number_of_albums, number_of_tracks},
         QUuid::createUuid() });
 
     return it.first->second;
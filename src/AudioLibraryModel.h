@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #pragma once
 
-#include "AudioLibraryView.h"
+#include "AudioLibraryRowSet.h"
 
 class AudioLibraryModelImpl;
 class AudioLibraryGroupUuidCache;
@@ -11,6 +11,26 @@ class AudioLibraryModel : public QObject
 public:
     AudioLibraryModel(QObject* parent, AudioLibraryGroupUuidCache& group_uuids);
 
+    struct DecorationStatistics
+    {
+        int pending = 0;            //!< requested, but not decoded yet
+        int decoded = 0;
+        qint64 memory_bytes = 0;    //!< size of the decoded pixmaps
+    };
+
+    /**
+    * Approximate memory in bytes, see MemoryUsageCounter.
+    */
+    struct MemoryUsage
+    {
+        size_t rows = 0;            //!< row objects and lookup maps
+        size_t display_strings = 0;
+        size_t sort_strings = 0;    //!< sort keys which don't share the data of the display strings
+        size_t decorations = 0;     //!< decoded pixmaps and cover locations
+
+        size_t total() const { return rows + display_strings + sort_strings + decorations; }
+    };
+
     class IncrementalUpdateScope
     {
     public:
@@ -21,9 +41,10 @@ public:
         AudioLibraryModel& _model;
     };
 
-    void addGroupItem(const QString& name, const AudioLibraryAlbum* showcase_album, int number_of_albums, int number_of_tracks, const std::function<std::unique_ptr<AudioLibraryView>()>& view_factory);
-    void addAlbumItem(const AudioLibraryAlbum* album);
-    void addTrackItem(const AudioLibraryTrack* track);
+    /**
+    * Adds the rows that aren't in the model yet. Within an IncrementalUpdateScope, the rows which aren't added again are removed at the end.
+    */
+    void addRows(AudioLibraryRowSet&& rows);
 
     QAbstractItemModel* getModel();
     const QAbstractItemModel* getModel() const;
@@ -37,16 +58,13 @@ public:
 
     void updateDecoration(const QModelIndex& index);
 
+    DecorationStatistics getDecorationStatistics() const;
+    MemoryUsage getMemoryUsage() const;
+
 private:
-    void addItemInternal(const QUuid& id,
-        const std::function<void(int row)>& item_factory,
-        const std::function<std::unique_ptr<AudioLibraryView>()>& view_factory);
     void removeId(const QUuid& id);
     void onUpdateStarted();
     void onUpdateFinished();
-    void setDateTimeColumn(int row, AudioLibraryView::Column column, const QDateTime& date);
-    void setLengthColumn(int row, int length_milliseconds);
-    void setAlbumColumns(int row, const AudioLibraryAlbum* album);
 
     AudioLibraryModelImpl* _item_model;
 
@@ -60,7 +78,7 @@ public:
     AudioLibraryGroupUuidCache();
     ~AudioLibraryGroupUuidCache();
 
-    QUuid getUuidForGroup(const QString& name, const AudioLibraryAlbum* showcase_album, int number_of_albums, int number_of_tracks);
+    QUuid getUuidForGroup(const QString& name, const QUuid& showcase_album_id, int number_of_albums, int number_of_tracks);
 
 private:
     class Private;
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "AudioLibraryPathTree.h"
+
+#include <cassert>
+#include "AudioLibrary.h"
+#include "MemoryUsage.h"
+
+namespace {
+
+    QString getParentPath(const QString& path)
+    {
+        // skip the slash at the end, a path without another slash is at the root
+
+        const qsizetype pos = path.size() >= 2 ? path.lastIndexOf(QLatin1Char('/'), path.size() - 2) + 1 : 0;
+        return path.left(pos);
+    }
+
+    template<class TRACK>
+    void appendTracks(const AudioLibraryDirectory* directory, std::vector<TRACK*>& tracks, auto get_tracks)
+    {
+        const auto& directory_tracks = get_tracks(directory);
+        tracks.insert(tracks.end(), directory_tracks.begin(), directory_tracks.end());
+
+        for (const AudioLibraryDirectory* child : directory->getChildren())
+            appendTracks(child, tracks, get_tracks);
+    }
+}
+
+AudioLibraryPathTree::AudioLibraryPathTree()
+{
+    clear();
+}
+
+std::pair<QString, QString> AudioLibraryPathTree::splitPath(const QString& filepath)
+{
+    const qsizetype pos = filepath.lastIndexOf(QLatin1Char('/')) + 1;
+    return { filepath.left(pos), filepath.mid(pos) };
+}
+
+const AudioLibraryDirectory* AudioLibraryPathTree::findDirectory(const QString& path) const
+{
+    auto it = _directories.find(path);
+    if (it != _directories.end())
+        return it->second.get();
+
+    return nullptr;
+}
+
+AudioLibraryDirectory* AudioLibraryPathTree::addDirectory(const QString& path)
+{
+    auto it = _directories.find(path);
+    if (it != _directories.end())
+        return it->second.get();
+
+    AudioLibraryDirectory* parent = addDirectory(getParentPath(path));
+
+    auto directory = std::make_unique<AudioLibraryDirectory>();
+    directory->_path = path;
+    directory->_parent = parent;
+    directory->_index_in_parent = static_cast<quint32>(parent->_children.size());
+    parent->_children.push_back(directory.get());
+
+    return _directories.emplace(path, std::move(directory)).first->second.get();
+}
+
+void AudioLibraryPathTree::addTrack(AudioLibraryTrack* track)
+{
+    AudioLibraryDirectory* directory = track->getDirectory();
+
+    track->setDirectoryIndex(static_cast<quint32>(directory->_tracks.size()));
+    directory->_tracks.push_back(track);
+}
+
+void AudioLibraryPathTree::removeTrack(AudioLibraryTrack* track)
+{
+    AudioLibraryDirectory* directory = track->getDirectory();
+
+    // move the last track into the place of the removed one, so removing doesn't depend on the size of the directory
+
+    const quint32 index = track->getDirectoryIndex();
+    assert(index < directory->_tracks.size() && directory->_tracks[index] == track);
+
+    AudioLibraryTrack* last_track = directory->_tracks.back();
+    directory->_tracks[index] = last_track;
+    last_track->setDirectoryIndex(index);
+    directory->_tracks.pop_back();
+
+    removeDirectoryIfEmpty(directory);
+}
+
+void AudioLibraryPathTree::clear()
+{
+    _directories.clear();
+
+    auto root = std::make_unique<AudioLibraryDirectory>();
+    _root = root.get();
+    _directories.emplace(QString(), std::move(root));
+}
+
+std::vector<const AudioLibraryDirectory*> AudioLibraryPathTree::getDirectories() const
+{
+    std::vector<const AudioLibraryDirectory*> directories;
+    directories.reserve(_directories.size() - 1);
+
+    directories.insert(directories.end(), _root->_children.begin(), _root->_children.end());
+
+    // the children of every directory are appended after it
+    for (size_t i = 0; i < directories.size(); ++i)
+        directories.insert(directories.end(), directories[i]->_children.begin(), directories[i]->_children.end());
+
+    return directories;
+}
+
+void AudioLibraryPathTree::getTracks(const AudioLibraryDirectory* directory, std::vector<AudioLibraryTrack*>& tracks)
+{
+    // the tree isn't const, so it may hand out its tracks for modification
+    appendTracks(directory, tracks, [](const AudioLibraryDirectory* d) -> const std::vector<AudioLibraryTrack*>& { return d->_tracks; });
+}
+
+void AudioLibraryPathTree::getTracks(const AudioLibraryDirectory* directory, std::vector<const AudioLibraryTrack*>& tracks) const
+{
+    appendTracks(directory, tracks, [](const AudioLibraryDirectory* d) { return d->getTracks(); });
+}
+
+size_t AudioLibraryPathTree::getMemoryUsage(MemoryUsageCounter& counter) const
+{
+    size_t usage = MemoryUsageCounter::hashMapSize(_directories);
+
+    for (const auto& path_and_directory : _directories)
+    {
+        const AudioLibraryDirectory* directory = path_and_directory.second.get();
+
+        usage += sizeof(AudioLibraryDirectory);
+        usage += MemoryUsageCounter::vectorSize(directory->_children);
+        usage += MemoryUsageCounter::vectorSize(directory->_tracks);
+        usage += counter.addString(path_and_directory.first);
+        usage += counter.addString(directory->_path);
+    }
+
+    return usage;
+}
+
+void AudioLibraryPathTree::removeDirectoryIfEmpty(AudioLibraryDirectory* directory)
+{
+    while (directory != _root && directory->_tracks.empty() && directory->_children.empty())
+    {
+        AudioLibraryDirectory* parent = directory->_parent;
+
+        AudioLibraryDirectory* last_child = parent->_children.back();
+        parent->_children[directory->_index_in_parent] = last_child;
+        last_child->_index_in_parent = directory->_index_in_parent;
+        parent->_children.pop_back();
+
+        // destroys the directory, its path can't be used as the key to erase it
+        _directories.erase(_directories.find(directory->_path));
+
+        directory = parent;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <QtCore/qhashfunctions.h>
+#include <QtCore/qstring.h>
+
+class AudioLibraryTrack;
+class MemoryUsageCounter;
+
+/**
+* A directory with tracks, or with subdirectories that have tracks. Its path is stored once for all of them.
+*/
+class AudioLibraryDirectory
+{
+public:
+    /**
+    * Ends with a slash, so the path of a file is the path of its directory followed by the file name.
+    * The root of the tree has an empty path.
+    */
+    const QString& getPath() const { return _path; }
+    const AudioLibraryDirectory* getParent() const { return _parent; }
+
+    std::span<const AudioLibraryDirectory* const> getChildren() const { return { _children.data(), _children.size() }; }
+    std::span<const AudioLibraryTrack* const> getTracks() const { return { _tracks.data(), _tracks.size() }; }
+
+private:
+    friend class AudioLibraryPathTree;
+
+    QString _path;
+    AudioLibraryDirectory* _parent = nullptr;
+    quint32 _index_in_parent = 0;
+
+    std::vector<AudioLibraryDirectory*> _children;
+    std::vector<AudioLibraryTrack*> _tracks;
+};
+
+/**
+* Key of a track, its directory and file name instead of the full path.
+*/
+struct AudioLibraryTrackPath
+{
+    const AudioLibraryDirectory* directory = nullptr;
+    QString filename;
+
+    bool operator==(const AudioLibraryTrackPath&) const = default;
+};
+
+namespace std
+{
+    template<> struct hash<AudioLibraryTrackPath>
+    {
+        std::size_t operator()(const AudioLibraryTrackPath& path) const
+        {
+            return qHash(path.filename, qHash(path.directory));
+        }
+    };
+}
+
+/**
+* The directories of the tracks as a tree, so the common prefixes of the file paths are only stored once,
+* and all tracks below a directory can be found without looking at the other tracks of the library.
+*
+* The tracks remember their directory and their position in it, directories without tracks are removed.
+*/
+class AudioLibraryPathTree
+{
+public:
+    AudioLibraryPathTree();
+
+    /**
+    * Splits the path after the last slash into the path of the directory and the file name.
+    */
+    static std::pair<QString, QString> splitPath(const QString& filepath);
+
+    const AudioLibraryDirectory* getRoot() const { return _root; }
+
+    /**
+    * The path must end with a slash, like the paths of the directories.
+    */
+    const AudioLibraryDirectory* findDirectory(const QString& path) const;
+
+    /**
+    * Creates the directory and its parents, if they don't exist yet.
+    */
+    AudioLibraryDirectory* addDirectory(const QString& path);
+
+    /**
+    * The track must already point to the directory.
+    */
+    void addTrack(AudioLibraryTrack* track);
+    void removeTrack(AudioLibraryTrack* track);
+    void clear();
+
+    /**
+    * All directories except the root, parents before their children.
+    */
+    std::vector<const AudioLibraryDirectory*> getDirectories() const;
+
+    /**
+    * Appends the tracks of the directory and of all its subdirectories.
+    */
+    void getTracks(const AudioLibraryDirectory* directory, std::vector<AudioLibraryTrack*>& tracks);
+    void getTracks(const AudioLibraryDirectory* directory, std::vector<const AudioLibraryTrack*>& tracks) const;
+
+    size_t getMemoryUsage(MemoryUsageCounter& counter) const;
+
+private:
+    void removeDirectoryIfEmpty(AudioLibraryDirectory* directory);
+
+    std::unordered_map<QString, std::unique_ptr<AudioLibraryDirectory>> _directories;
+    AudioLibraryDirectory* _root = nullptr;
+};
\ No newline at end of file
@@ -0,0 +1,624 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "AudioLibraryQuery.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <QtCore/qobject.h>
+#include "AudioLibrary.h"
+#include "SubstringSearch.h"
+
+namespace {
+
+    using Field = AudioLibraryQuery::Field;
+    using Node = AudioLibraryQuery::Node;
+
+    const std::vector<std::pair<QString, Field>> FIELD_NAMES = {
+        { "artist", Field::ARTIST },
+        { "album", Field::ALBUM },
+        { "title", Field::TITLE },
+        { "genre", Field::GENRE },
+        { "comment", Field::COMMENT },
+        { "path", Field::PATH },
+        { "year", Field::YEAR },
+        { "bitrate", Field::BITRATE },
+        { "length", Field::LENGTH },
+        { "track", Field::TRACK_NUMBER },
+        { "disc", Field::DISC_NUMBER },
+        { "samplerate", Field::SAMPLERATE },
+        { "channels", Field::CHANNELS },
+    };
+
+    bool isNumericField(Field field)
+    {
+        return field >= Field::YEAR;
+    }
+
+    bool isNotOperator(const QString& token) { return token == "NOT" || token == "!"; }
+    bool isAndOperator(const QString& token) { return token == "AND" || token == "&"; }
+    bool isOrOperator(const QString& token) { return token == "OR" || token == "|"; }
+
+    /**
+    * Splits at spaces and parentheses, except inside quotes. The quotes are kept, so that quoted operators stay words.
+    */
+    std::vector<QString> tokenize(const QString& text)
+    {
+        std::vector<QString> tokens;
+        QString token;
+        bool in_quotes = false;
+
+        for (QChar c : text)
+        {
+            if (c == '"')
+            {
+                in_quotes = !in_quotes;
+                token += c;
+            }
+            else if (!in_quotes && (c.isSpace() || c == '(' || c == ')'))
+            {
+                if (!token.isEmpty())
+                    tokens.push_back(token);
+                token.clear();
+
+                if (!c.isSpace())
+                    tokens.push_back(QString(c));
+            }
+            else
+            {
+                token += c;
+            }
+        }
+
+        if (!token.isEmpty())
+            tokens.push_back(token);
+
+        return tokens;
+    }
+
+    QString unquote(QString text)
+    {
+        return text.remove('"');
+    }
+
+    bool parseInteger(const QString& text, qint64& value)
+    {
+        bool ok = false;
+        value = text.toLongLong(&ok);
+        return ok;
+    }
+
+    /**
+    * Accepts "200", "3:20", "1:02:03" and durations with units like "3m", "3m20s" or "1h".
+    */
+    bool parseSeconds(const QString& text, qint64& seconds)
+    {
+        seconds = 0;
+
+        if (text.contains(':'))
+        {
+            for (const QString& part : text.split(':'))
+            {
+                qint64 value;
+                if (!parseInteger(part, value))
+                    return false;
+
+                seconds = seconds * 60 + value;
+            }
+
+            return true;
+        }
+
+        qint64 value = 0;
+        bool has_digits = false;
+
+        for (QChar c : text)
+        {
+            if (c.isDigit())
+            {
+                value = value * 10 + c.digitValue();
+                has_digits = true;
+                continue;
+            }
+
+            if (!has_digits)
+                return false;
+
+            switch (c.toLower().unicode())
+            {
+            case 'h': seconds += value * 3600; break;
+            case 'm': seconds += value * 60; break;
+            case 's': seconds += value; break;
+            default: return false;
+            }
+
+            value = 0;
+            has_digits = false;
+        }
+
+        seconds += value;
+        return !text.isEmpty();
+    }
+
+    bool parseValue(Field field, const QString& text, qint64& value)
+    {
+        return field == Field::LENGTH ? parseSeconds(text, value) : parseInteger(text, value);
+    }
+
+    /**
+    * Comparisons and ranges are stored as inclusive limits.
+    */
+    bool parseRange(Field field, const QString& text, qint64& min, qint64& max)
+    {
+        min = std::numeric_limits<qint64>::min();
+        max = std::numeric_limits<qint64>::max();
+
+        const qsizetype range_separator = text.indexOf("..");
+        if (range_separator >= 0)
+        {
+            const QString from = text.left(range_separator);
+            const QString to = text.mid(range_separator + 2);
+
+            return (from.isEmpty() || parseValue(field, from, min)) &&
+                (to.isEmpty() || parseValue(field, to, max)) &&
+                (!from.isEmpty() || !to.isEmpty());
+        }
+
+        qint64 value;
+
+        if (text.startsWith(">="))
+            return parseValue(field, text.mid(2), min);
+        if (text.startsWith("<="))
+            return parseValue(field, text.mid(2), max);
+
+        if (text.startsWith('>') && parseValue(field, text.mid(1), value))
+        {
+            min = value + 1;
+            return true;
+        }
+
+        if (text.startsWith('<') && parseValue(field, text.mid(1), value))
+        {
+            max = value - 1;
+            return true;
+        }
+
+        if (!parseValue(field, text.startsWith('=') ? text.mid(1) : text, value))
+            return false;
+
+        min = value;
+        max = value;
+        return true;
+    }
+
+    Node createTerm(const QString& token)
+    {
+        Node node;
+        node.type = Node::Type::TEXT;
+        node.text = unquote(token);
+        node.folded_text = AudioLibrarySearchIndex::foldText(node.text);
+
+        // only known field names are prefixes, so that words with a colon can still be searched
+
+        const qsizetype colon = token.indexOf(':');
+        if (colon <= 0 || token.left(colon).contains('"'))
+            return node;
+
+        const QString field_name = token.left(colon).toLower();
+        auto found = std::ranges::find_if(FIELD_NAMES, [&field_name](const std::pair<QString, Field>& i) { return i.first == field_name; });
+        if (found == FIELD_NAMES.end())
+            return node;
+
+        node.field = found->second;
+        node.text = unquote(token.mid(colon + 1));
+
+        // fields without a value are ignored while typing
+
+        if (node.text.isEmpty())
+            return Node();
+
+        if (isNumericField(node.field))
+        {
+            node.type = parseRange(node.field, node.text, node.min, node.max) ? Node::Type::RANGE : Node::Type::NONE;
+            node.text = token.toLower();
+        }
+
+        node.folded_text = AudioLibrarySearchIndex::foldText(node.text);
+        return node;
+    }
+
+    Node combine(Node::Type type, std::vector<Node> children)
+    {
+        if (children.size() == 1)
+            return std::move(children.front());
+
+        Node node;
+
+        if (!children.empty())
+        {
+            node.type = type;
+            node.children = std::move(children);
+        }
+
+        return node;
+    }
+
+    /**
+    * Recursive descent, NOT binds stronger than AND, which binds stronger than OR.
+    */
+    class Parser
+    {
+    public:
+        explicit Parser(std::vector<QString> tokens) : _tokens(std::move(tokens)) {}
+
+        Node parse()
+        {
+            std::vector<Node> children;
+
+            while (!atEnd())
+            {
+                // superfluous closing parentheses are skipped
+
+                if (peek() == ")")
+                {
+                    ++_pos;
+                    continue;
+                }
+
+                Node child = parseOr();
+                if (child.type != Node::Type::ALL)
+                    children.push_back(std::move(child));
+            }
+
+            return combine(Node::Type::AND, std::move(children));
+        }
+
+    private:
+        bool atEnd() const { return _pos >= _tokens.size(); }
+        const QString& peek() const { return _tokens[_pos]; }
+
+        Node parseOr()
+        {
+            // operands which are missing or only contain ignored terms are dropped
+
+            std::vector<Node> children;
+
+            while (true)
+            {
+                Node child = parseAnd();
+                if (child.type != Node::Type::ALL)
+                    children.push_back(std::move(child));
+
+                if (atEnd() || !isOrOperator(peek()))
+                    break;
+
+                ++_pos;
+            }
+
+            return combine(Node::Type::OR, std::move(children));
+        }
+
+        Node parseAnd()
+        {
+            std::vector<Node> children;
+
+            while (!atEnd() && peek() != ")" && !isOrOperator(peek()))
+            {
+                if (isAndOperator(peek()))
+                {
+                    ++_pos;
+                    continue;
+                }
+
+                Node child = parseUnary();
+                if (child.type != Node::Type::ALL)
+                    children.push_back(std::move(child));
+            }
+
+            return combine(Node::Type::AND, std::move(children));
+        }
+
+        Node parseUnary()
+        {
+            if (isNotOperator(peek()))
+            {
+                ++_pos;
+
+                if (atEnd() || peek() == ")" || isOrOperator(peek()))
+                    return Node();
+
+                return negate(parseUnary());
+            }
+
+            if (peek() == "(")
+            {
+                ++_pos;
+
+                Node node = parseOr();
+
+                if (!atEnd() && peek() == ")")
+                    ++_pos;
+
+                return node;
+            }
+
+            const QString& token = _tokens[_pos++];
+
+            if (token.startsWith('!'))
+                return negate(createTerm(token.mid(1)));
+
+            return createTerm(token);
+        }
+
+        static Node negate(Node child)
+        {
+            if (child.type == Node::Type::ALL)
+                return child;
+
+            Node node;
+            node.type = Node::Type::NOT;
+            node.children.push_back(std::move(child));
+            return node;
+        }
+
+        std::vector<QString> _tokens;
+        size_t _pos = 0;
+    };
+
+    qint64 getNumericValue(const AudioLibraryTrack* track, Field field)
+    {
+        switch (field)
+        {
+        case Field::YEAR: return track->getAlbum()->getKey().getYear();
+        case Field::BITRATE: return track->getBitrateKbs();
+        case Field::LENGTH: return track->getLengthMs() / 1000;
+        case Field::TRACK_NUMBER: return track->getTrackNumber();
+        case Field::DISC_NUMBER: return track->getDiscNumber();
+        case Field::SAMPLERATE: return track->getSampleRateHz();
+        case Field::CHANNELS: return track->getChannels();
+        default: return 0;
+        }
+    }
+
+    /**
+    * The search text is folded, so the precomputed folded fields can be searched with a plain comparison.
+    * Comments and paths are rarely searched and get folded on the fly.
+    */
+    bool matchesText(const AudioLibraryTrack* track, Field field, const QString& folded_search_text, QStringView folded_default_text)
+    {
+        using TrackField = AudioLibrarySearchIndex::TrackField;
+        using AlbumField = AudioLibrarySearchIndex::AlbumField;
+
+        switch (field)
+        {
+        case Field::DEFAULT: return containsSubstring(folded_default_text, folded_search_text);
+        case Field::ARTIST: return containsSubstring(track->getFoldedText(TrackField::ARTIST), folded_search_text) || containsSubstring(track->getFoldedText(TrackField::ALBUM_ARTIST), folded_search_text);
+        case Field::ALBUM: return containsSubstring(track->getAlbum()->getFoldedText(AlbumField::ALBUM), folded_search_text);
+        case Field::TITLE: return containsSubstring(track->getFoldedText(TrackField::TITLE), folded_search_text);
+        case Field::GENRE: return containsSubstring(track->getAlbum()->getFoldedText(AlbumField::GENRE), folded_search_text);
+        case Field::COMMENT: return containsSubstring(AudioLibrarySearchIndex::foldText(track->getComment()), folded_search_text);
+        case Field::PATH: return containsSubstring(AudioLibrarySearchIndex::foldText(track->getFilepath()), folded_search_text);
+        default: return false;
+        }
+    }
+
+    bool matchesNode(const Node& node, const AudioLibraryTrack* track, QStringView default_text)
+    {
+        switch (node.type)
+        {
+        case Node::Type::ALL:
+            return true;
+        case Node::Type::NONE:
+            return false;
+        case Node::Type::AND:
+            return std::ranges::all_of(node.children, [track, &default_text](const Node& child) { return matchesNode(child, track, default_text); });
+        case Node::Type::OR:
+            return std::ranges::any_of(node.children, [track, &default_text](const Node& child) { return matchesNode(child, track, default_text); });
+        case Node::Type::NOT:
+            return !matchesNode(node.children.front(), track, default_text);
+        case Node::Type::TEXT:
+            return matchesText(track, node.field, node.folded_text, default_text);
+        case Node::Type::RANGE:
+        {
+            const qint64 value = getNumericValue(track, node.field);
+            return value >= node.min && value <= node.max;
+        }
+        }
+
+        return false;
+    }
+
+    void appendTracks(const std::vector<const AudioLibraryAlbum*>& albums, std::vector<const AudioLibraryTrack*>& tracks)
+    {
+        for (const AudioLibraryAlbum* album : albums)
+            tracks.insert(tracks.end(), album->getTracks().begin(), album->getTracks().end());
+    }
+
+    /**
+    * Scans the column of a numeric field for the tracks in the range of the node.
+    */
+    std::vector<const AudioLibraryTrack*> findTracksInRange(const Node& node, const AudioLibraryTrackTable& track_table)
+    {
+        using Column = AudioLibraryTrackTable::Column;
+
+        // the columns hold 32 bit values, so clamping the range doesn't change the result
+
+        const qint64 min = std::clamp<qint64>(node.min, std::numeric_limits<qint32>::min(), std::numeric_limits<qint32>::max());
+        const qint64 max = std::clamp<qint64>(node.max, std::numeric_limits<qint32>::min(), std::numeric_limits<qint32>::max());
+
+        switch (node.field)
+        {
+        case Field::YEAR: return track_table.findTracks(Column::YEAR, min, max);
+        case Field::BITRATE: return track_table.findTracks(Column::BITRATE_KBS, min, max);
+        case Field::LENGTH: return track_table.findTracks(Column::LENGTH_MS, min * 1000, max * 1000 + 999); // whole seconds, like getNumericValue
+        case Field::TRACK_NUMBER: return track_table.findTracks(Column::TRACK_NUMBER, min, max);
+        case Field::DISC_NUMBER: return track_table.findTracks(Column::DISC_NUMBER, min, max);
+        case Field::SAMPLERATE: return track_table.findTracks(Column::SAMPLERATE_HZ, min, max);
+        case Field::CHANNELS: return track_table.findTracks(Column::CHANNELS, min, max);
+        default: return {};
+        }
+    }
+
+    /**
+    * Returns nullopt if the node can't be answered by the search index or the track table. The result may contain duplicates.
+    */
+    std::optional<std::vector<const AudioLibraryTrack*>> findIndexedTracks(const Node& node, Field default_field, const AudioLibrary& library)
+    {
+        const AudioLibrarySearchIndex& search_index = library.getSearchIndex();
+
+        switch (node.type)
+        {
+        case Node::Type::NONE:
+            return std::vector<const AudioLibraryTrack*>();
+        case Node::Type::AND:
+        {
+            // any child narrows the result, the smallest one is the best
+
+            std::optional<std::vector<const AudioLibraryTrack*>> result;
+
+            for (const Node& child : node.children)
+            {
+                auto tracks = findIndexedTracks(child, default_field, library);
+                if (tracks && (!result || tracks->size() < result->size()))
+                    result = std::move(tracks);
+            }
+
+            return result;
+        }
+        case Node::Type::OR:
+        {
+            std::vector<const AudioLibraryTrack*> result;
+
+            for (const Node& child : node.children)
+            {
+                auto tracks = findIndexedTracks(child, default_field, library);
+                if (!tracks)
+                    return std::nullopt;
+
+                result.insert(result.end(), tracks->begin(), tracks->end());
+            }
+
+            return result;
+        }
+        case Node::Type::TEXT:
+        {
+            const std::vector<QString> words = { node.text };
+            std::vector<const AudioLibraryTrack*> result;
+
+            switch (node.field == Field::DEFAULT ? default_field : node.field)
+            {
+            case Field::ARTIST:
+                result = search_index.findTracks(AudioLibrarySearchIndex::TrackField::ARTIST, words, {});
+                for (const AudioLibraryTrack* track : search_index.findTracks(AudioLibrarySearchIndex::TrackField::ALBUM_ARTIST, words, {}))
+                    result.push_back(track);
+                return result;
+            case Field::TITLE:
+                return search_index.findTracks(AudioLibrarySearchIndex::TrackField::TITLE, words, {});
+            case Field::ALBUM:
+                appendTracks(search_index.findAlbums(AudioLibrarySearchIndex::AlbumField::ALBUM, words, {}), result);
+                return result;
+            case Field::GENRE:
+                appendTracks(search_index.findAlbums(AudioLibrarySearchIndex::AlbumField::GENRE, words, {}), result);
+                return result;
+            default:
+                return std::nullopt;
+            }
+        }
+        case Node::Type::RANGE:
+            return findTracksInRange(node, library.getTrackTable());
+        case Node::Type::ALL:
+        case Node::Type::NOT:
+            break;
+        }
+
+        return std::nullopt;
+    }
+
+    QString formatNode(const Node& node)
+    {
+        switch (node.type)
+        {
+        case Node::Type::ALL:
+            return QString();
+        case Node::Type::AND:
+        case Node::Type::OR:
+        {
+            QStringList result;
+
+            for (const Node& child : node.children)
+            {
+                const bool needs_parentheses = child.type == Node::Type::OR || (child.type == Node::Type::AND && node.type == Node::Type::OR);
+                result.push_back(needs_parentheses ? '(' + formatNode(child) + ')' : formatNode(child));
+            }
+
+            return result.join(node.type == Node::Type::AND ? QString(", ") : QObject::tr(" or "));
+        }
+        case Node::Type::NOT:
+            return QObject::tr("not %1").arg(formatNode(node.children.front()));
+        case Node::Type::TEXT:
+        {
+            const QString quoted_text = '\"' + node.text + '\"';
+
+            if (node.field == Field::DEFAULT)
+                return quoted_text;
+
+            auto found = std::ranges::find_if(FIELD_NAMES, [&node](const std::pair<QString, Field>& i) { return i.second == node.field; });
+            return found->first + ':' + quoted_text;
+        }
+        case Node::Type::NONE:
+        case Node::Type::RANGE:
+            return node.text;
+        }
+
+        return QString();
+    }
+}
+
+//=============================================================================
+
+AudioLibraryQuery::AudioLibraryQuery(const QString& text, Field default_field)
+    : _root(Parser(tokenize(text)).parse())
+    , _default_field(default_field)
+{
+}
+
+bool AudioLibraryQuery::isEmpty() const
+{
+    return _root.type == Node::Type::ALL;
+}
+
+std::vector<const AudioLibraryTrack*> AudioLibraryQuery::findCandidates(const AudioLibrary& library) const
+{
+    if (auto tracks = findIndexedTracks(_root, _default_field, library))
+    {
+        // the index may find a track several times, in no particular order. The tracks are sorted like the library
+        // visits them, by album and by their position in the album, so the views don't depend on the order of addresses.
+
+        std::ranges::sort(*tracks, [](const AudioLibraryTrack* a, const AudioLibraryTrack* b) {
+            if (a->getAlbum() != b->getAlbum())
+                return a->getAlbum()->getKey() < b->getAlbum()->getKey();
+
+            return a->getAlbumIndex() < b->getAlbumIndex();
+        });
+
+        tracks->erase(std::ranges::unique(*tracks).begin(), tracks->end());
+        return std::move(*tracks);
+    }
+
+    std::vector<const AudioLibraryTrack*> tracks;
+    tracks.reserve(library.getNumberOfTracks());
+
+    for (const AudioLibraryAlbum* album : library.getAlbums())
+        tracks.insert(tracks.end(), album->getTracks().begin(), album->getTracks().end());
+
+    return tracks;
+}
+
+bool AudioLibraryQuery::matches(const AudioLibraryTrack* track, QStringView folded_default_text) const
+{
+    return matchesNode(_root, track, folded_default_text);
+}
+
+QString AudioLibraryQuery::format() const
+{
+    return formatNode(_root);
+}
\ No newline at end of file
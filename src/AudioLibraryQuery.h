@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <vector>
+#include <QtCore/qstring.h>
+
+class AudioLibrary;
+class AudioLibraryTrack;
+
+/**
+* Filter expression of the views, compiled from the text of the filter box.
+*
+* Words without a field are searched in the field which the view shows, e.g. the title in the track view.
+* Other fields are selected with a prefix, like `artist:guardian` or `path:"/music/live"`.
+* Numeric fields take a value, a comparison or a range: `year:1990..1999`, `bitrate:>256`, `length:<3m`.
+* Terms are combined with AND unless there's an OR in between, parentheses group them.
+* `!` or NOT in front of a term or group negates it. Quotes make a phrase out of several words.
+*
+* The query doesn't fail on incomplete input, because it's evaluated while typing. Unknown prefixes are
+* part of the word, missing parentheses are added and a numeric term with an invalid value matches nothing.
+*/
+class AudioLibraryQuery
+{
+public:
+    enum class Field
+    {
+        DEFAULT,
+        ARTIST,         //!< artist or album artist
+        ALBUM,
+        TITLE,
+        GENRE,
+        COMMENT,
+        PATH,
+        YEAR,
+        BITRATE,        //!< kbit/s
+        LENGTH,         //!< seconds
+        TRACK_NUMBER,
+        DISC_NUMBER,
+        SAMPLERATE,     //!< Hz
+        CHANNELS,
+    };
+
+    /**
+    * The default field must be one of the text fields, it decides which search index answers the words without a field.
+    */
+    AudioLibraryQuery(const QString& text, Field default_field);
+
+    bool isEmpty() const;
+
+    /**
+    * Returns the tracks which might match, without duplicates. The positive text terms are looked up in the
+    * search index of the library and numeric terms in its track table, if that isn't possible, all tracks are returned.
+    */
+    std::vector<const AudioLibraryTrack*> findCandidates(const AudioLibrary& library) const;
+
+    /**
+    * Words without a field are searched in folded_default_text, which is one of the folded fields of the track or its album.
+    */
+    bool matches(const AudioLibraryTrack* track, QStringView folded_default_text) const;
+
+    QString format() const;
+
+    struct Node
+    {
+        enum class Type
+        {
+            ALL,
+            NONE,
+            AND,
+            OR,
+            NOT,
+            TEXT,
+            RANGE,
+        };
+
+        Type type = Type::ALL;
+        Field field = Field::DEFAULT;
+        QString text;       //!< search text or the source of a range
+        QString folded_text;
+        qint64 min = 0;
+        qint64 max = 0;
+        std::vector<Node> children;
+    };
+
+private:
+    Node _root;
+    Field _default_field;
+};
\ No newline at end of file
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "AudioLibraryRowSet.h"
+
+#include <QtCore/qlocale.h>
+
+AudioLibraryRowSet::Row::Row(const Row& other)
+    : id(other.id)
+    , display_role_data(other.display_role_data)
+    , sort_role_data(other.sort_role_data)
+    , multiline_display_role(other.multiline_display_role)
+    , view(other.view ? other.view->clone() : nullptr)
+    , decoration_album_id(other.decoration_album_id)
+    , decoration_cover(other.decoration_cover)
+    , group_name(other.group_name)
+    , number_of_albums(other.number_of_albums)
+    , number_of_tracks(other.number_of_tracks)
+{
+}
+
+AudioLibraryRowSet::Row& AudioLibraryRowSet::Row::operator=(const Row& other)
+{
+    *this = Row(other);
+    return *this;
+}
+
+//=============================================================================
+
+AudioLibraryRowSet::AudioLibraryRowSet(const std::atomic_bool* cancel_flag)
+    : _cancel_flag(cancel_flag)
+{
+}
+
+void AudioLibraryRowSet::addGroupItem(const QString& name, const AudioLibraryAlbum* showcase_album, int number_of_albums, int number_of_tracks, const std::function<std::unique_ptr<AudioLibraryView>()>& view_factory)
+{
+    if (isCanceled())
+        return;
+
+    Row& row = createRow(QUuid(), showcase_album);
+
+    row.group_name = name;
+    row.number_of_albums = number_of_albums;
+    row.number_of_tracks = number_of_tracks;
+
+    setData(row, AudioLibraryView::ZERO, name);
+    setData(row, AudioLibraryView::NUMBER_OF_ALBUMS, QString::number(number_of_albums));
+    setData(row, AudioLibraryView::NUMBER_OF_TRACKS, QString::number(number_of_tracks));
+
+    row.view = view_factory();
+}
+
+void AudioLibraryRowSet::addAlbumItem(const AudioLibraryAlbum* album)
+{
+    if (isCanceled())
+        return;
+
+    Row& row = createRow(album->getUuid(), album);
+
+    QLatin1Char sep(' ');
+
+    QString sort_key = album->getKey().getArtist() + sep +
+        QString::number(album->getKey().getYear()) + sep +
+        album->getKey().getAlbum();
+
+    setData(row, AudioLibraryView::ZERO, album->getKey().getArtist() + " - " + album->getKey().getAlbum());
+    setData(row, AudioLibraryView::ZERO, album->getKey().getArtist() + QChar(QChar::LineSeparator) + album->getKey().getAlbum(), AudioLibraryView::MULTILINE_DISPLAY_ROLE);
+    setData(row, AudioLibraryView::ZERO, sort_key, AudioLibraryView::SORT_ROLE);
+
+    setAlbumColumns(row, album);
+    setData(row, AudioLibraryView::ARTIST, album->getKey().getArtist());
+    setData(row, AudioLibraryView::NUMBER_OF_TRACKS, QString::number(album->getTracks().size()));
+
+    int length_milliseconds = 0;
+    for (const AudioLibraryTrack* track : album->getTracks())
+        length_milliseconds += track->getLengthMs();
+
+    setLengthColumn(row, length_milliseconds);
+
+    row.view = std::make_unique<AudioLibraryViewAlbum>(album->getKey());
+}
+
+void AudioLibraryRowSet::addTrackItem(const AudioLibraryTrack* track)
+{
+    if (isCanceled())
+        return;
+
+    Row& row = createRow(track->getUuid(), track->getAlbum());
+
+    QLatin1Char sep(' ');
+
+    QString sort_key = track->getAlbum()->getKey().getArtist() + sep +
+        QString::number(track->getAlbum()->getKey().getYear()) + sep +
+        track->getAlbum()->getKey().getAlbum() + sep +
+        QString::number(track->getDiscNumber()) + sep +
+        QString::number(track->getTrackNumber());
+
+    setData(row, AudioLibraryView::ZERO, track->getArtist() + " - " + track->getTitle());
+    setData(row, AudioLibraryView::ZERO, track->getArtist() + QChar(QChar::LineSeparator) + track->getTitle(), AudioLibraryView::MULTILINE_DISPLAY_ROLE);
+    setData(row, AudioLibraryView::ZERO, sort_key, AudioLibraryView::SORT_ROLE);
+
+    setAlbumColumns(row, track->getAlbum());
+    setData(row, AudioLibraryView::ARTIST, track->getArtist());
+    setData(row, AudioLibraryView::TITLE, track->getTitle());
+    if(track->getTrackNumber() != 0)
+        setData(row, AudioLibraryView::TRACK_NUMBER, QString::number(track->getTrackNumber()));
+    if(track->getDiscNumber() != 0)
+        setData(row, AudioLibraryView::DISC_NUMBER, QString::number(track->getDiscNumber()));
+    setData(row, AudioLibraryView::ALBUM_ARTIST, track->getAlbumArtist());
+    setData(row, AudioLibraryView::COMMENT, track->getComment());
+    setData(row, AudioLibraryView::PATH, track->getFilepath());
+    setDateTimeColumn(row, AudioLibraryView::DATE_MODIFIED, track->getLastModified());
+    QString file_size = QLocale().formattedDataSize(track->getFileSize());
+    setData(row, AudioLibraryView::FILE_SIZE, file_size);
+    setData(row, AudioLibraryView::FILE_SIZE, QString::number(track->getFileSize()), AudioLibraryView::SORT_ROLE);
+    setData(row, AudioLibraryView::TAG_TYPES, track->getTagTypes());
+    setLengthColumn(row, track->getLengthMs());
+    setData(row, AudioLibraryView::CHANNELS, QString::number(track->getChannels()));
+    setData(row, AudioLibraryView::BITRATE_KBS, QString::number(track->getBitrateKbs()) + QLatin1String(" kbit/s"));
+    setData(row, AudioLibraryView::SAMPLERATE_HZ, QString::number(track->getSampleRateHz()) + QLatin1String(" Hz"));
+
+    // no view for track items
+}
+
+bool AudioLibraryRowSet::isCanceled() const
+{
+    return _cancel_flag && *_cancel_flag;
+}
+
+size_t AudioLibraryRowSet::size() const
+{
+    return _rows.size();
+}
+
+std::vector<AudioLibraryRowSet::Row> AudioLibraryRowSet::takeRows()
+{
+    return std::move(_rows);
+}
+
+AudioLibraryRowSet::Row& AudioLibraryRowSet::createRow(const QUuid& id, const AudioLibraryAlbum* decoration_album)
+{
+    Row& row = _rows.emplace_back();
+    row.id = id;
+    row.decoration_album_id = decoration_album->getUuid();
+    row.decoration_cover = decoration_album->getCover();
+    return row;
+}
+
+void AudioLibraryRowSet::setData(Row& row, AudioLibraryView::Column column, const QString& data, int role)
+{
+    if (role == Qt::DisplayRole)
+    {
+        row.display_role_data[column] = data;
+        row.sort_role_data[column] = data;
+    }
+    else if (role == AudioLibraryView::MULTILINE_DISPLAY_ROLE && column == AudioLibraryView::ZERO)
+    {
+        row.multiline_display_role = data;
+    }
+    else if (role == AudioLibraryView::SORT_ROLE)
+    {
+        row.sort_role_data[column] = data;
+    }
+}
+
+void AudioLibraryRowSet::setDateTimeColumn(Row& row, AudioLibraryView::Column column, const QDateTime& date)
+{
+    setData(row, column, QLocale::system().toString(date, QLocale::ShortFormat));
+    setData(row, column, date.toString(Qt::ISODate), AudioLibraryView::SORT_ROLE);
+}
+
+void AudioLibraryRowSet::setLengthColumn(Row& row, int length_milliseconds)
+{
+    int length_seconds = length_milliseconds / 1000;
+
+    QTime length_time = QTime(0, 0).addMSecs(length_milliseconds);
+
+    QString formatted_length = length_time.toString(length_seconds < 3600 ? "mm:ss" : "hh:mm:ss");
+
+    setData(row, AudioLibraryView::LENGTH_SECONDS, formatted_length);
+    setData(row, AudioLibraryView::LENGTH_SECONDS, QString::number(length_seconds), AudioLibraryView::SORT_ROLE);
+}
+
+void AudioLibraryRowSet::setAlbumColumns(Row& row, const AudioLibraryAlbum* album)
+{
+    setData(row, AudioLibraryView::ALBUM, album->getKey().getAlbum());
+
+    if (album->getKey().getYear() != 0)
+        setData(row, AudioLibraryView::YEAR, QString::number(album->getKey().getYear()));
+
+    setData(row, AudioLibraryView::GENRE, album->getKey().getGenre());
+
+    if (!album->getCover().isEmpty())
+    {
+        setData(row, AudioLibraryView::COVER_CHECKSUM, QString::number(album->getKey().getCoverChecksum()));
+
+        QString data_size = QLocale().formattedDataSize(album->getCover().data_size);
+
+        setData(row, AudioLibraryView::COVER_DATASIZE, data_size);
+        setData(row, AudioLibraryView::COVER_DATASIZE, QString::number(album->getCover().data_size), AudioLibraryView::SORT_ROLE);
+    }
+
+    setData(row, AudioLibraryView::COVER_TYPE, album->getCoverType());
+
+    setData(row, AudioLibraryView::COVER_WIDTH, QString::number(album->getCoverSize().width()));
+    setData(row, AudioLibraryView::COVER_HEIGHT, QString::number(album->getCoverSize().height()));
+}
\ No newline at end of file
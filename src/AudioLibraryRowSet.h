@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include "AudioLibraryView.h"
+
+/**
+* The rows of a view as created by AudioLibraryView::createItems, before they are added to an AudioLibraryModel.
+*
+* The rows hold copies of everything they display and no pointers into the library. So they can be built on
+* a background thread, and they stay valid if the library changes before they are added to the model.
+*/
+class AudioLibraryRowSet
+{
+public:
+    struct Row
+    {
+        Row() = default;
+        Row(const Row& other);  //!< clones the view
+        Row& operator=(const Row& other);
+        Row(Row&& other) = default;
+        Row& operator=(Row&& other) = default;
+
+        QUuid id;                       //!< null for groups, their uuid is assigned by the model
+        std::array<QVariant, AudioLibraryView::NUMBER_OF_COLUMNS> display_role_data;
+        std::array<QString, AudioLibraryView::NUMBER_OF_COLUMNS> sort_role_data;
+        QVariant multiline_display_role;
+        std::unique_ptr<AudioLibraryView> view;
+
+        QUuid decoration_album_id;
+        CoverLocation decoration_cover;
+
+        // groups only
+        QString group_name;
+        int number_of_albums = 0;
+        int number_of_tracks = 0;
+    };
+
+    /**
+    * Once the cancel flag is set, no more rows are added.
+    */
+    explicit AudioLibraryRowSet(const std::atomic_bool* cancel_flag = nullptr);
+
+    void addGroupItem(const QString& name, const AudioLibraryAlbum* showcase_album, int number_of_albums, int number_of_tracks, const std::function<std::unique_ptr<AudioLibraryView>()>& view_factory);
+    void addAlbumItem(const AudioLibraryAlbum* album);
+    void addTrackItem(const AudioLibraryTrack* track);
+
+    bool isCanceled() const;
+    size_t size() const;
+
+    std::vector<Row> takeRows();
+
+private:
+    Row& createRow(const QUuid& id, const AudioLibraryAlbum* decoration_album);
+    static void setData(Row& row, AudioLibraryView::Column column, const QString& data, int role = Qt::DisplayRole);
+    static void setDateTimeColumn(Row& row, AudioLibraryView::Column column, const QDateTime& date);
+    static void setLengthColumn(Row& row, int length_milliseconds);
+    static void setAlbumColumns(Row& row, const AudioLibraryAlbum* album);
+
+    const std::atomic_bool* _cancel_flag;
+    std::vector<Row> _rows;
+};
\ No newline at end of file
@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "AudioLibrarySearchIndex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include "AudioLibrary.h"
+#include "MemoryUsage.h"
+#include "SubstringSearch.h"
+
+namespace {
+
+    std::vector<quint64> getTrigrams(const QString& folded_text)
+    {
+        std::vector<quint64> trigrams;
+
+        for (qsizetype i = 0; i + 2 < folded_text.size(); ++i)
+        {
+            trigrams.push_back(quint64(folded_text[i].unicode()) << 32 |
+                quint64(folded_text[i + 1].unicode()) << 16 |
+                quint64(folded_text[i + 2].unicode()));
+        }
+
+        std::ranges::sort(trigrams);
+        trigrams.erase(std::ranges::unique(trigrams).begin(), trigrams.end());
+
+        return trigrams;
+    }
+
+    std::vector<QString> foldWords(const std::vector<QString>& words)
+    {
+        std::vector<QString> result;
+        result.reserve(words.size());
+
+        for (const QString& word : words)
+            result.push_back(AudioLibrarySearchIndex::foldText(word));
+
+        return result;
+    }
+}
+
+//=============================================================================
+
+template<class ITEM, class FIELD>
+void AudioLibrarySearchIndex::FieldIndex<ITEM, FIELD>::add(FIELD field, const QString& value, QStringView folded_value, ITEM item)
+{
+    auto found = _value_to_entry.find(value);
+    if (found != _value_to_entry.end())
+    {
+        std::vector<ITEM>& items = _entries[found->second].items;
+        item->setSearchIndexPosition(field, static_cast<quint32>(items.size()));
+        items.push_back(item);
+        return;
+    }
+
+    quint32 entry_index;
+
+    if (!_free_entries.empty())
+    {
+        entry_index = _free_entries.back();
+        _free_entries.pop_back();
+    }
+    else
+    {
+        entry_index = static_cast<quint32>(_entries.size());
+        _entries.emplace_back();
+    }
+
+    Entry& entry = _entries[entry_index];
+    entry.folded_value = folded_value.toString();
+    item->setSearchIndexPosition(field, 0);
+    entry.items.push_back(item);
+
+    _value_to_entry[value] = entry_index;
+
+    // new entries are usually appended, reused ones have to be sorted in
+
+    for (quint64 trigram : getTrigrams(entry.folded_value))
+    {
+        std::vector<quint32>& entries = _trigram_to_entries[trigram];
+
+        if (entries.empty() || entries.back() < entry_index)
+            entries.push_back(entry_index);
+        else
+            entries.insert(std::ranges::lower_bound(entries, entry_index), entry_index);
+    }
+}
+
+template<class ITEM, class FIELD>
+void AudioLibrarySearchIndex::FieldIndex<ITEM, FIELD>::remove(FIELD field, const QString& value, ITEM item)
+{
+    auto found = _value_to_entry.find(value);
+    if (found == _value_to_entry.end())
+        return;
+
+    const quint32 entry_index = found->second;
+    Entry& entry = _entries[entry_index];
+
+    // the last item is moved into the place of the removed one, the order of the items doesn't matter
+
+    const quint32 position = item->getSearchIndexPosition(field);
+    if (position >= entry.items.size() || entry.items[position] != item)
+    {
+        // not in the index, shouldn't happen
+        assert(false);
+        return;
+    }
+
+    ITEM last_item = entry.items.back();
+    last_item->setSearchIndexPosition(field, position);
+    entry.items[position] = last_item;
+    entry.items.pop_back();
+
+    if (!entry.items.empty())
+        return;
+
+    for (quint64 trigram : getTrigrams(entry.folded_value))
+    {
+        auto trigram_entries = _trigram_to_entries.find(trigram);
+        if (trigram_entries == _trigram_to_entries.end())
+            continue;
+
+        std::vector<quint32>& entries = trigram_entries->second;
+        auto it = std::ranges::lower_bound(entries, entry_index);
+        if (it != entries.end() && *it == entry_index)
+            entries.erase(it);
+
+        if (entries.empty())
+            _trigram_to_entries.erase(trigram_entries);
+    }
+
+    entry = Entry();
+    _free_entries.push_back(entry_index);
+    _value_to_entry.erase(found);
+}
+
+template<class ITEM, class FIELD>
+void AudioLibrarySearchIndex::FieldIndex<ITEM, FIELD>::clear()
+{
+    _entries.clear();
+    _free_entries.clear();
+    _value_to_entry.clear();
+    _trigram_to_entries.clear();
+}
+
+template<class ITEM, class FIELD>
+void AudioLibrarySearchIndex::FieldIndex<ITEM, FIELD>::replaceItems(const std::unordered_map<ITEM, ITEM>& items)
+{
+    for (Entry& entry : _entries)
+        for (ITEM& item : entry.items)
+            item = items.at(item);
+}
+
+template<class ITEM, class FIELD>
+std::vector<ITEM> AudioLibrarySearchIndex::FieldIndex<ITEM, FIELD>::find(const std::vector<QString>& words, const std::vector<QString>& forbidden_words) const
+{
+    const std::vector<QString> folded_words = foldWords(words);
+    const std::vector<QString> folded_forbidden_words = foldWords(forbidden_words);
+
+    // collect the entry lists of all trigrams, a missing trigram means that nothing can match
+
+    std::vector<const std::vector<quint32>*> trigram_entries;
+
+    for (const QString& word : folded_words)
+    {
+        for (quint64 trigram : getTrigrams(word))
+        {
+            auto found = _trigram_to_entries.find(trigram);
+            if (found == _trigram_to_entries.end())
+                return {};
+
+            trigram_entries.push_back(&found->second);
+        }
+    }
+
+    std::vector<quint32> candidates;
+
+    if (trigram_entries.empty())
+    {
+        for (quint32 i = 0; i < _entries.size(); ++i)
+            if (!_entries[i].items.empty())
+                candidates.push_back(i);
+    }
+    else
+    {
+        // intersect starting with the shortest list, so that the candidates only get fewer
+
+        std::ranges::sort(trigram_entries, {}, [](const std::vector<quint32>* entries) { return entries->size(); });
+
+        candidates = *trigram_entries.front();
+
+        std::vector<quint32> intersection;
+
+        for (size_t i = 1; i < trigram_entries.size() && !candidates.empty(); ++i)
+        {
+            intersection.clear();
+            std::ranges::set_intersection(candidates, *trigram_entries[i], std::back_inserter(intersection));
+            candidates.swap(intersection);
+        }
+    }
+
+    // the trigrams don't tell their order, so the candidates need to be verified
+
+    std::vector<ITEM> result;
+
+    for (quint32 entry_index : candidates)
+    {
+        const Entry& entry = _entries[entry_index];
+
+        const bool matches = std::ranges::all_of(folded_words, [&entry](const QString& word) {
+            return containsSubstring(entry.folded_value, word);
+        }) && std::ranges::none_of(folded_forbidden_words, [&entry](const QString& word) {
+            return containsSubstring(entry.folded_value, word);
+        });
+
+        if (matches)
+            result.insert(result.end(), entry.items.begin(), entry.items.end());
+    }
+
+    return result;
+}
+
+template<class ITEM, class FIELD>
+size_t AudioLibrarySearchIndex::FieldIndex<ITEM, FIELD>::getMemoryUsage(MemoryUsageCounter& counter) const
+{
+    size_t result = MemoryUsageCounter::vectorSize(_entries) +
+        MemoryUsageCounter::vectorSize(_free_entries) +
+        MemoryUsageCounter::hashMapSize(_value_to_entry) +
+        MemoryUsageCounter::hashMapSize(_trigram_to_entries);
+
+    for (const Entry& entry : _entries)
+        result += counter.addString(entry.folded_value) + MemoryUsageCounter::vectorSize(entry.items);
+
+    for (const auto& value_and_entry : _value_to_entry)
+        result += counter.addString(value_and_entry.first);
+
+    for (const auto& trigram_and_entries : _trigram_to_entries)
+        result += MemoryUsageCounter::vectorSize(trigram_and_entries.second);
+
+    return result;
+}
+
+//=============================================================================
+
+QString AudioLibrarySearchIndex::foldText(const QString& text)
+{
+    // most tags are plain ASCII, which has nothing to decompose
+
+    const bool is_ascii = std::ranges::all_of(text, [](QChar c) { return c.unicode() < 0x80; });
+    if (is_ascii)
+        return text.toCaseFolded();
+
+    const QString decomposed = text.normalized(QString::NormalizationForm_D);
+
+    QString result;
+    result.reserve(decomposed.size());
+
+    for (QChar c : decomposed)
+        if (c.category() != QChar::Mark_NonSpacing)
+            result += c;
+
+    return result.toCaseFolded();
+}
+
+void AudioLibrarySearchIndex::addTrack(const AudioLibraryTrack* track)
+{
+    _track_fields[size_t(TrackField::ARTIST)].add(TrackField::ARTIST, track->getArtist(), track->getFoldedText(TrackField::ARTIST), track);
+    _track_fields[size_t(TrackField::ALBUM_ARTIST)].add(TrackField::ALBUM_ARTIST, track->getAlbumArtist(), track->getFoldedText(TrackField::ALBUM_ARTIST), track);
+    _track_fields[size_t(TrackField::TITLE)].add(TrackField::TITLE, track->getTitle(), track->getFoldedText(TrackField::TITLE), track);
+}
+
+void AudioLibrarySearchIndex::removeTrack(const AudioLibraryTrack* track)
+{
+    _track_fields[size_t(TrackField::ARTIST)].remove(TrackField::ARTIST, track->getArtist(), track);
+    _track_fields[size_t(TrackField::ALBUM_ARTIST)].remove(TrackField::ALBUM_ARTIST, track->getAlbumArtist(), track);
+    _track_fields[size_t(TrackField::TITLE)].remove(TrackField::TITLE, track->getTitle(), track);
+}
+
+void AudioLibrarySearchIndex::addAlbum(const AudioLibraryAlbum* album)
+{
+    _album_fields[size_t(AlbumField::ARTIST)].add(AlbumField::ARTIST, album->getKey().getArtist(), album->getFoldedText(AlbumField::ARTIST), album);
+    _album_fields[size_t(AlbumField::ALBUM)].add(AlbumField::ALBUM, album->getKey().getAlbum(), album->getFoldedText(AlbumField::ALBUM), album);
+    _album_fields[size_t(AlbumField::GENRE)].add(AlbumField::GENRE, album->getKey().getGenre(), album->getFoldedText(AlbumField::GENRE), album);
+}
+
+void AudioLibrarySearchIndex::removeAlbum(const AudioLibraryAlbum* album)
+{
+    _album_fields[size_t(AlbumField::ARTIST)].remove(AlbumField::ARTIST, album->getKey().getArtist(), album);
+    _album_fields[size_t(AlbumField::ALBUM)].remove(AlbumField::ALBUM, album->getKey().getAlbum(), album);
+    _album_fields[size_t(AlbumField::GENRE)].remove(AlbumField::GENRE, album->getKey().getGenre(), album);
+}
+
+AudioLibrarySearchIndex::AudioLibrarySearchIndex(const AudioLibrarySearchIndex& other,
+    const std::unordered_map<const AudioLibraryTrack*, const AudioLibraryTrack*>& tracks,
+    const std::unordered_map<const AudioLibraryAlbum*, const AudioLibraryAlbum*>& albums)
+    : AudioLibrarySearchIndex(other)
+{
+    for (auto& field : _track_fields)
+        field.replaceItems(tracks);
+
+    for (auto& field : _album_fields)
+        field.replaceItems(albums);
+}
+
+void AudioLibrarySearchIndex::clear()
+{
+    for (auto& field : _track_fields)
+        field.clear();
+
+    for (auto& field : _album_fields)
+        field.clear();
+}
+
+std::vector<const AudioLibraryTrack*> AudioLibrarySearchIndex::findTracks(TrackField field, const std::vector<QString>& words, const std::vector<QString>& forbidden_words) const
+{
+    return _track_fields[size_t(field)].find(words, forbidden_words);
+}
+
+std::vector<const AudioLibraryAlbum*> AudioLibrarySearchIndex::findAlbums(AlbumField field, const std::vector<QString>& words, const std::vector<QString>& forbidden_words) const
+{
+    return _album_fields[size_t(field)].find(words, forbidden_words);
+}
+
+size_t AudioLibrarySearchIndex::getMemoryUsage(MemoryUsageCounter& counter) const
+{
+    size_t result = 0;
+
+    for (const auto& field : _track_fields)
+        result += field.getMemoryUsage(counter);
+
+    for (const auto& field : _album_fields)
+        result += field.getMemoryUsage(counter);
+
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <QtCore/qstring.h>
+
+class AudioLibraryTrack;
+class AudioLibraryAlbum;
+class MemoryUsageCounter;
+
+/**
+* Case-insensitive substring search over the text fields of the library, used by the filtered views and by Find.
+*
+* Each field keeps its distinct values with the tracks or albums that use them. The folded values are split
+* into trigrams, so a query only has to verify the values which contain all trigrams of the search words.
+* Words shorter than three characters can't be looked up and are checked against all distinct values of the field.
+*/
+class AudioLibrarySearchIndex
+{
+public:
+    enum class TrackField
+    {
+        ARTIST,
+        ALBUM_ARTIST,
+        TITLE,
+    };
+
+    enum class AlbumField
+    {
+        ARTIST,
+        ALBUM,
+        GENRE,
+    };
+
+    /**
+    * Case folding without diacritics, e.g. "Ångström" becomes "angstrom". Everything that is searched uses it.
+    */
+    static QString foldText(const QString& text);
+
+    AudioLibrarySearchIndex() = default;
+
+    /**
+    * Copies the index of another library, with its tracks and albums replaced by their copies.
+    */
+    AudioLibrarySearchIndex(const AudioLibrarySearchIndex& other,
+        const std::unordered_map<const AudioLibraryTrack*, const AudioLibraryTrack*>& tracks,
+        const std::unordered_map<const AudioLibraryAlbum*, const AudioLibraryAlbum*>& albums);
+
+    void addTrack(const AudioLibraryTrack* track);
+    void removeTrack(const AudioLibraryTrack* track);
+    void addAlbum(const AudioLibraryAlbum* album);
+    void removeAlbum(const AudioLibraryAlbum* album);
+    void clear();
+
+    /**
+    * Returns all tracks whose field contains each of the words and none of the forbidden words, ignoring case and diacritics.
+    */
+    std::vector<const AudioLibraryTrack*> findTracks(TrackField field, const std::vector<QString>& words, const std::vector<QString>& forbidden_words) const;
+    std::vector<const AudioLibraryAlbum*> findAlbums(AlbumField field, const std::vector<QString>& words, const std::vector<QString>& forbidden_words) const;
+
+    size_t getMemoryUsage(MemoryUsageCounter& counter) const;
+
+private:
+    /**
+    * The items remember their position in the entry of their value, so they can be removed in constant time.
+    */
+    template<class ITEM, class FIELD>
+    class FieldIndex
+    {
+    public:
+        void add(FIELD field, const QString& value, QStringView folded_value, ITEM item);
+        void remove(FIELD field, const QString& value, ITEM item);
+        void clear();
+        void replaceItems(const std::unordered_map<ITEM, ITEM>& items);
+        std::vector<ITEM> find(const std::vector<QString>& words, const std::vector<QString>& forbidden_words) const;
+        size_t getMemoryUsage(MemoryUsageCounter& counter) const;
+
+    private:
+        struct Entry
+        {
+            QString folded_value;
+            std::vector<ITEM> items; //!< empty if the entry is unused
+        };
+
+        std::vector<Entry> _entries;
+        std::vector<quint32> _free_entries;
+        std::unordered_map<QString, quint32> _value_to_entry;
+        std::unordered_map<quint64, std::vector<quint32>> _trigram_to_entries; //!< sorted entry indexes
+    };
+
+    std::array<FieldIndex<const AudioLibraryTrack*, TrackField>, 3> _track_fields;
+    std::array<FieldIndex<const AudioLibraryAlbum*, AlbumField>, 3> _album_fields;
+};
+
+/**
+* Folded copies of the searchable fields of a track or album, computed once when it's created.
+* The fields are stored back to back in one buffer, so searching them needs neither allocations nor case conversions.
+*/
+template<class FIELD, size_t N>
+class FoldedFields
+{
+public:
+    explicit FoldedFields(const std::array<QString, N>& values)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            _text += AudioLibrarySearchIndex::foldText(values[i]);
+            _ends[i] = static_cast<qint32>(_text.size());
+        }
+
+        _text.squeeze();
+    }
+
+    QStringView get(FIELD field) const
+    {
+        const size_t i = static_cast<size_t>(field);
+        const qint32 begin = i == 0 ? 0 : _ends[i - 1];
+        return QStringView(_text).sliced(begin, _ends[i] - begin);
+    }
+
+    const QString& getText() const { return _text; }
+
+private:
+    QString _text;
+    std::array<qint32, N> _ends = {};
+};
\ No newline at end of file
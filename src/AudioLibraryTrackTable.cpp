@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "AudioLibraryTrackTable.h"
+
+#include "AudioLibrary.h"
+#include "MemoryUsage.h"
+
+AudioLibraryTrackTable::AudioLibraryTrackTable(const AudioLibraryTrackTable& other, const std::unordered_map<const AudioLibraryTrack*, const AudioLibraryTrack*>& tracks)
+    : AudioLibraryTrackTable(other)
+{
+    for (const AudioLibraryTrack*& track : _tracks)
+        if (track)
+            track = tracks.at(track);
+}
+
+quint32 AudioLibraryTrackTable::add(const AudioLibraryTrack* track)
+{
+    const std::array<qint32, 7> values = {
+        track->getAlbum()->getKey().getYear(),
+        track->getTrackNumber(),
+        track->getDiscNumber(),
+        track->getLengthMs(),
+        track->getBitrateKbs(),
+        track->getChannels(),
+        track->getSampleRateHz(),
+    };
+
+    const std::array<quint32, 2> string_ids = {
+        addString(track->getArtist()),
+        addString(track->getAlbumArtist()),
+    };
+
+    if (!_free_rows.empty())
+    {
+        const quint32 row = _free_rows.back();
+        _free_rows.pop_back();
+
+        _tracks[row] = track;
+
+        for (size_t i = 0; i < _columns.size(); ++i)
+            _columns[i][row] = values[i];
+
+        for (size_t i = 0; i < _string_columns.size(); ++i)
+            _string_columns[i][row] = string_ids[i];
+
+        return row;
+    }
+
+    _tracks.push_back(track);
+
+    for (size_t i = 0; i < _columns.size(); ++i)
+        _columns[i].push_back(values[i]);
+
+    for (size_t i = 0; i < _string_columns.size(); ++i)
+        _string_columns[i].push_back(string_ids[i]);
+
+    return static_cast<quint32>(_tracks.size() - 1);
+}
+
+void AudioLibraryTrackTable::remove(quint32 row)
+{
+    // the ids of removed strings are reused, so the row must not keep them
+
+    for (std::vector<quint32>& string_column : _string_columns)
+    {
+        removeString(string_column[row]);
+        string_column[row] = NO_STRING;
+    }
+
+    _tracks[row] = nullptr;
+    _free_rows.push_back(row);
+}
+
+void AudioLibraryTrackTable::clear()
+{
+    _tracks.clear();
+    _free_rows.clear();
+
+    for (std::vector<qint32>& column : _columns)
+        column.clear();
+
+    for (std::vector<quint32>& string_column : _string_columns)
+        string_column.clear();
+
+    _strings.clear();
+    _free_strings.clear();
+    _string_to_id.clear();
+}
+
+quint32 AudioLibraryTrackTable::findString(const QString& value) const
+{
+    auto it = _string_to_id.find(value);
+    return it != _string_to_id.end() ? it->second : NO_STRING;
+}
+
+std::vector<const AudioLibraryTrack*> AudioLibraryTrackTable::findTracks(Column column, qint64 min, qint64 max) const
+{
+    const std::vector<qint32>& values = getColumn(column);
+    std::vector<const AudioLibraryTrack*> result;
+
+    for (size_t row = 0; row < values.size(); ++row)
+        if (values[row] >= min && values[row] <= max && _tracks[row])
+            result.push_back(_tracks[row]);
+
+    return result;
+}
+
+size_t AudioLibraryTrackTable::getMemoryUsage(MemoryUsageCounter& counter) const
+{
+    size_t result = MemoryUsageCounter::vectorSize(_tracks) +
+        MemoryUsageCounter::vectorSize(_free_rows) +
+        MemoryUsageCounter::vectorSize(_strings) +
+        MemoryUsageCounter::vectorSize(_free_strings) +
+        MemoryUsageCounter::hashMapSize(_string_to_id);
+
+    for (const std::vector<qint32>& column : _columns)
+        result += MemoryUsageCounter::vectorSize(column);
+
+    for (const std::vector<quint32>& string_column : _string_columns)
+        result += MemoryUsageCounter::vectorSize(string_column);
+
+    for (const StringEntry& entry : _strings)
+        result += counter.addString(entry.value);
+
+    return result;
+}
+
+quint32 AudioLibraryTrackTable::addString(const QString& value)
+{
+    auto it = _string_to_id.find(value);
+    if (it != _string_to_id.end())
+    {
+        ++_strings[it->second].use_count;
+        return it->second;
+    }
+
+    quint32 id = 0;
+
+    if (!_free_strings.empty())
+    {
+        id = _free_strings.back();
+        _free_strings.pop_back();
+        _strings[id] = { value, 1 };
+    }
+    else
+    {
+        id = static_cast<quint32>(_strings.size());
+        _strings.push_back({ value, 1 });
+    }
+
+    _string_to_id.emplace(value, id);
+    return id;
+}
+
+void AudioLibraryTrackTable::removeString(quint32 id)
+{
+    StringEntry& entry = _strings[id];
+
+    if (--entry.use_count == 0)
+    {
+        _string_to_id.erase(entry.value);
+        entry.value.clear();
+        _free_strings.push_back(id);
+    }
+}
\ No newline at end of file
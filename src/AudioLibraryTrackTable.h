@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <QtCore/qstring.h>
+
+class AudioLibraryTrack;
+class MemoryUsageCounter;
+
+/**
+* Columns of the track fields which are scanned over the whole library, e.g. by numeric filters and artist views.
+*
+* Every track has a row, the values of a field are stored back to back, so a scan is a loop over one array
+* instead of a visit to every track object. Strings are stored as ids of a pool with the distinct values.
+* Rows of removed tracks are reused, until then they have no track.
+*/
+class AudioLibraryTrackTable
+{
+public:
+    enum class Column
+    {
+        YEAR,           //!< of the album
+        TRACK_NUMBER,
+        DISC_NUMBER,
+        LENGTH_MS,
+        BITRATE_KBS,
+        CHANNELS,
+        SAMPLERATE_HZ,
+    };
+
+    enum class StringColumn
+    {
+        ARTIST,
+        ALBUM_ARTIST,
+    };
+
+    static constexpr quint32 NO_STRING = 0xffffffff;
+
+    AudioLibraryTrackTable() = default;
+
+    /**
+    * Copies the table of another library, with its tracks replaced by their copies. The rows stay the same.
+    */
+    AudioLibraryTrackTable(const AudioLibraryTrackTable& other, const std::unordered_map<const AudioLibraryTrack*, const AudioLibraryTrack*>& tracks);
+
+    /**
+    * Returns the row of the track.
+    */
+    quint32 add(const AudioLibraryTrack* track);
+    void remove(quint32 row);
+    void clear();
+
+    /**
+    * Including the rows without a track.
+    */
+    size_t getNumberOfRows() const { return _tracks.size(); }
+    const AudioLibraryTrack* getTrack(quint32 row) const { return _tracks[row]; }
+
+    const std::vector<qint32>& getColumn(Column column) const { return _columns[size_t(column)]; }
+    const std::vector<quint32>& getColumn(StringColumn column) const { return _string_columns[size_t(column)]; }
+
+    /**
+    * Returns NO_STRING if no track has the value.
+    */
+    quint32 findString(const QString& value) const;
+
+    /**
+    * Returns the tracks with min <= value <= max in the order of their rows.
+    */
+    std::vector<const AudioLibraryTrack*> findTracks(Column column, qint64 min, qint64 max) const;
+
+    size_t getMemoryUsage(MemoryUsageCounter& counter) const;
+
+private:
+    struct StringEntry
+    {
+        QString value;
+        quint32 use_count = 0; //!< unused if zero
+    };
+
+    quint32 addString(const QString& value);
+    void removeString(quint32 id);
+
+    std::vector<const AudioLibraryTrack*> _tracks;
+    std::vector<quint32> _free_rows;
+    std::array<std::vector<qint32>, 7> _columns;
+    std::array<std::vector<quint32>, 2> _string_columns;
+
+    std::vector<StringEntry> _strings;
+    std::vector<quint32> _free_strings;
+    std::unordered_map<QString, quint32> _string_to_id;
+};
\ No newline at end of file
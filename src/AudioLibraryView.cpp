@@ -1,7 +1,10 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "AudioLibraryView.h"
-#include "AudioLibraryModel.h"
+#include "AudioLibraryRowSet.h"
+#include "AudioLibraryQuery.h"
 
+#include <algorithm>
+#include <thread>
 #include <unordered_set>
 #include <stdexcept>
 
@@ -9,17 +12,17 @@ namespace {
 
     void createAlbumOrTrackRow(const AudioLibraryAlbum* album,
         AudioLibraryView::DisplayMode display_mode,
-        AudioLibraryModel* model)
+        AudioLibraryRowSet& rows)
     {
         switch (display_mode)
         {
         case AudioLibraryView::DisplayMode::ALBUMS:
-            model->addAlbumItem(album);
+            rows.addAlbumItem(album);
             break;
         case AudioLibraryView::DisplayMode::TRACKS:
         {
             for (const AudioLibraryTrack* track : album->getTracks())
-                model->addTrackItem(track);
+                rows.addTrackItem(track);
         }
         break;
         case AudioLibraryView::DisplayMode::ARTISTS:
@@ -74,76 +77,157 @@ namespace {
         group_data.num_tracks += static_cast<int>(album->getTracks().size());
     }
 
-    //=============================================================================
-
     /**
-    * Implements a filter which only lets through text that contains all the specified words.
-    * Word can also be forbidden by adding an exclamation mark in front (negative filter).
+    * Merges the group data of later items, so that the showcase album is the same as if all items were added in order.
     */
-    class FilterHandler
+    void mergeGroupData(AudioLibraryArtistGroupData& group_data, const AudioLibraryArtistGroupData& later_group_data)
     {
-    public:
-        FilterHandler(const QString& filter);
+        if (group_data.showcase_album->getCover().isEmpty())
+            group_data.showcase_album = later_group_data.showcase_album;
 
-        bool checkText(const QString& text) const;
-        QString formatFilterString(const QString& view_name) const;
+        group_data.albums.insert(later_group_data.albums.begin(), later_group_data.albums.end());
+        group_data.num_tracks += later_group_data.num_tracks;
+    }
 
-    private:
-        std::vector<QString> _words;
-        std::vector<QString> _forbidden_words;
-    };
+    void mergeGroupData(AudioLibraryGroupData& group_data, const AudioLibraryGroupData& later_group_data)
+    {
+        if (group_data.showcase_album->getCover().isEmpty())
+            group_data.showcase_album = later_group_data.showcase_album;
+
+        group_data.num_albums += later_group_data.num_albums;
+        group_data.num_tracks += later_group_data.num_tracks;
+    }
 
-    FilterHandler::FilterHandler(const QString& filter)
+    /**
+    * Below this number of items per thread, starting the threads takes longer than aggregating.
+    */
+    const size_t MIN_ITEMS_PER_AGGREGATION_THREAD = 16384;
+
+    /**
+    * Builds the groups of a view. Large inputs are split into contiguous slices which are aggregated on
+    * several threads into maps of their own. The maps are merged in the order of the slices.
+    */
+    template<class GROUP_MAP, class ITEM, class ADD_ITEM>
+    GROUP_MAP aggregateGroups(const std::vector<ITEM>& items, const ADD_ITEM& add_item)
     {
-        for (const QString& word : filter.split(' ',
-#if QT_VERSION >= QT_VERSION_CHECK(5,15,0)
-            Qt::SkipEmptyParts
-#else
-            QString::SkipEmptyParts
-#endif
-            ))
+        const size_t max_thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+        const size_t thread_count = std::clamp<size_t>(items.size() / MIN_ITEMS_PER_AGGREGATION_THREAD, 1, max_thread_count);
+
+        std::vector<GROUP_MAP> slice_groups(thread_count);
+
+        auto aggregateSlice = [&](size_t slice) {
+            const size_t begin = items.size() * slice / thread_count;
+            const size_t end = items.size() * (slice + 1) / thread_count;
+
+            for (size_t i = begin; i < end; ++i)
+                add_item(items[i], slice_groups[slice]);
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t slice = 1; slice < thread_count; ++slice)
+            threads.emplace_back(aggregateSlice, slice);
+
+        aggregateSlice(0);
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        GROUP_MAP groups = std::move(slice_groups[0]);
+
+        for (size_t slice = 1; slice < thread_count; ++slice)
         {
-            if (word.startsWith('!'))
+            for (auto& group : slice_groups[slice])
             {
-                if (word.length() > 1)
-                {
-                    _forbidden_words.push_back(word.right(word.length() - 1));
-                }
-            }
-            else
-            {
-                _words.push_back(word);
+                auto [it, inserted] = groups.try_emplace(group.first, std::move(group.second));
+                if (!inserted)
+                    mergeGroupData(it->second, group.second);
             }
         }
+
+        return groups;
     }
 
-    bool FilterHandler::checkText(const QString& text) const
+    //=============================================================================
+
+    /**
+    * An album matches if one of its tracks matches, words without a field are searched in the given field of the album.
+    */
+    std::vector<const AudioLibraryAlbum*> findAlbums(const AudioLibrary& library, const AudioLibraryQuery& query, AudioLibrarySearchIndex::AlbumField default_field)
     {
-        for (const QString& word : _forbidden_words)
-            if (text.contains(word, Qt::CaseInsensitive))
-                return false;
+        std::vector<const AudioLibraryAlbum*> result;
+        std::unordered_set<const AudioLibraryAlbum*> visited_albums;
 
-        for (const QString& word : _words)
-            if (!text.contains(word, Qt::CaseInsensitive))
-                return false;
+        for (const AudioLibraryTrack* track : query.findCandidates(library))
+        {
+            const AudioLibraryAlbum* album = track->getAlbum();
 
-        return true;
+            if (!visited_albums.contains(album) && query.matches(track, album->getFoldedText(default_field)))
+            {
+                visited_albums.insert(album);
+                result.push_back(album);
+            }
+        }
+
+        return result;
     }
 
-    QString FilterHandler::formatFilterString(const QString& view_name) const
+    /**
+    * Returns the tracks which have the artist as artist or album artist, in the order of the albums.
+    * Only the artist columns of the track table are scanned, the tracks are visited if they match.
+    */
+    std::vector<const AudioLibraryTrack*> findTracksOfArtist(const AudioLibrary& library, const QString& artist)
     {
-        if (_words.empty() && _forbidden_words.empty())
-            return view_name;
+        using StringColumn = AudioLibraryTrackTable::StringColumn;
+
+        const AudioLibraryTrackTable& track_table = library.getTrackTable();
+
+        const quint32 artist_id = track_table.findString(artist);
+        if (artist_id == AudioLibraryTrackTable::NO_STRING)
+            return {};
+
+        // an empty album artist means the album has none
+        const quint32 album_artist_id = artist.isEmpty() ? AudioLibraryTrackTable::NO_STRING : artist_id;
+
+        const std::vector<quint32>& artists = track_table.getColumn(StringColumn::ARTIST);
+        const std::vector<quint32>& album_artists = track_table.getColumn(StringColumn::ALBUM_ARTIST);
+
+        std::unordered_set<const AudioLibraryTrack*> matching_tracks;
+        std::vector<const AudioLibraryAlbum*> albums;
 
-        QStringList result;
+        for (size_t row = 0; row < artists.size(); ++row)
+        {
+            if (artists[row] != artist_id && album_artists[row] != album_artist_id)
+                continue;
+
+            if (const AudioLibraryTrack* track = track_table.getTrack(static_cast<quint32>(row)))
+            {
+                matching_tracks.insert(track);
+                albums.push_back(track->getAlbum());
+            }
+        }
+
+        std::ranges::sort(albums, [](const AudioLibraryAlbum* a, const AudioLibraryAlbum* b) {
+            return a->getKey() < b->getKey();
+        });
+        albums.erase(std::ranges::unique(albums).begin(), albums.end());
 
-        for (const QString& word : _words)
-            result.push_back('\"' + word + '\"');
+        std::vector<const AudioLibraryTrack*> result;
+        result.reserve(matching_tracks.size());
 
-        for (const QString& word : _forbidden_words)
-            result.push_back(QObject::tr("not \"%1\"").arg(word));
+        for (const AudioLibraryAlbum* album : albums)
+            for (const AudioLibraryTrack* track : album->getTracks())
+                if (matching_tracks.contains(track))
+                    result.push_back(track);
 
-        return QString("%1 (%2)").arg(view_name, result.join(", "));
+        return result;
+    }
+
+    QString formatFilterString(const AudioLibraryQuery& query, const QString& view_name)
+    {
+        if (query.isEmpty())
+            return view_name;
+
+        return QString("%1 (%2)").arg(view_name, query.format());
     }
 
 }
@@ -400,7 +484,7 @@ std::unique_ptr<AudioLibraryView> AudioLibraryViewAllArtists::clone() const
 
 QString AudioLibraryViewAllArtists::getDisplayName() const
 {
-    return FilterHandler(_filter).formatFilterString(QObject::tr("Artists"));
+    return formatFilterString(AudioLibraryQuery(_filter, AudioLibraryQuery::Field::ARTIST), QObject::tr("Artists"));
 }
 
 std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllArtists::getSupportedModes() const
@@ -410,37 +494,33 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllArtists::getSuppor
 
 void AudioLibraryViewAllArtists::createItems(const AudioLibrary& library,
     DisplayMode /*display_mode*/,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
-    FilterHandler filter_handler(_filter);
+    const AudioLibraryQuery query(_filter, AudioLibraryQuery::Field::ARTIST);
 
-    std::unordered_map<QString, AudioLibraryArtistGroupData> displayed_groups;
+    using GroupMap = std::unordered_map<QString, AudioLibraryArtistGroupData>;
 
-    for (const AudioLibraryAlbum* album : library.getAlbums())
-    {
-        for (const AudioLibraryTrack* track : album->getTracks())
-        {
-            // always add an item for artist, even if this field is empty
+    const GroupMap displayed_groups = aggregateGroups<GroupMap>(query.findCandidates(library), [&query](const AudioLibraryTrack* track, GroupMap& groups) {
+        // always add an item for artist, even if this field is empty
 
-            if (filter_handler.checkText(track->getArtist()))
-            {
-                addTrackToArtistGroup(track->getArtist(), track, displayed_groups);
-            }
+        if (query.matches(track, track->getFoldedText(AudioLibrarySearchIndex::TrackField::ARTIST)))
+        {
+            addTrackToArtistGroup(track->getArtist(), track, groups);
+        }
 
-            // if the album has an album artist, add an extra item for this field
+        // if the album has an album artist, add an extra item for this field
 
-            if (!track->getAlbumArtist().isEmpty() &&
-                track->getArtist() != track->getAlbumArtist() &&
-                filter_handler.checkText(track->getAlbumArtist()))
-            {
-                addTrackToArtistGroup(track->getAlbumArtist(), track, displayed_groups);
-            }
+        if (!track->getAlbumArtist().isEmpty() &&
+            track->getArtist() != track->getAlbumArtist() &&
+            query.matches(track, track->getFoldedText(AudioLibrarySearchIndex::TrackField::ALBUM_ARTIST)))
+        {
+            addTrackToArtistGroup(track->getAlbumArtist(), track, groups);
         }
-    }
+    });
 
     for (const auto& group : displayed_groups)
     {
-        model->addGroupItem(group.first, group.second.showcase_album, static_cast<int>(group.second.albums.size()), group.second.num_tracks, [group](){
+        rows.addGroupItem(group.first, group.second.showcase_album, static_cast<int>(group.second.albums.size()), group.second.num_tracks, [group](){
             return std::make_unique<AudioLibraryViewArtist>(group.first);
         });
     }
@@ -469,7 +549,7 @@ std::unique_ptr<AudioLibraryView> AudioLibraryViewAllAlbums::clone() const
 
 QString AudioLibraryViewAllAlbums::getDisplayName() const
 {
-    return FilterHandler(_filter).formatFilterString(QObject::tr("Albums"));
+    return formatFilterString(AudioLibraryQuery(_filter, AudioLibraryQuery::Field::ALBUM), QObject::tr("Albums"));
 }
 
 std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllAlbums::getSupportedModes() const
@@ -479,14 +559,13 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllAlbums::getSupport
 
 void AudioLibraryViewAllAlbums::createItems(const AudioLibrary& library,
     DisplayMode /*display_mode*/,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
-    FilterHandler filter_handler(_filter);
+    const AudioLibraryQuery query(_filter, AudioLibraryQuery::Field::ALBUM);
 
-    for (const AudioLibraryAlbum* album : library.getAlbums())
+    for (const AudioLibraryAlbum* album : findAlbums(library, query, AudioLibrarySearchIndex::AlbumField::ALBUM))
     {
-        if(filter_handler.checkText(album->getKey().getAlbum()))
-            model->addAlbumItem(album);
+        rows.addAlbumItem(album);
     }
 }
 
@@ -513,7 +592,7 @@ std::unique_ptr<AudioLibraryView> AudioLibraryViewAllTracks::clone() const
 
 QString AudioLibraryViewAllTracks::getDisplayName() const
 {
-    return FilterHandler(_filter).formatFilterString(QObject::tr("Tracks"));
+    return formatFilterString(AudioLibraryQuery(_filter, AudioLibraryQuery::Field::TITLE), QObject::tr("Tracks"));
 }
 
 std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllTracks::getSupportedModes() const
@@ -523,17 +602,14 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllTracks::getSupport
 
 void AudioLibraryViewAllTracks::createItems(const AudioLibrary& library,
     DisplayMode /*display_mode*/,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
-    FilterHandler filter_handler(_filter);
+    const AudioLibraryQuery query(_filter, AudioLibraryQuery::Field::TITLE);
 
-    for (const AudioLibraryAlbum* album : library.getAlbums())
+    for (const AudioLibraryTrack* track : query.findCandidates(library))
     {
-        for (const AudioLibraryTrack* track : album->getTracks())
-        {
-            if(filter_handler.checkText(track->getTitle()))
-                model->addTrackItem(track);
-        }
+        if (query.matches(track, track->getFoldedText(AudioLibrarySearchIndex::TrackField::TITLE)))
+            rows.addTrackItem(track);
     }
 }
 
@@ -566,18 +642,17 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllYears::getSupporte
 
 void AudioLibraryViewAllYears::createItems(const AudioLibrary& library,
     DisplayMode /*display_mode*/,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
-    std::unordered_map<int, AudioLibraryGroupData> displayed_groups;
+    using GroupMap = std::unordered_map<int, AudioLibraryGroupData>;
 
-    for (const AudioLibraryAlbum* album : library.getAlbums())
-    {
-        addAlbumToGroup(album->getKey().getYear(), album, displayed_groups);
-    }
+    const GroupMap displayed_groups = aggregateGroups<GroupMap>(library.getAlbums(), [](const AudioLibraryAlbum* album, GroupMap& groups) {
+        addAlbumToGroup(album->getKey().getYear(), album, groups);
+    });
 
     for (const auto& group : displayed_groups)
     {
-        model->addGroupItem(QString::number(group.first), group.second.showcase_album, group.second.num_albums, group.second.num_tracks, [group]() {
+        rows.addGroupItem(QString::number(group.first), group.second.showcase_album, group.second.num_albums, group.second.num_tracks, [group]() {
             return std::make_unique<AudioLibraryViewYear>(group.first);
         });
     }
@@ -607,7 +682,7 @@ std::unique_ptr<AudioLibraryView> AudioLibraryViewAllGenres::clone() const
 
 QString AudioLibraryViewAllGenres::getDisplayName() const
 {
-    return FilterHandler(_filter).formatFilterString(QObject::tr("Genres"));
+    return formatFilterString(AudioLibraryQuery(_filter, AudioLibraryQuery::Field::GENRE), QObject::tr("Genres"));
 }
 
 std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllGenres::getSupportedModes() const
@@ -620,56 +695,46 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAllGenres::getSupport
 
 void AudioLibraryViewAllGenres::createItems(const AudioLibrary& library,
     DisplayMode display_mode,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
-    FilterHandler filter_handler(_filter);
+    const AudioLibraryQuery query(_filter, AudioLibraryQuery::Field::GENRE);
+    const std::vector<const AudioLibraryAlbum*> albums = findAlbums(library, query, AudioLibrarySearchIndex::AlbumField::GENRE);
 
     if(display_mode == DisplayMode::GENRES)
     {
-        std::unordered_map<QString, AudioLibraryGroupData> displayed_groups;
+        using GroupMap = std::unordered_map<QString, AudioLibraryGroupData>;
 
-        for (const AudioLibraryAlbum* album : library.getAlbums())
-        {
-            if (filter_handler.checkText(album->getKey().getGenre()))
-            {
-                addAlbumToGroup(album->getKey().getGenre(), album, displayed_groups);
-            }
-        }
+        const GroupMap displayed_groups = aggregateGroups<GroupMap>(albums, [](const AudioLibraryAlbum* album, GroupMap& groups) {
+            addAlbumToGroup(album->getKey().getGenre(), album, groups);
+        });
 
         for (const auto& group : displayed_groups)
         {
-            model->addGroupItem(group.first, group.second.showcase_album, group.second.num_albums, group.second.num_tracks, [group]() {
+            rows.addGroupItem(group.first, group.second.showcase_album, group.second.num_albums, group.second.num_tracks, [group]() {
                 return std::make_unique<AudioLibraryViewGenre>(group.first);
             });
         }
     }
     else if (display_mode == DisplayMode::ALBUMS)
     {
-        for (const AudioLibraryAlbum* album : library.getAlbums())
+        for (const AudioLibraryAlbum* album : albums)
         {
-            if (filter_handler.checkText(album->getKey().getGenre()))
-            {
-                model->addAlbumItem(album);
-            }
+            rows.addAlbumItem(album);
         }
     }
     else if (display_mode == DisplayMode::ARTISTS)
     {
         // collect all artists that have released at least one album of the genre
 
-        std::unordered_map<QString, AudioLibraryGroupData> displayed_groups;
+        using GroupMap = std::unordered_map<QString, AudioLibraryGroupData>;
 
-        for (const AudioLibraryAlbum* album : library.getAlbums())
-        {
-            if (filter_handler.checkText(album->getKey().getGenre()))
-            {
-                addAlbumToGroup(album->getKey().getArtist(), album, displayed_groups);
-            }
-        }
+        const GroupMap displayed_groups = aggregateGroups<GroupMap>(albums, [](const AudioLibraryAlbum* album, GroupMap& groups) {
+            addAlbumToGroup(album->getKey().getArtist(), album, groups);
+        });
 
         for (const auto& group : displayed_groups)
         {
-            model->addGroupItem(group.first, group.second.showcase_album, group.second.num_albums, group.second.num_tracks, [group]() {
+            rows.addGroupItem(group.first, group.second.showcase_album, group.second.num_albums, group.second.num_tracks, [group]() {
                 return std::make_unique<AudioLibraryViewArtist>(group.first);
             });
         }
@@ -710,52 +775,36 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewArtist::getSupportedM
 
 void AudioLibraryViewArtist::createItems(const AudioLibrary& library,
     DisplayMode display_mode,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
-    for (const AudioLibraryAlbum* album : library.getAlbums())
+    const AudioLibraryAlbum* last_album = nullptr;
+
+    for (const AudioLibraryTrack* track : findTracksOfArtist(library, _artist))
     {
-        for (const AudioLibraryTrack* track : album->getTracks())
+        switch (display_mode)
         {
-            bool album_row_created = false;
-
-            if (track->getArtist() == _artist ||
-                (!track->getAlbumArtist().isEmpty() && track->getAlbumArtist() == _artist))
-            {
-                switch (display_mode)
-                {
-                case DisplayMode::ALBUMS:
-                    model->addAlbumItem(album);
-                    album_row_created = true;
-                    break;
-                case DisplayMode::TRACKS:
-                    model->addTrackItem(track);
-                    break;
-                case AudioLibraryView::DisplayMode::ARTISTS:
-                case AudioLibraryView::DisplayMode::YEARS:
-                case AudioLibraryView::DisplayMode::GENRES:
-                    break;
-                }
-            }
-
-            if (album_row_created)
-                break;
+        case DisplayMode::ALBUMS:
+            // the tracks of an album are next to each other
+            if (track->getAlbum() != last_album)
+                rows.addAlbumItem(track->getAlbum());
+            break;
+        case DisplayMode::TRACKS:
+            rows.addTrackItem(track);
+            break;
+        case AudioLibraryView::DisplayMode::ARTISTS:
+        case AudioLibraryView::DisplayMode::YEARS:
+        case AudioLibraryView::DisplayMode::GENRES:
+            break;
         }
+
+        last_album = track->getAlbum();
     }
 }
 
 void AudioLibraryViewArtist::resolveToTracks(const AudioLibrary& library, std::vector<const AudioLibraryTrack*>& tracks) const
 {
-    for (const AudioLibraryAlbum* album : library.getAlbums())
-    {
-        for (const AudioLibraryTrack* track : album->getTracks())
-        {
-            if (track->getArtist() == _artist ||
-                (!track->getAlbumArtist().isEmpty() && track->getAlbumArtist() == _artist))
-            {
-                tracks.push_back(track);
-            }
-        }
-    }
+    const std::vector<const AudioLibraryTrack*> artist_tracks = findTracksOfArtist(library, _artist);
+    tracks.insert(tracks.end(), artist_tracks.begin(), artist_tracks.end());
 }
 
 const ResolveToTracksIF* AudioLibraryViewArtist::getResolveToTracksIF() const
@@ -792,13 +841,13 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewAlbum::getSupportedMo
 
 void AudioLibraryViewAlbum::createItems(const AudioLibrary& library,
     DisplayMode /*display_mode*/,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
     if (const AudioLibraryAlbum* album = library.getAlbum(_key))
     {
         for (const AudioLibraryTrack* track : album->getTracks())
         {
-            model->addTrackItem(track);
+            rows.addTrackItem(track);
         }
     }
 }
@@ -848,13 +897,13 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewYear::getSupportedMod
 
 void AudioLibraryViewYear::createItems(const AudioLibrary& library,
     DisplayMode display_mode,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
     for (const AudioLibraryAlbum* album : library.getAlbums())
     {
         if (album->getKey().getYear() == _year)
         {
-            createAlbumOrTrackRow(album, display_mode, model);
+            createAlbumOrTrackRow(album, display_mode, rows);
         }
     }
 }
@@ -904,13 +953,13 @@ std::vector<AudioLibraryView::DisplayMode> AudioLibraryViewGenre::getSupportedMo
 
 void AudioLibraryViewGenre::createItems(const AudioLibrary& library,
     DisplayMode display_mode,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
     for (const AudioLibraryAlbum* album : library.getAlbums())
     {
         if (album->getKey().getGenre() == _genre)
         {
-            createAlbumOrTrackRow(album, display_mode, model);
+            createAlbumOrTrackRow(album, display_mode, rows);
         }
     }
 }
@@ -970,7 +1019,7 @@ namespace {
 
 void AudioLibraryViewDuplicateAlbums::createItems(const AudioLibrary& library,
     DisplayMode /*display_mode*/,
-    AudioLibraryModel* model) const
+    AudioLibraryRowSet& rows) const
 {
     std::map<DuplicateAlbumKey, const AudioLibraryAlbum*> first_album_occurence;
     std::unordered_set<const AudioLibraryAlbum*> duplicates;
@@ -989,7 +1038,7 @@ void AudioLibraryViewDuplicateAlbums::createItems(const AudioLibrary& library,
 
     for (const AudioLibraryAlbum* album : duplicates)
     {
-        model->addAlbumItem(album);
+        rows.addAlbumItem(album);
     }
 }
 
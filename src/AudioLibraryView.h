@@ -4,7 +4,7 @@
 #include <QtGui/qstandarditemmodel.h>
 #include "AudioLibrary.h"
 
-class AudioLibraryModel;
+class AudioLibraryRowSet;
 
 class ResolveToTracksIF
 {
@@ -78,7 +78,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const = 0;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const = 0;
+        AudioLibraryRowSet& rows) const = 0;
     virtual const ResolveToTracksIF* getResolveToTracksIF() const;
     virtual QString getId() const = 0;
 };
@@ -93,7 +93,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual QString getId() const override;
 
     static QString getBaseId();
@@ -112,7 +112,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual QString getId() const override;
 
     static QString getBaseId();
@@ -131,7 +131,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual QString getId() const override;
 
     static QString getBaseId();
@@ -148,7 +148,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual QString getId() const override;
 
     static QString getBaseId();
@@ -164,7 +164,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual QString getId() const override;
 
     static QString getBaseId();
@@ -183,7 +183,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual void resolveToTracks(const AudioLibrary& library, std::vector<const AudioLibraryTrack*>& tracks) const override;
     virtual const ResolveToTracksIF* getResolveToTracksIF() const override;
     virtual QString getId() const override;
@@ -202,7 +202,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual void resolveToTracks(const AudioLibrary& library, std::vector<const AudioLibraryTrack*>& tracks) const override;
     virtual const ResolveToTracksIF* getResolveToTracksIF() const override;
     virtual QString getId() const override;
@@ -221,7 +221,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual void resolveToTracks(const AudioLibrary& library, std::vector<const AudioLibraryTrack*>& tracks) const override;
     virtual const ResolveToTracksIF* getResolveToTracksIF() const override;
     virtual QString getId() const override;
@@ -240,7 +240,7 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual void resolveToTracks(const AudioLibrary& library, std::vector<const AudioLibraryTrack*>& tracks) const override;
     virtual const ResolveToTracksIF* getResolveToTracksIF() const override;
     virtual QString getId() const override;
@@ -257,6 +257,6 @@ public:
     virtual std::vector<DisplayMode> getSupportedModes() const override;
     virtual void createItems(const AudioLibrary& library,
         DisplayMode display_mode,
-        AudioLibraryModel* model) const override;
+        AudioLibraryRowSet& rows) const override;
     virtual QString getId() const override;
 };
\ No newline at end of file
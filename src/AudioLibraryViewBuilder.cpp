@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "AudioLibraryViewBuilder.h"
+
+#include <algorithm>
+#include "Tracing.h"
+
+namespace {
+    const size_t MAX_CACHED_VIEWS = 8;
+    const size_t MAX_CACHED_ROWS = 200000;  //!< in all cached views together, larger views aren't cached at all
+}
+
+AudioLibraryViewBuilder::AudioLibraryViewBuilder(ThreadSafeAudioLibrary& library)
+    : _library(library)
+{
+    _thread = std::thread([this]() {
+        threadBuildViews();
+    });
+}
+
+AudioLibraryViewBuilder::~AudioLibraryViewBuilder()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+        _cancel_flag = true;
+    }
+
+    _request_condition.notify_one();
+    _thread.join();
+}
+
+void AudioLibraryViewBuilder::startBuilding(const AudioLibraryView& view, AudioLibraryView::DisplayMode display_mode)
+{
+    const QString view_id = view.getId();
+    std::shared_ptr<const AudioLibrary> library = _library.getSnapshot();
+    const quint64 generation = library->getGeneration();
+
+    bool is_cached = false;
+
+    {
+        std::lock_guard lock(_mutex);
+
+        _result.reset();
+        _is_building = true;
+
+        // the flag is reset when the thread takes the new request
+        _cancel_flag = true;
+
+        if (auto cached_rows = findCachedRows(view_id, display_mode, generation))
+        {
+            _request.reset();
+            _result = std::make_unique<Result>(Result{ view_id, display_mode, *cached_rows });
+            is_cached = true;
+        }
+        else
+        {
+            _request = std::make_unique<Request>(Request{ view.clone(), display_mode, std::move(library) });
+        }
+    }
+
+    if (is_cached)
+        emit rowsReady();
+    else
+        _request_condition.notify_one();
+}
+
+bool AudioLibraryViewBuilder::isBuilding() const
+{
+    std::lock_guard lock(_mutex);
+    return _is_building;
+}
+
+std::unique_ptr<AudioLibraryViewBuilder::Result> AudioLibraryViewBuilder::takeResult()
+{
+    std::lock_guard lock(_mutex);
+
+    if (_result)
+        _is_building = false;
+
+    return std::move(_result);
+}
+
+void AudioLibraryViewBuilder::threadBuildViews()
+{
+    while (true)
+    {
+        std::unique_ptr<Request> request;
+
+        {
+            std::unique_lock lock(_mutex);
+            _request_condition.wait(lock, [this]() { return _stop || _request; });
+
+            if (_stop)
+                return;
+
+            request = std::move(_request);
+            _cancel_flag = false;
+        }
+
+        auto result = std::make_unique<Result>(Result{ request->view->getId(), request->display_mode, AudioLibraryRowSet(&_cancel_flag) });
+        const quint64 generation = request->library->getGeneration();
+
+        {
+            TraceSpan span("createItems");
+            ScopedDurationCounter duration_counter(getPerformanceCounters().last_view_build_ns);
+
+            request->view->createItems(*request->library, request->display_mode, result->rows);
+        }
+
+        // the cache keeps its own copy, because the model takes the views of the rows
+
+        std::shared_ptr<const AudioLibraryRowSet> cached_rows;
+        if (!_cancel_flag && result->rows.size() <= MAX_CACHED_ROWS)
+            cached_rows = std::make_shared<const AudioLibraryRowSet>(result->rows);
+
+        {
+            std::lock_guard lock(_mutex);
+
+            // a newer request has canceled this one
+            if (_cancel_flag)
+                continue;
+
+            if (cached_rows)
+                addCachedRows({ result->view_id, result->display_mode, generation, std::move(cached_rows) });
+
+            _result = std::move(result);
+        }
+
+        emit rowsReady();
+    }
+}
+
+std::shared_ptr<const AudioLibraryRowSet> AudioLibraryViewBuilder::findCachedRows(const QString& view_id, AudioLibraryView::DisplayMode display_mode, quint64 generation)
+{
+    // rows of an older generation can never be used again
+    std::erase_if(_cache, [generation](const CacheEntry& entry) {
+        return entry.generation != generation;
+    });
+
+    auto it = std::ranges::find_if(_cache, [&](const CacheEntry& entry) {
+        return entry.view_id == view_id && entry.display_mode == display_mode;
+    });
+
+    if (it == _cache.end())
+        return nullptr;
+
+    _cache.splice(_cache.begin(), _cache, it);
+    return it->rows;
+}
+
+void AudioLibraryViewBuilder::addCachedRows(CacheEntry entry)
+{
+    std::erase_if(_cache, [&entry](const CacheEntry& other) {
+        return other.generation != entry.generation || (other.view_id == entry.view_id && other.display_mode == entry.display_mode);
+    });
+
+    _cache.push_front(std::move(entry));
+
+    size_t number_of_rows = 0;
+
+    auto it = _cache.begin();
+    for (size_t i = 0; it != _cache.end() && i < MAX_CACHED_VIEWS; ++i, ++it)
+    {
+        number_of_rows += it->rows->size();
+        if (number_of_rows > MAX_CACHED_ROWS)
+            break;
+    }
+
+    _cache.erase(it, _cache.end());
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <condition_variable>
+#include <list>
+#include <QtCore/qobject.h>
+#include "AudioLibraryRowSet.h"
+#include "ThreadSafeAudioLibrary.h"
+
+/**
+* Creates the rows of a view on a background thread, so that large views don't block the GUI.
+* The rows are built from the current snapshot of the library, the loader is never blocked by a build.
+*
+* Only the last requested view is built. Starting a new build cancels the running one, its rows are never delivered.
+*
+* The rows of the recently built views are kept for the generation of the current snapshot. When one of them
+* is requested again, e.g. by going back in the history, the cached rows are delivered right away.
+*/
+class AudioLibraryViewBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Result
+    {
+        QString view_id;
+        AudioLibraryView::DisplayMode display_mode = AudioLibraryView::DisplayMode::ARTISTS;
+        AudioLibraryRowSet rows;
+    };
+
+    AudioLibraryViewBuilder(ThreadSafeAudioLibrary& library);
+    ~AudioLibraryViewBuilder();
+
+    /**
+    * If the rows are cached, rowsReady is emitted before this returns.
+    */
+    void startBuilding(const AudioLibraryView& view, AudioLibraryView::DisplayMode display_mode);
+
+    /**
+    * True from startBuilding until the result has been taken.
+    */
+    bool isBuilding() const;
+
+    /**
+    * Returns the finished rows of the last build, or null if they aren't ready yet.
+    */
+    std::unique_ptr<Result> takeResult();
+
+signals:
+    void rowsReady();
+
+private:
+    struct Request
+    {
+        std::unique_ptr<AudioLibraryView> view;
+        AudioLibraryView::DisplayMode display_mode;
+        std::shared_ptr<const AudioLibrary> library;
+    };
+
+    struct CacheEntry
+    {
+        QString view_id;
+        AudioLibraryView::DisplayMode display_mode;
+        quint64 generation;
+        std::shared_ptr<const AudioLibraryRowSet> rows;
+    };
+
+    void threadBuildViews();
+
+    // the cache functions expect the mutex to be locked
+    std::shared_ptr<const AudioLibraryRowSet> findCachedRows(const QString& view_id, AudioLibraryView::DisplayMode display_mode, quint64 generation);
+    void addCachedRows(CacheEntry entry);
+
+    ThreadSafeAudioLibrary& _library;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _request_condition;
+    std::unique_ptr<Request> _request;          //!< waiting to be built
+    std::unique_ptr<Result> _result;            //!< waiting to be taken
+    bool _is_building = false;
+    bool _stop = false;
+    std::list<CacheEntry> _cache;               //!< most recently used first
+
+    std::atomic_bool _cancel_flag = ATOMIC_VAR_INIT(false);
+
+    std::thread _thread;
+};
\ No newline at end of file
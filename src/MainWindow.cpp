@@ -18,6 +18,7 @@
 #include <QtGui/qpainter.h>
 #include <QtWidgets/qapplication.h>
 #include <QtWidgets/qmenubar.h>
+#include <QtWidgets/qmessagebox.h>
 #include <QtWidgets/qscrollbar.h>
 #include <QtWidgets/qshortcut.h>
 #include <QtWidgets/qfiledialog.h>
@@ -26,8 +27,11 @@
 #include <QtWidgets/qtoolbutton.h>
 #include <QtWidgets/qtooltip.h>
 #include "ImageViewWindow.h"
+#include "PerformanceCounters.h"
+#include "PerformanceWindow.h"
 #include "project_version.h"
 #include "SettingsEditorWindow.h"
+#include "Tracing.h"
 
 namespace
 {
@@ -181,6 +185,9 @@ ViewSelector::ViewSelector()
     _filter_box = new QLineEdit(this);
     _filter_box->setPlaceholderText(tr("Filter..."));
     _filter_box->setClearButtonEnabled(true);
+    _filter_box->setToolTip(tr("Words are searched in the names of the view. Other fields: artist:, album:, title:, genre:, comment:, path:\n"
+        "Numbers: year:1990..1999, bitrate:>256, length:<3m, track:, disc:, samplerate:, channels:\n"
+        "Combine with OR and parentheses, negate with ! or NOT, use quotes for phrases."));
 
     auto layout = new QVBoxLayout(this);
     layout->addWidget(_artist_button);
@@ -406,12 +413,14 @@ MainWindow::MainWindow(Settings& settings, ThreadSafeAudioLibrary& library, Audi
     : _settings(settings)
     , _library(library)
     , _audio_files_loader(audio_files_loader)
+    , _view_builder(library)
 {
     setWindowTitle(APPLICATION_NAME);
 
     auto menubar = new QMenuBar(this);
     auto filemenu = menubar->addMenu(tr("&File"));
     addMenuAction(*filemenu, tr("Preferences..."), this, &MainWindow::onEditPreferences, QKeySequence::Preferences);
+    addMenuAction(*filemenu, tr("Save performance trace..."), this, &MainWindow::onSavePerformanceTrace);
     filemenu->addSeparator();
     addMenuAction(*filemenu, tr("Exit"), this, &MainWindow::close, QKeySequence::Quit);
 
@@ -421,7 +430,9 @@ MainWindow::MainWindow(Settings& settings, ThreadSafeAudioLibrary& library, Audi
     addMenuAction(*viewmenu, tr("Find..."), this, &MainWindow::onShowFindWidget, QKeySequence::Find);
     addMenuAction(*viewmenu, tr("Badly tagged albums"), this, &MainWindow::onShowDuplicateAlbums);
     addMenuAction(*viewmenu, tr("Reload all files"), this, &MainWindow::scanAudioDirs, QKeySequence::Refresh);
+    addMenuAction(*viewmenu, tr("Prune missing files"), this, &MainWindow::pruneMissingFiles);
     addMenuAction(*viewmenu, tr("Select random item"), this, &MainWindow::selectRandomItem, QKeySequence(Qt::Key_F6));
+    addMenuAction(*viewmenu, tr("Performance..."), this, &MainWindow::onShowPerformance);
 
     auto toolarea = new QWidget(this);
 
@@ -477,6 +488,23 @@ MainWindow::MainWindow(Settings& settings, ThreadSafeAudioLibrary& library, Audi
     _view_stack->addWidget(_table);
     _view_stack->setCurrentWidget(_list);
 
+    // shown over the old view when building the new one takes a noticeable time
+
+    _building_overlay = new QLabel(tr("Building view..."), _view_stack);
+    _building_overlay->setAutoFillBackground(true);
+    _building_overlay->setMargin(8);
+    _building_overlay->hide();
+
+    _building_overlay_timer = new QTimer(this);
+    _building_overlay_timer->setSingleShot(true);
+    _building_overlay_timer->setInterval(200);
+    connect(_building_overlay_timer, &QTimer::timeout, this, [this]() {
+        _building_overlay->adjustSize();
+        _building_overlay->move((_view_stack->width() - _building_overlay->width()) / 2, 0);
+        _building_overlay->raise();
+        _building_overlay->show();
+    });
+
     _details = new DetailsPane(this);
 
     _details_splitter = new QSplitter(Qt::Horizontal);
@@ -564,6 +592,9 @@ MainWindow::MainWindow(Settings& settings, ThreadSafeAudioLibrary& library, Audi
     connect(&_audio_files_loader, &AudioFilesLoader::libraryCacheLoading, this, &MainWindow::onLibraryCacheLoading);
     connect(&_audio_files_loader, &AudioFilesLoader::libraryLoadProgressed, this, &MainWindow::onLibraryLoadProgressed);
     connect(&_audio_files_loader, &AudioFilesLoader::libraryLoadFinished, this, &MainWindow::onLibraryLoadFinished);
+    connect(&_audio_files_loader, &AudioFilesLoader::libraryAudioPropertiesRefined, this, &MainWindow::onLibraryAudioPropertiesRefined);
+    connect(&_audio_files_loader, &AudioFilesLoader::libraryMissingFilesPruned, this, &MainWindow::onLibraryMissingFilesPruned);
+    connect(&_view_builder, &AudioLibraryViewBuilder::rowsReady, this, &MainWindow::onViewRowsReady);
     connect(_list, &QAbstractItemView::doubleClicked, this, &MainWindow::onItemDoubleClicked);
     connect(_table, &QAbstractItemView::doubleClicked, this, &MainWindow::onItemDoubleClicked);
     connect(_table->horizontalHeader(), &QHeaderView::sectionClicked, this, &MainWindow::onTableHeaderSectionClicked);
@@ -724,6 +755,30 @@ void MainWindow::onEditPreferences()
     checkLanguageChanged();
 }
 
+void MainWindow::onSavePerformanceTrace()
+{
+    const QString filepath = QFileDialog::getSaveFileName(this, tr("Save performance trace"), "AudioExplorerTrace.json", tr("Chrome trace (*.json)"));
+    if (filepath.isEmpty())
+        return;
+
+    if (!saveChromeTrace(filepath))
+        QMessageBox::warning(this, tr("Save performance trace"), tr("The trace could not be written to \"%1\".").arg(filepath));
+}
+
+void MainWindow::onShowPerformance()
+{
+    if (!_performance_dialog)
+    {
+        _performance_dialog = new PerformanceDialog(this, _library, [this]() -> const AudioLibraryModel* {
+            return _model;
+            });
+    }
+
+    _performance_dialog->show();
+    _performance_dialog->raise();
+    _performance_dialog->activateWindow();
+}
+
 void MainWindow::onShowFindWidget()
 {
     if (!_find_widget)
@@ -771,7 +826,72 @@ void MainWindow::onFindNext()
 
         QString search_text = _find_widget_line_edit->text();
 
-        for (int i = 0, n = view->model()->rowCount(); i < n; ++i)
+        const int n = view->model()->rowCount();
+
+        // album and track rows show "artist - title". As long as the text can't span the separator,
+        // the matching items can be looked up in the search index instead of checking every row.
+
+        const bool use_search_index = _current_display_mode &&
+            (*_current_display_mode == AudioLibraryView::DisplayMode::ALBUMS || *_current_display_mode == AudioLibraryView::DisplayMode::TRACKS) &&
+            !search_text.contains(' ') && !search_text.contains('-');
+
+        if (use_search_index)
+        {
+            std::vector<QUuid> ids;
+
+            {
+                // the rows of the view come from the snapshot, so the ids do as well
+                const std::shared_ptr<const AudioLibrary> library = _library.getSnapshot();
+                const AudioLibrarySearchIndex& search_index = library->getSearchIndex();
+
+                if (*_current_display_mode == AudioLibraryView::DisplayMode::ALBUMS)
+                {
+                    for (AudioLibrarySearchIndex::AlbumField field : { AudioLibrarySearchIndex::AlbumField::ARTIST, AudioLibrarySearchIndex::AlbumField::ALBUM })
+                        for (const AudioLibraryAlbum* album : search_index.findAlbums(field, { search_text }, {}))
+                            ids.push_back(album->getUuid());
+                }
+                else
+                {
+                    for (AudioLibrarySearchIndex::TrackField field : { AudioLibrarySearchIndex::TrackField::ARTIST, AudioLibrarySearchIndex::TrackField::TITLE })
+                        for (const AudioLibraryTrack* track : search_index.findTracks(field, { search_text }, {}))
+                            ids.push_back(track->getUuid());
+                }
+            }
+
+            // the next match is the one with the smallest distance from the start row, wrapping around at the end
+
+            QModelIndex next_index;
+            int next_distance = n;
+
+            for (const QUuid& id : ids)
+            {
+                const QModelIndex index = _model->getIndexForId(id);
+                if (!index.isValid())
+                    continue;
+
+                const int distance = ((index.row() - start_row) % n + n) % n;
+                if (distance < next_distance)
+                {
+                    next_index = index;
+                    next_distance = distance;
+                }
+            }
+
+            if (next_index.isValid())
+            {
+                setCurrentSelectedIndex(next_index);
+
+                view->scrollTo(next_index);
+            }
+
+            return;
+        }
+
+        // fold like the search index, so the same text finds the same rows in both paths
+
+        const QString folded_search_text = AudioLibrarySearchIndex::foldText(search_text);
+
+        for (int i = 0; i < n; ++i)
         {
             int row = (start_row + i) % n;
 
@@ -779,7 +899,7 @@ void MainWindow::onFindNext()
 
             QString item_text = index.data().toString();
 
-            if (item_text.contains(search_text, Qt::CaseInsensitive))
+            if (AudioLibrarySearchIndex::foldText(item_text).contains(folded_search_text))
             {
                 setCurrentSelectedIndex(index);
 
@@ -808,13 +928,13 @@ void MainWindow::onLibraryCacheLoading()
     updateCurrentViewIfOlderThan(1000);
 }
 
-void MainWindow::onLibraryLoadProgressed(int files_loaded, int files_in_cache)
+void MainWindow::onLibraryLoadProgressed(int files_loaded, int files_in_cache, float files_per_sec, float megabytes_per_sec)
 {
     int num_tracks = files_in_cache + files_loaded;
 
-    const QString message = tr("%1 files loaded", nullptr, num_tracks);
+    const QString message = tr("%1 files loaded (%2 files/s, %3 MB/s)", nullptr, num_tracks);
 
-    _status_bar->showMessage(message.arg(num_tracks));
+    _status_bar->showMessage(message.arg(num_tracks).arg(files_per_sec, 0, 'f', 0).arg(megabytes_per_sec, 0, 'f', 1));
 
     updateCurrentViewIfOlderThan(1000);
 }
@@ -830,6 +950,24 @@ void MainWindow::onLibraryLoadFinished(int files_loaded, int files_in_cache, flo
     updateCurrentView();
 }
 
+void MainWindow::onLibraryAudioPropertiesRefined(int tracks_refined)
+{
+    const QString message = tr("Exact length and bitrate read for %1 files", nullptr, tracks_refined);
+
+    _status_bar->showMessage(message.arg(tracks_refined));
+
+    updateCurrentView();
+}
+
+void MainWindow::onLibraryMissingFilesPruned(int files_removed, float duration_sec)
+{
+    const QString message = tr("%1 missing files removed in %2s", nullptr, files_removed);
+
+    _status_bar->showMessage(message.arg(files_removed).arg(duration_sec, 0, 'f', 1));
+
+    updateCurrentView();
+}
+
 void MainWindow::onShowDuplicateAlbums()
 {
     setBreadCrumb(std::make_unique<AudioLibraryViewDuplicateAlbums>());
@@ -1040,9 +1178,15 @@ void MainWindow::saveLibrary()
 
 void MainWindow::scanAudioDirs()
 {
+    _audio_files_loader.setAudioPropertiesMode(_settings.fast_audio_properties.getValue() ? AudioPropertiesMode::FAST : AudioPropertiesMode::ACCURATE);
     _audio_files_loader.startLoading(_settings.audio_dir_paths.getValue());
 }
 
+void MainWindow::pruneMissingFiles()
+{
+    _audio_files_loader.startPruning();
+}
+
 void MainWindow::selectRandomItem()
 {
     if (QAbstractItemView* view = qobject_cast<QAbstractItemView*>(_view_stack->currentWidget()))
@@ -1073,11 +1217,9 @@ const AudioLibraryView* MainWindow::getCurrentView() const
 
 void MainWindow::updateCurrentView()
 {
-    const AudioLibraryView* current_view = getCurrentView();
-
-    auto view_settings = saveViewSettings();
+    TraceSpan span("updateCurrentView");
 
-    QString current_view_id = current_view->getId();
+    const AudioLibraryView* current_view = getCurrentView();
 
     auto supported_modes = current_view->getSupportedModes();
 
@@ -1097,12 +1239,40 @@ void MainWindow::updateCurrentView()
         }
     }
 
-    const bool same_view = _current_view_id == current_view_id;
+    // refreshes of the same view don't need to be announced
+
+    if (current_view->getId() != _current_view_id || !_current_display_mode || current_display_mode != *_current_display_mode)
+        _building_overlay_timer->start();
+
+    // the items are created in the background, the current model stays until they are ready.
+    // cached items are applied right away, which also stops the overlay timer
+
+    _view_builder.startBuilding(*current_view, current_display_mode);
+}
+
+void MainWindow::onViewRowsReady()
+{
+    std::unique_ptr<AudioLibraryViewBuilder::Result> result = _view_builder.takeResult();
+    if (!result)
+        return; // superseded by a newer build
+
+    TraceSpan span("applyViewRows");
+
+    _building_overlay_timer->stop();
+    _building_overlay->hide();
+
+    auto view_settings = saveViewSettings();
+
+    const AudioLibraryView::DisplayMode current_display_mode = result->display_mode;
+
+    auto supported_modes = getCurrentView()->getSupportedModes();
+
+    const bool same_view = _current_view_id == result->view_id;
     const bool same_display_mode = _current_display_mode && current_display_mode == *_current_display_mode;
 
     const bool incremental = same_view && same_display_mode;
 
-    _current_view_id = current_view_id;
+    _current_view_id = result->view_id;
     if (!_current_display_mode)
         _current_display_mode = std::make_unique<AudioLibraryView::DisplayMode>(current_display_mode);
     else
@@ -1141,15 +1311,13 @@ void MainWindow::updateCurrentView()
         _table->setColumnHidden(column.first, !is_available || is_hidden);
     }
 
-    // create items
+    // add items
 
     if (incremental)
     {
         AudioLibraryModel::IncrementalUpdateScope update_scope(*_model);
 
-        ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
-
-        current_view->createItems(acc.getLibrary(), current_display_mode, _model);
+        _model->addRows(std::move(result->rows));
     }
     else
     {
@@ -1162,11 +1330,7 @@ void MainWindow::updateCurrentView()
         }
         model->setHorizontalHeaderLabels(model_headers);
 
-        {
-            ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
-
-            current_view->createItems(acc.getLibrary(), current_display_mode, model);
-        }
+        model->addRows(std::move(result->rows));
 
         _model->deleteLater();
         _model = model;
@@ -1196,12 +1360,27 @@ void MainWindow::updateCurrentView()
         _model->getModel()->sort(new_sort_section, new_sort_order);
     }
 
+    if (std::shared_ptr<ViewRestoreData> restore_data = std::move(_pending_restore_data))
+    {
+        // restore uses a timer because the list view is updating asynchronously
+
+        QTimer::singleShot(1, this, [this, restore_data]() {
+            restoreViewSettings(restore_data.get());
+            });
+    }
+
     _last_view_update_time = std::chrono::steady_clock::now();
     _is_last_view_update_time_valid = true;
+
+    getPerformanceCounters().last_view_rows = _model->getModel()->rowCount();
 }
 
 void MainWindow::updateCurrentViewIfOlderThan(int msecs)
 {
+    // restarting a build that takes longer than the interval would never show anything
+    if (_view_builder.isBuilding())
+        return;
+
     if (!_is_last_view_update_time_valid)
     {
         updateCurrentView();
@@ -1266,11 +1445,11 @@ void MainWindow::getFilepathsFromIndex(const QModelIndex& index, std::vector<QSt
 
     if (const AudioLibraryView* view = _model->getViewForIndex(index))
     {
-        ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+        const std::shared_ptr<const AudioLibrary> library = _library.getSnapshot();
 
         std::vector<const AudioLibraryTrack*> tracks;
         if (view->getResolveToTracksIF())
-            view->getResolveToTracksIF()->resolveToTracks(acc.getLibrary(), tracks);
+            view->getResolveToTracksIF()->resolveToTracks(*library, tracks);
 
         for (const AudioLibraryTrack* track : tracks)
             filepaths.push_back(track->getFilepath());
@@ -1292,11 +1471,11 @@ void MainWindow::forEachFilepathAtIndex(const QModelIndex& index, std::function<
 
     if (const AudioLibraryView* view = _model->getViewForIndex(index))
     {
-        ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+        const std::shared_ptr<const AudioLibrary> library = _library.getSnapshot();
 
         std::vector<const AudioLibraryTrack*> tracks;
         if (view->getResolveToTracksIF())
-            view->getResolveToTracksIF()->resolveToTracks(acc.getLibrary(), tracks);
+            view->getResolveToTracksIF()->resolveToTracks(*library, tracks);
 
         std::ranges::sort(tracks, [](const AudioLibraryTrack* a, const AudioLibraryTrack* b) {
 
@@ -1344,20 +1523,13 @@ void MainWindow::updateAfterHistoryChange()
         _breadcrumb_layout->addWidget(button);
     }
 
-    std::shared_ptr<ViewRestoreData> restore_data;
+    // restored once the rows of the view have been added
+
+    _pending_restore_data.reset();
     if (current_history_items.back()->restore_data)
-        restore_data.reset(new ViewRestoreData(*current_history_items.back()->restore_data));
+        _pending_restore_data.reset(new ViewRestoreData(*current_history_items.back()->restore_data));
 
     updateCurrentView();
-
-    if (restore_data)
-    {
-        // restore uses a timer because the list view is updating asynchronously
-
-        QTimer::singleShot(1, this, [this, restore_data]() {
-            restoreViewSettings(restore_data.get());
-            });
-    }
 }
 
 void MainWindow::setBreadCrumb(std::unique_ptr<AudioLibraryView> view)
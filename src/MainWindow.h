@@ -2,9 +2,11 @@
 #pragma once
 
 #include <QtCore/qpointer.h>
+#include <QtCore/qtimer.h>
 #include <QtGui/qstandarditemmodel.h>
 #include <QtWidgets/qboxlayout.h>
 #include <QtWidgets/qframe.h>
+#include <QtWidgets/qlabel.h>
 #include <QtWidgets/qlineedit.h>
 #include <QtWidgets/qlistview.h>
 #include <QtWidgets/qpushbutton.h>
@@ -19,6 +21,7 @@
 #include "AudioLibrary.h"
 #include "AudioLibraryView.h"
 #include "AudioLibraryModel.h"
+#include "AudioLibraryViewBuilder.h"
 #include "DetailsPane.h"
 #include "ThreadSafeAudioLibrary.h"
 
@@ -116,11 +119,16 @@ protected:
 
 private:
     void onEditPreferences();
+    void onSavePerformanceTrace();
+    void onShowPerformance();
     void onShowFindWidget();
     void onFindNext();
     void onLibraryCacheLoading();
-    void onLibraryLoadProgressed(int files_loaded, int files_in_cache);
+    void onLibraryLoadProgressed(int files_loaded, int files_in_cache, float files_per_sec, float megabytes_per_sec);
     void onLibraryLoadFinished(int files_loaded, int files_in_cache, float duration_sec);
+    void onLibraryAudioPropertiesRefined(int tracks_refined);
+    void onLibraryMissingFilesPruned(int files_removed, float duration_sec);
+    void onViewRowsReady();
     void onShowDuplicateAlbums();
     void onBreadCrumbClicked();
     void onHistoryBack();
@@ -135,6 +143,7 @@ private:
 
     void saveLibrary();
     void scanAudioDirs();
+    void pruneMissingFiles();
     void selectRandomItem();
     const AudioLibraryView* getCurrentView() const;
     void updateCurrentView();
@@ -172,11 +181,17 @@ private:
 
     ThreadSafeAudioLibrary& _library;
     AudioFilesLoader& _audio_files_loader;
+    AudioLibraryViewBuilder _view_builder;
+
+    QLabel* _building_overlay = nullptr;
+    QTimer* _building_overlay_timer = nullptr;
+    std::shared_ptr<ViewRestoreData> _pending_restore_data; //!< restored when the rows of the view have been added
 
     std::chrono::steady_clock::time_point _last_view_update_time;
     bool _is_last_view_update_time_valid = false;
 
     QPointer<QWidget> _advanced_search_dialog = nullptr;
+    QPointer<QWidget> _performance_dialog = nullptr;
 
     std::unique_ptr<ViewRestoreData> saveViewSettings() const;
     void restoreViewSettings(ViewRestoreData* restore_data);
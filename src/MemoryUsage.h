@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <unordered_set>
+#include <vector>
+#include <QtCore/qstring.h>
+#include <QtCore/qvariant.h>
+
+/**
+* Estimates heap usage for the memory accounting of the library and the model.
+*
+* The numbers are approximations. Allocator overhead is ignored and the node sizes of the standard containers
+* follow the common implementations. Implicitly shared string data is only counted where it is seen first.
+*/
+class MemoryUsageCounter
+{
+public:
+    size_t addString(const QString& s)
+    {
+        // strings without capacity are empty or point to static data
+        if (s.capacity() == 0 || !_seen_string_data.insert(s.constData()).second)
+            return 0;
+
+        return sizeof(QArrayData) + (size_t(s.capacity()) + 1) * sizeof(QChar);
+    }
+
+    /**
+    * Only strings are counted, the other types used in the model are stored inside the variant.
+    */
+    size_t addVariant(const QVariant& v)
+    {
+        return v.metaType().id() == QMetaType::QString ? addString(v.toString()) : 0;
+    }
+
+    template<class T>
+    static size_t vectorSize(const std::vector<T>& v)
+    {
+        return v.capacity() * sizeof(T);
+    }
+
+    //! red-black tree nodes with three pointers and the color
+    template<class MAP>
+    static size_t treeMapSize(const MAP& map)
+    {
+        return map.size() * (sizeof(typename MAP::value_type) + 4 * sizeof(void*));
+    }
+
+    //! nodes with a next pointer and the cached hash, plus the bucket array
+    template<class MAP>
+    static size_t hashMapSize(const MAP& map)
+    {
+        return map.size() * (sizeof(typename MAP::value_type) + 2 * sizeof(void*)) + map.bucket_count() * sizeof(void*);
+    }
+
+private:
+    std::unordered_set<const void*> _seen_string_data;
+};
\ No newline at end of file
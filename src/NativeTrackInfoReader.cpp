@@ -0,0 +1,1209 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "NativeTrackInfoReader.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <QtCore/qendian.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qfileinfo.h>
+
+namespace {
+
+    const qint64 HEAD_WINDOW_SIZE = 64 * 1024;
+    const qint64 TAIL_WINDOW_SIZE = 64 * 1024;
+    const qint64 ID3V1_SIZE = 128;
+    const qint64 APE_FOOTER_SIZE = 32;
+    const qint64 MAX_FRAME_SYNC_SEARCH = 64 * 1024;
+    const qint64 LAST_FRAME_SEARCH_SIZE = 16 * 1024;
+
+    /**
+    * Gives access to the start of a file.
+    * Initially a single bounded block is read, the window only grows if a tag is larger than that.
+    */
+    class HeadWindow
+    {
+    public:
+        HeadWindow(QFile& file) : _file(file) {}
+
+        bool ensure(qint64 size);
+
+        const char* data() const { return _bytes.constData(); }
+        qint64 size() const { return _bytes.size(); }
+
+    private:
+        QFile& _file;
+        QByteArray _bytes;
+    };
+
+    bool HeadWindow::ensure(qint64 size)
+    {
+        if (size <= _bytes.size())
+            return true;
+
+        if (size > _file.size())
+            return false;
+
+        // grow geometrically, to keep the number of reads low for large tags
+        const qint64 new_size = std::min(_file.size(), std::max({ size, HEAD_WINDOW_SIZE, qint64(_bytes.size()) * 2 }));
+
+        if (!_file.seek(_bytes.size()))
+            return false;
+
+        _bytes.append(_file.read(new_size - _bytes.size()));
+        return size <= _bytes.size();
+    }
+
+    QByteArray readBlock(QFile& file, qint64 offset, qint64 size)
+    {
+        if (offset < 0 || !file.seek(offset))
+            return QByteArray();
+
+        return file.read(size);
+    }
+
+    quint32 fromSyncSafe(const char* data)
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(data);
+        return (quint32(p[0]) << 21) | (quint32(p[1]) << 14) | (quint32(p[2]) << 7) | quint32(p[3]);
+    }
+
+    bool isSyncSafe(const char* data)
+    {
+        for (int i = 0; i < 4; ++i)
+            if (uchar(data[i]) & 0x80)
+                return false;
+        return true;
+    }
+
+    /**
+    * Same as TagLib::String::toInt, which parses leading digits and ignores the rest.
+    */
+    int toIntLikeTagLib(const QString& s)
+    {
+        qsizetype pos = 0;
+        while (pos < s.size() && s[pos].isSpace())
+            ++pos;
+
+        bool negative = false;
+        if (pos < s.size() && (s[pos].unicode() == u'-' || s[pos].unicode() == u'+'))
+        {
+            negative = s[pos].unicode() == u'-';
+            ++pos;
+        }
+
+        qint64 value = 0;
+        for (; pos < s.size() && value <= std::numeric_limits<int>::max(); ++pos)
+        {
+            const char16_t c = s[pos].unicode();
+            if (c < u'0' || c > u'9')
+                break;
+            value = value * 10 + (c - u'0');
+        }
+
+        value = std::min<qint64>(value, std::numeric_limits<int>::max());
+        return static_cast<int>(negative ? -value : value);
+    }
+
+    bool isNumber(const QString& s)
+    {
+        return !s.isEmpty() && std::ranges::all_of(s, [](QChar c){ return c.unicode() >= u'0' && c.unicode() <= u'9'; });
+    }
+
+    void appendTagType(const QString& type, TrackInfo& info)
+    {
+        if (!info.tag_types.isEmpty())
+            info.tag_types += ", ";
+        info.tag_types += type;
+    }
+
+    /**
+    * The fields which TagLib::Tag offers for all formats.
+    */
+    struct BasicTag
+    {
+        QString artist;
+        QString album;
+        int year = 0;
+        QString genre;
+        QString title;
+        int track_number = 0;
+        QString comment;
+
+        void mergeInto(TrackInfo& info) const
+        {
+            info.artist = artist;
+            info.album = album;
+            info.year = year;
+            info.genre = genre;
+            info.title = title;
+            info.track_number = track_number;
+            info.comment = comment;
+        }
+    };
+
+    //=========================================================================
+    // ID3v1
+
+    /**
+    * ID3v1 tags have fixed size Latin1 fields, padded with zeros or spaces.
+    */
+    QString readID3v1String(const char* data, int max_size)
+    {
+        int size = 0;
+        while (size < max_size && data[size] != 0)
+            ++size;
+
+        return QString::fromLatin1(data, size).trimmed();
+    }
+
+    /**
+    * The genre is only reported through has_genre, the ID3v1 genre names are left to TagLib.
+    */
+    bool readID3v1Tag(const char* data, BasicTag& tag, bool& has_genre)
+    {
+        tag.title = readID3v1String(data + 3, 30);
+        tag.artist = readID3v1String(data + 33, 30);
+        tag.album = readID3v1String(data + 63, 30);
+        tag.year = toIntLikeTagLib(readID3v1String(data + 93, 4));
+
+        // ID3v1.1 stores the track number in the last byte of the comment
+
+        if (data[97 + 28] == 0 && data[97 + 29] != 0)
+        {
+            tag.comment = readID3v1String(data + 97, 28);
+            tag.track_number = uchar(data[97 + 29]);
+        }
+        else
+        {
+            tag.comment = readID3v1String(data + 97, 30);
+        }
+
+        // TagLib only knows the genres 0-191, others are reported as empty
+
+        has_genre = uchar(data[127]) < 192;
+        return true;
+    }
+
+    //=========================================================================
+    // ID3v2
+
+    /**
+    * Decodes the text of a frame. Returns false for multiple null separated values,
+    * because TagLib versions differ in how these are joined.
+    */
+    bool decodeID3v2Text(uchar encoding, const char* data, qint64 size, QString& text)
+    {
+        if (encoding == 0 || encoding == 3)
+        {
+            qint64 end = 0;
+            while (end < size && data[end] != 0)
+                ++end;
+
+            for (qint64 i = end; i < size; ++i)
+                if (data[i] != 0)
+                    return false;
+
+            text = encoding == 0 ? QString::fromLatin1(data, end) : QString::fromUtf8(data, end);
+            return true;
+        }
+
+        if (encoding == 1 || encoding == 2)
+        {
+            if (size % 2 != 0)
+                size -= 1;
+
+            bool big_endian = encoding == 2;
+            qint64 pos = 0;
+
+            if (encoding == 1)
+            {
+                if (size < 2)
+                {
+                    text.clear();
+                    return size == 0;
+                }
+
+                const uchar b0 = uchar(data[0]);
+                const uchar b1 = uchar(data[1]);
+                if (b0 == 0xff && b1 == 0xfe)
+                    big_endian = false;
+                else if (b0 == 0xfe && b1 == 0xff)
+                    big_endian = true;
+                else
+                    return false;
+
+                pos = 2;
+            }
+
+            qint64 end = pos;
+            while (end + 1 < size && (data[end] != 0 || data[end + 1] != 0))
+                end += 2;
+
+            for (qint64 i = end; i < size; ++i)
+                if (data[i] != 0)
+                    return false;
+
+            text.resize((end - pos) / 2);
+            for (qsizetype i = 0; i < text.size(); ++i)
+            {
+                const char* c = data + pos + i * 2;
+                text[i] = QChar(big_endian ? qFromBigEndian<quint16>(c) : qFromLittleEndian<quint16>(c));
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+    * Returns the size of a null terminated string in the given encoding, including the terminator.
+    * -1 if there is no terminator.
+    */
+    qint64 terminatedStringSize(uchar encoding, const char* data, qint64 size)
+    {
+        if (encoding == 0 || encoding == 3)
+        {
+            for (qint64 i = 0; i < size; ++i)
+                if (data[i] == 0)
+                    return i + 1;
+        }
+        else
+        {
+            for (qint64 i = 0; i + 1 < size; i += 2)
+                if (data[i] == 0 && data[i + 1] == 0)
+                    return i + 2;
+        }
+
+        return -1;
+    }
+
+    struct ID3v2Tag
+    {
+        BasicTag basic;
+        QString album_artist;
+        int disc_number = 0;
+        qint64 cover_pos = 0;  //!< relative to the tag header, which is at the start of the file
+        qint64 cover_size = 0;
+    };
+
+    /**
+    * Parses ID3v2.3 and ID3v2.4 tags without unsynchronisation, extended header or any special frame flags.
+    * The data starts with the 10 byte tag header.
+    */
+    bool readID3v2Tag(const char* data, qint64 size, ID3v2Tag& tag)
+    {
+        const int version = uchar(data[3]);
+        if (version != 3 && version != 4)
+            return false;
+
+        // unsynchronisation, extended header, experimental, footer
+        if (uchar(data[5]) != 0)
+            return false;
+
+        std::map<QByteArray, bool> seen;
+        qint64 first_picture_pos = -1;
+        qint64 first_picture_size = 0;
+        bool has_front_cover = false;
+        bool has_comment_without_description = false;
+        QString genre;
+
+        qint64 pos = 10;
+        while (pos + 10 <= size)
+        {
+            const char* header = data + pos;
+
+            // padding
+            if (header[0] == 0)
+                break;
+
+            const QByteArray id(header, 4);
+            for (char c : id)
+                if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+                    return false;
+
+            if (version == 4 && !isSyncSafe(header + 4))
+                return false;
+
+            const qint64 frame_size = version == 4 ? fromSyncSafe(header + 4) : qFromBigEndian<quint32>(header + 4);
+            const quint16 flags = qFromBigEndian<quint16>(header + 8);
+
+            if (pos + 10 + frame_size > size)
+                return false;
+
+            // compression, encryption, grouping, unsynchronisation, data length indicator
+            const quint16 format_flags = version == 4 ? 0x004f : 0x00e0;
+            if (flags & format_flags)
+                return false;
+
+            const char* frame = header + 10;
+            const bool is_first = !seen[id];
+            seen[id] = true;
+
+            if (id == "TYER" && version == 4)
+                return false;
+            if (id == "TDRC" && version == 3)
+                return false;
+
+            static const QByteArray TEXT_FRAMES[] = { "TPE1", "TPE2", "TALB", "TIT2", "TRCK", "TPOS", "TYER", "TDRC", "TCON" };
+
+            if (std::ranges::find(TEXT_FRAMES, id) != std::end(TEXT_FRAMES) && is_first)
+            {
+                if (frame_size < 1)
+                    return false;
+
+                QString text;
+                if (!decodeID3v2Text(uchar(frame[0]), frame + 1, frame_size - 1, text))
+                    return false;
+
+                if (id == "TPE1")
+                    tag.basic.artist = text;
+                else if (id == "TPE2")
+                    tag.album_artist = text;
+                else if (id == "TALB")
+                    tag.basic.album = text;
+                else if (id == "TIT2")
+                    tag.basic.title = text;
+                else if (id == "TRCK")
+                    tag.basic.track_number = toIntLikeTagLib(text);
+                else if (id == "TPOS")
+                    tag.disc_number = toIntLikeTagLib(text);
+                else if (id == "TYER" || id == "TDRC")
+                    tag.basic.year = toIntLikeTagLib(text.left(4));
+                else if (id == "TCON")
+                    genre = text;
+            }
+            else if (id == "COMM")
+            {
+                // encoding, language, description, text
+
+                if (frame_size < 4)
+                    return false;
+
+                const uchar encoding = uchar(frame[0]);
+                const qint64 description_size = terminatedStringSize(encoding, frame + 4, frame_size - 4);
+                if (description_size < 0)
+                    return false;
+
+                QString description;
+                QString text;
+                if (!decodeID3v2Text(encoding, frame + 4, description_size, description) ||
+                    !decodeID3v2Text(encoding, frame + 4 + description_size, frame_size - 4 - description_size, text))
+                    return false;
+
+                // TagLib prefers the first comment without description
+
+                if (is_first || (description.isEmpty() && !has_comment_without_description))
+                    tag.basic.comment = text;
+
+                if (description.isEmpty())
+                    has_comment_without_description = true;
+            }
+            else if (id == "APIC")
+            {
+                // encoding, mime type, picture type, description, picture data
+
+                if (frame_size < 1)
+                    return false;
+
+                const uchar encoding = uchar(frame[0]);
+                const qint64 mime_size = terminatedStringSize(0, frame + 1, frame_size - 1);
+                if (mime_size < 0 || 1 + mime_size + 1 > frame_size)
+                    return false;
+
+                const uchar picture_type = uchar(frame[1 + mime_size]);
+                const qint64 description_pos = 1 + mime_size + 1;
+                const qint64 description_size = terminatedStringSize(encoding, frame + description_pos, frame_size - description_pos);
+                if (description_size < 0)
+                    return false;
+
+                // only the location is kept, the picture data is read when needed
+                const qint64 picture_pos = pos + 10 + description_pos + description_size;
+                const qint64 picture_size = frame_size - description_pos - description_size;
+
+                if (first_picture_pos < 0)
+                {
+                    first_picture_pos = picture_pos;
+                    first_picture_size = picture_size;
+                }
+
+                if (picture_type == 3 && !has_front_cover)
+                {
+                    tag.cover_pos = picture_pos;
+                    tag.cover_size = picture_size;
+                    has_front_cover = true;
+                }
+            }
+
+            pos += 10 + frame_size;
+        }
+
+        if (!has_front_cover && first_picture_pos >= 0)
+        {
+            tag.cover_pos = first_picture_pos;
+            tag.cover_size = first_picture_size;
+        }
+
+        // numeric genres refer to the ID3v1 genre list, leave that to TagLib
+        if (genre.startsWith('(') || isNumber(genre))
+            return false;
+
+        tag.basic.genre = genre;
+        return true;
+    }
+
+    //=========================================================================
+    // MPEG audio
+
+    struct MPEGHeader
+    {
+        int version_index = 0; // 0 = MPEG1, 1 = MPEG2, 2 = MPEG2.5
+        int layer = 0;
+        int bitrate_kbs = 0;
+        int samplerate_hz = 0;
+        int channels = 0;
+        int samples_per_frame = 0;
+        int frame_length = 0;
+    };
+
+    bool isFrameSync(const char* data)
+    {
+        const uchar b0 = uchar(data[0]);
+        const uchar b1 = uchar(data[1]);
+        return b0 == 0xff && b1 != 0xff && (b1 & 0xe0) == 0xe0;
+    }
+
+    bool parseMPEGHeader(const char* data, MPEGHeader& header)
+    {
+        static const int BITRATES[2][3][16] = {
+            {   // MPEG1
+                { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, 0 },
+                { 0, 32, 48, 56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 384, 0 },
+                { 0, 32, 40, 48,  56,  64,  80,  96, 112, 128, 160, 192, 224, 256, 320, 0 },
+            },
+            {   // MPEG2 and MPEG2.5
+                { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, 0 },
+                { 0,  8, 16, 24, 32, 40, 48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+                { 0,  8, 16, 24, 32, 40, 48,  56,  64,  80,  96, 112, 128, 144, 160, 0 },
+            },
+        };
+
+        static const int SAMPLERATES[3][3] = {
+            { 44100, 48000, 32000 },
+            { 22050, 24000, 16000 },
+            { 11025, 12000,  8000 },
+        };
+
+        static const int SAMPLES_PER_FRAME[3][2] = {
+            {  384,  384 },
+            { 1152, 1152 },
+            { 1152,  576 },
+        };
+
+        static const int PADDING_SIZE[3] = { 4, 1, 1 };
+
+        if (!isFrameSync(data))
+            return false;
+
+        const uchar b1 = uchar(data[1]);
+        const uchar b2 = uchar(data[2]);
+        const uchar b3 = uchar(data[3]);
+
+        switch ((b1 >> 3) & 0x03)
+        {
+        case 0: header.version_index = 2; break;
+        case 2: header.version_index = 1; break;
+        case 3: header.version_index = 0; break;
+        default: return false;
+        }
+
+        switch ((b1 >> 1) & 0x03)
+        {
+        case 1: header.layer = 3; break;
+        case 2: header.layer = 2; break;
+        case 3: header.layer = 1; break;
+        default: return false;
+        }
+
+        const int bitrate_index = (b2 >> 4) & 0x0f;
+        const int samplerate_index = (b2 >> 2) & 0x03;
+        if (samplerate_index == 3)
+            return false;
+
+        header.bitrate_kbs = BITRATES[header.version_index == 0 ? 0 : 1][header.layer - 1][bitrate_index];
+        if (header.bitrate_kbs == 0)
+            return false;
+
+        header.samplerate_hz = SAMPLERATES[header.version_index][samplerate_index];
+        header.channels = ((b3 >> 6) & 0x03) == 3 ? 1 : 2;
+        header.samples_per_frame = SAMPLES_PER_FRAME[header.layer - 1][header.version_index == 0 ? 0 : 1];
+
+        const bool is_padded = (b2 & 0x02) != 0;
+        header.frame_length = header.samples_per_frame * header.bitrate_kbs * 125 / header.samplerate_hz + (is_padded ? PADDING_SIZE[header.layer - 1] : 0);
+        return true;
+    }
+
+    /**
+    * Like TagLib, a frame header is only accepted if the next frame header matches.
+    */
+    bool findFirstMPEGFrame(HeadWindow& window, qint64 start, qint64& frame_pos, MPEGHeader& header)
+    {
+        for (qint64 pos = start; pos < start + MAX_FRAME_SYNC_SEARCH; ++pos)
+        {
+            if (!window.ensure(pos + 4))
+                return false;
+
+            if (!parseMPEGHeader(window.data() + pos, header))
+                continue;
+
+            const qint64 next_pos = pos + header.frame_length;
+            if (!window.ensure(next_pos + 4))
+                return false;
+
+            const uchar* a = reinterpret_cast<const uchar*>(window.data() + pos);
+            const uchar* b = reinterpret_cast<const uchar*>(window.data() + next_pos);
+            if (b[0] == 0xff && (b[1] & 0xfe) == (a[1] & 0xfe) && (b[2] & 0x0c) == (a[2] & 0x0c))
+            {
+                frame_pos = pos;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+    * Xing, Info or VBRI headers in the first frame store the total number of frames and bytes.
+    */
+    bool readVBRHeader(const char* frame, qint64 frame_size, quint32& frames, quint32& bytes)
+    {
+        const QByteArrayView view(frame, frame_size);
+
+        qsizetype pos = view.indexOf("Xing");
+        if (pos < 0)
+            pos = view.indexOf("Info");
+
+        if (pos >= 0)
+        {
+            if (pos + 16 > frame_size || (uchar(frame[pos + 7]) & 0x03) != 0x03)
+                return false;
+
+            frames = qFromBigEndian<quint32>(frame + pos + 8);
+            bytes = qFromBigEndian<quint32>(frame + pos + 12);
+            return frames > 0 && bytes > 0;
+        }
+
+        pos = view.indexOf("VBRI");
+        if (pos >= 0)
+        {
+            if (pos + 18 > frame_size)
+                return false;
+
+            bytes = qFromBigEndian<quint32>(frame + pos + 10);
+            frames = qFromBigEndian<quint32>(frame + pos + 14);
+            return frames > 0 && bytes > 0;
+        }
+
+        return false;
+    }
+
+    /**
+    * Like TagLib, searches backwards from the end of the stream for the last frame that matches the first one,
+    * so trailing garbage or unknown tags don't count as audio.
+    */
+    bool findLastMPEGFrame(QFile& file, qint64 start, qint64 end, const MPEGHeader& first_header, qint64& stream_end)
+    {
+        const qint64 search_start = std::max(start, end - LAST_FRAME_SEARCH_SIZE);
+        const QByteArray buffer = readBlock(file, search_start, end - search_start);
+
+        for (qint64 pos = buffer.size() - 4; pos >= 0; --pos)
+        {
+            MPEGHeader header;
+            if (!parseMPEGHeader(buffer.constData() + pos, header))
+                continue;
+
+            if (header.version_index != first_header.version_index || header.layer != first_header.layer || header.samplerate_hz != first_header.samplerate_hz)
+                continue;
+
+            if (search_start + pos + header.frame_length > end)
+                continue;
+
+            stream_end = search_start + pos + header.frame_length;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool readMPEGFile(QFile& file, TrackInfo& info, AudioPropertiesMode mode, QByteArray* cover_data)
+    {
+        HeadWindow window(file);
+        if (!window.ensure(std::min(file.size(), HEAD_WINDOW_SIZE)) || window.size() < 10)
+            return false;
+
+        // tags at the end of the file
+
+        const QByteArray tail = readBlock(file, std::max<qint64>(0, file.size() - ID3V1_SIZE - APE_FOOTER_SIZE), ID3V1_SIZE + APE_FOOTER_SIZE);
+        const bool has_id3v1 = tail.size() >= ID3V1_SIZE && tail.right(ID3V1_SIZE).startsWith("TAG");
+        const qint64 stream_end = file.size() - (has_id3v1 ? ID3V1_SIZE : 0);
+
+        // APE tags are rare in MP3 files, leave them to TagLib
+        if (tail.contains("APETAGEX"))
+            return false;
+
+        // ID3v2 at the start
+
+        qint64 audio_start = 0;
+        ID3v2Tag id3v2;
+        const bool has_id3v2 = window.data()[0] == 'I' && window.data()[1] == 'D' && window.data()[2] == '3';
+
+        if (has_id3v2)
+        {
+            if (!isSyncSafe(window.data() + 6))
+                return false;
+
+            const qint64 tag_size = 10 + fromSyncSafe(window.data() + 6);
+            if (!window.ensure(tag_size) || !readID3v2Tag(window.data(), tag_size, id3v2))
+                return false;
+
+            audio_start = tag_size;
+        }
+
+        BasicTag id3v1;
+        bool id3v1_has_genre = false;
+        if (has_id3v1 && !readID3v1Tag(tail.constData() + tail.size() - ID3V1_SIZE, id3v1, id3v1_has_genre))
+            return false;
+
+        if (id3v1_has_genre && id3v2.basic.genre.isEmpty())
+            return false;
+
+        // audio properties
+
+        qint64 frame_pos = 0;
+        MPEGHeader header;
+        if (!findFirstMPEGFrame(window, audio_start, frame_pos, header) || !window.ensure(frame_pos + header.frame_length))
+            return false;
+
+        TrackInfo result;
+
+        quint32 vbr_frames = 0;
+        quint32 vbr_bytes = 0;
+        if (readVBRHeader(window.data() + frame_pos, header.frame_length, vbr_frames, vbr_bytes))
+        {
+            const double length = double(header.samples_per_frame) * 1000.0 / header.samplerate_hz * vbr_frames;
+            result.length_milliseconds = static_cast<int>(length + 0.5);
+            result.bitrate_kbs = static_cast<int>(vbr_bytes * 8.0 / length + 0.5);
+        }
+        else
+        {
+            // assume constant bitrate, like TagLib, which only reads the first and the last frame.
+            // The fast mode doesn't look for the last frame and counts everything up to the tags at the end.
+
+            qint64 last_frame_end = stream_end;
+            if (mode == AudioPropertiesMode::ACCURATE && !findLastMPEGFrame(file, frame_pos, stream_end, header, last_frame_end))
+                return false;
+
+            result.bitrate_kbs = header.bitrate_kbs;
+            result.length_milliseconds = static_cast<int>((last_frame_end - frame_pos) * 8.0 / header.bitrate_kbs + 0.5);
+            result.audio_properties_estimated = mode == AudioPropertiesMode::FAST;
+        }
+
+        result.channels = header.channels;
+        result.samplerate_hz = header.samplerate_hz;
+
+        // merge tags with the same priority as TagLib
+
+        BasicTag basic = id3v2.basic;
+        if (has_id3v1)
+        {
+            if (basic.artist.isEmpty()) basic.artist = id3v1.artist;
+            if (basic.album.isEmpty()) basic.album = id3v1.album;
+            if (basic.year == 0) basic.year = id3v1.year;
+            if (basic.title.isEmpty()) basic.title = id3v1.title;
+            if (basic.track_number == 0) basic.track_number = id3v1.track_number;
+            if (basic.comment.isEmpty()) basic.comment = id3v1.comment;
+        }
+
+        basic.mergeInto(result);
+
+        if (has_id3v1)
+            appendTagType("ID3v1", result);
+
+        if (has_id3v2)
+        {
+            appendTagType("ID3v2", result);
+            const QByteArrayView cover(window.data() + id3v2.cover_pos, id3v2.cover_size);
+            result.cover = createCoverLocation(file.fileName(), cover, id3v2.cover_pos);
+            if (cover_data)
+                *cover_data = cover.toByteArray();
+            result.album_artist = id3v2.album_artist;
+            result.disc_number = id3v2.disc_number;
+        }
+
+        info = result;
+        return true;
+    }
+
+    //=========================================================================
+    // Vorbis comments
+
+    /**
+    * Parses the FLAC picture structure, which is also used base64 encoded in Vorbis comments.
+    */
+    bool parseFLACPicture(const QByteArray& data, quint32& type, QByteArray& picture)
+    {
+        const char* p = data.constData();
+        const qint64 size = data.size();
+
+        qint64 pos = 0;
+        auto readUInt = [&](quint32& value) {
+            if (pos + 4 > size)
+                return false;
+            value = qFromBigEndian<quint32>(p + pos);
+            pos += 4;
+            return true;
+        };
+
+        quint32 mime_size = 0;
+        quint32 description_size = 0;
+        quint32 unused = 0;
+        quint32 picture_size = 0;
+
+        if (!readUInt(type) || !readUInt(mime_size))
+            return false;
+        pos += mime_size;
+
+        if (!readUInt(description_size))
+            return false;
+        pos += description_size;
+
+        // width, height, color depth, number of colors
+        for (int i = 0; i < 4; ++i)
+            if (!readUInt(unused))
+                return false;
+
+        if (!readUInt(picture_size) || pos + picture_size > size)
+            return false;
+
+        picture = data.mid(pos, picture_size);
+        return true;
+    }
+
+    struct VorbisComment
+    {
+        std::map<QString, QStringList> fields;
+        QByteArray cover;
+    };
+
+    bool readVorbisComment(const char* data, qint64 size, VorbisComment& comment)
+    {
+        qint64 pos = 0;
+        auto readUInt = [&](quint32& value) {
+            if (pos + 4 > size)
+                return false;
+            value = qFromLittleEndian<quint32>(data + pos);
+            pos += 4;
+            return true;
+        };
+
+        quint32 vendor_size = 0;
+        if (!readUInt(vendor_size))
+            return false;
+        pos += vendor_size;
+
+        quint32 count = 0;
+        if (!readUInt(count))
+            return false;
+
+        QByteArray first_picture;
+        bool has_front_cover = false;
+
+        for (quint32 i = 0; i < count; ++i)
+        {
+            quint32 field_size = 0;
+            if (!readUInt(field_size) || pos + field_size > size)
+                return false;
+
+            const QByteArrayView field(data + pos, field_size);
+            pos += field_size;
+
+            const qsizetype separator = field.indexOf('=');
+            if (separator <= 0)
+                continue;
+
+            const QByteArrayView key = field.first(separator);
+            for (char c : key)
+                if (uchar(c) < 0x20 || uchar(c) > 0x7d)
+                    return false;
+
+            const QString name = QString::fromLatin1(key).toUpper();
+            const QByteArrayView value = field.sliced(separator + 1);
+
+            if (name == "COVERART")
+                return false;
+
+            if (name == "METADATA_BLOCK_PICTURE")
+            {
+                const QByteArray::FromBase64Result decoded = QByteArray::fromBase64Encoding(value.toByteArray());
+
+                quint32 type = 0;
+                QByteArray picture;
+                if (decoded && parseFLACPicture(*decoded, type, picture))
+                {
+                    if (first_picture.isNull())
+                        first_picture = picture;
+
+                    if (type == 3 && !has_front_cover)
+                    {
+                        comment.cover = picture;
+                        has_front_cover = true;
+                    }
+                }
+                continue;
+            }
+
+            comment.fields[name].append(QString::fromUtf8(value));
+        }
+
+        if (!has_front_cover)
+            comment.cover = first_picture;
+
+        return true;
+    }
+
+    /**
+    * Converts the comment to the track info, with the same field mapping as TagLib::Ogg::XiphComment.
+    */
+    bool readXiphComment(const QFile& file, const VorbisComment& comment, TrackInfo& info, QByteArray* cover_data)
+    {
+        auto values = [&](const char* name) {
+            const auto it = comment.fields.find(QString::fromLatin1(name));
+            return it != comment.fields.end() ? it->second : QStringList();
+        };
+
+        // TagLib versions differ in how multiple values are joined
+        auto single = [&](const char* name, QString& result) {
+            const QStringList list = values(name);
+            if (list.size() > 1)
+                return false;
+            result = list.isEmpty() ? QString() : list.front();
+            return true;
+        };
+
+        auto number = [&](const char* name, const char* fallback_name) {
+            QStringList list = values(name);
+            if (list.isEmpty())
+                list = values(fallback_name);
+            return list.isEmpty() ? 0 : toIntLikeTagLib(list.front());
+        };
+
+        BasicTag basic;
+        if (!single("ARTIST", basic.artist) ||
+            !single("ALBUM", basic.album) ||
+            !single("GENRE", basic.genre) ||
+            !single("TITLE", basic.title))
+            return false;
+
+        if (!values("DESCRIPTION").isEmpty())
+        {
+            if (!single("DESCRIPTION", basic.comment))
+                return false;
+        }
+        else if (!single("COMMENT", basic.comment))
+        {
+            return false;
+        }
+
+        basic.year = number("DATE", "YEAR");
+        basic.track_number = number("TRACKNUMBER", "TRACKNUM");
+        basic.mergeInto(info);
+
+        appendTagType("Vorbis comment", info);
+
+        // the picture is base64 encoded, so there is no location to read it from directly
+        info.cover = createCoverLocation(file.fileName(), comment.cover, -1);
+        if (cover_data)
+            *cover_data = comment.cover;
+
+        const QStringList album_artists = values("ALBUMARTIST");
+        if (!album_artists.isEmpty())
+            info.album_artist = album_artists.front();
+
+        const QStringList disc_numbers = values("DISCNUMBER");
+        if (!disc_numbers.isEmpty())
+            info.disc_number = toIntLikeTagLib(disc_numbers.front());
+
+        return true;
+    }
+
+    //=========================================================================
+    // FLAC
+
+    bool readFLACFile(QFile& file, TrackInfo& info, QByteArray* cover_data)
+    {
+        // FLAC files with ID3 tags are left to TagLib
+
+        QByteArray block_header = readBlock(file, 0, 4);
+        if (block_header != "fLaC")
+            return false;
+
+        const QByteArray tail = readBlock(file, std::max<qint64>(0, file.size() - ID3V1_SIZE), ID3V1_SIZE);
+        if (tail.startsWith("TAG"))
+            return false;
+
+        QByteArray stream_info;
+        QByteArray vorbis_comment;
+        bool has_vorbis_comment = false;
+
+        // metadata blocks, skip everything except stream info and comments
+
+        qint64 pos = 4;
+        for (bool is_last = false; !is_last; )
+        {
+            block_header = readBlock(file, pos, 4);
+            if (block_header.size() != 4)
+                return false;
+
+            is_last = (uchar(block_header[0]) & 0x80) != 0;
+            const int type = uchar(block_header[0]) & 0x7f;
+            const qint64 block_size = (qint64(uchar(block_header[1])) << 16) | (qint64(uchar(block_header[2])) << 8) | qint64(uchar(block_header[3]));
+
+            if (type == 0)
+            {
+                if (pos != 4)
+                    return false;
+                stream_info = readBlock(file, pos + 4, block_size);
+            }
+            else if (type == 4)
+            {
+                if (has_vorbis_comment)
+                    return false;
+                vorbis_comment = readBlock(file, pos + 4, block_size);
+                has_vorbis_comment = true;
+                if (vorbis_comment.size() != block_size)
+                    return false;
+            }
+            else if (type == 127)
+            {
+                return false;
+            }
+
+            pos += 4 + block_size;
+        }
+
+        if (stream_info.size() < 18)
+            return false;
+
+        TrackInfo result;
+
+        if (has_vorbis_comment)
+        {
+            VorbisComment comment;
+            if (!readVorbisComment(vorbis_comment.constData(), vorbis_comment.size(), comment) || !readXiphComment(file, comment, result, cover_data))
+                return false;
+        }
+
+        // sample rate (20 bits), channels (3 bits), bits per sample (5 bits), total samples (36 bits)
+
+        const quint32 flags = qFromBigEndian<quint32>(stream_info.constData() + 10);
+        const quint64 total_samples = (quint64(flags & 0x0f) << 32) | qFromBigEndian<quint32>(stream_info.constData() + 14);
+
+        result.samplerate_hz = flags >> 12;
+        result.channels = ((flags >> 9) & 0x07) + 1;
+
+        if (total_samples > 0 && result.samplerate_hz > 0)
+        {
+            const double length = total_samples * 1000.0 / result.samplerate_hz;
+            const qint64 stream_length = file.size() - pos;
+            result.length_milliseconds = static_cast<int>(length + 0.5);
+            result.bitrate_kbs = static_cast<int>(stream_length * 8.0 / length + 0.5);
+        }
+
+        info = result;
+        return true;
+    }
+
+    //=========================================================================
+    // Ogg
+
+    struct OggStream
+    {
+        std::vector<QByteArray> packets;
+        quint32 serial = 0;
+        quint64 first_granule = 0;
+        quint64 last_granule = 0;
+    };
+
+    /**
+    * Reassembles the first packets of a logical stream, plus the granule position of the last page.
+    */
+    bool readOggStream(QFile& file, size_t number_of_packets, OggStream& stream)
+    {
+        HeadWindow window(file);
+        QByteArray current_packet;
+
+        qint64 pos = 0;
+        while (stream.packets.size() < number_of_packets)
+        {
+            if (!window.ensure(pos + 27))
+                return false;
+
+            const char* page = window.data() + pos;
+            if (!QByteArrayView(page, 4).startsWith("OggS") || page[4] != 0)
+                return false;
+
+            const quint32 serial = qFromLittleEndian<quint32>(page + 14);
+            if (pos == 0)
+            {
+                stream.serial = serial;
+                stream.first_granule = qFromLittleEndian<quint64>(page + 6);
+            }
+            else if (serial != stream.serial)
+            {
+                // multiplexed streams are left to TagLib
+                return false;
+            }
+
+            const int number_of_segments = uchar(page[26]);
+            if (!window.ensure(pos + 27 + number_of_segments))
+                return false;
+
+            page = window.data() + pos;
+            qint64 data_size = 0;
+            for (int i = 0; i < number_of_segments; ++i)
+                data_size += uchar(page[27 + i]);
+
+            if (!window.ensure(pos + 27 + number_of_segments + data_size))
+                return false;
+
+            page = window.data() + pos;
+            const char* segment = page + 27 + number_of_segments;
+            for (int i = 0; i < number_of_segments && stream.packets.size() < number_of_packets; ++i)
+            {
+                const int segment_size = uchar(page[27 + i]);
+                current_packet.append(segment, segment_size);
+                segment += segment_size;
+
+                if (segment_size < 255)
+                {
+                    stream.packets.push_back(current_packet);
+                    current_packet.clear();
+                }
+            }
+
+            pos += 27 + number_of_segments + data_size;
+        }
+
+        // the last page is needed for the stream length
+
+        const qint64 tail_pos = std::max<qint64>(0, file.size() - TAIL_WINDOW_SIZE);
+        const QByteArray tail = readBlock(file, tail_pos, TAIL_WINDOW_SIZE);
+        const qsizetype last_page = tail.lastIndexOf("OggS");
+        if (last_page < 0 || last_page + 27 > tail.size())
+            return false;
+
+        if (qFromLittleEndian<quint32>(tail.constData() + last_page + 14) != stream.serial)
+            return false;
+
+        stream.last_granule = qFromLittleEndian<quint64>(tail.constData() + last_page + 6);
+        return true;
+    }
+
+    bool readOggVorbisFile(QFile& file, TrackInfo& info, QByteArray* cover_data)
+    {
+        OggStream stream;
+        if (!readOggStream(file, 3, stream))
+            return false;
+
+        const QByteArray& identification = stream.packets[0];
+        const QByteArray& comment_packet = stream.packets[1];
+
+        if (identification.size() < 30 || !identification.startsWith("\x01vorbis"))
+            return false;
+        if (!comment_packet.startsWith("\x03vorbis"))
+            return false;
+
+        TrackInfo result;
+
+        VorbisComment comment;
+        if (!readVorbisComment(comment_packet.constData() + 7, comment_packet.size() - 7, comment) || !readXiphComment(file, comment, result, cover_data))
+            return false;
+
+        result.channels = uchar(identification[11]);
+        result.samplerate_hz = qFromLittleEndian<quint32>(identification.constData() + 12);
+        const quint32 bitrate_nominal = qFromLittleEndian<quint32>(identification.constData() + 20);
+
+        if (result.samplerate_hz > 0 && stream.last_granule > stream.first_granule)
+        {
+            const double length = (stream.last_granule - stream.first_granule) * 1000.0 / result.samplerate_hz;
+            const qint64 stream_length = file.size() - stream.packets[0].size() - stream.packets[1].size() - stream.packets[2].size();
+            result.length_milliseconds = static_cast<int>(length + 0.5);
+            result.bitrate_kbs = static_cast<int>(stream_length * 8.0 / length + 0.5);
+        }
+
+        if (result.bitrate_kbs == 0 && bitrate_nominal > 0)
+            result.bitrate_kbs = static_cast<int>(bitrate_nominal / 1000.0 + 0.5);
+
+        info = result;
+        return true;
+    }
+
+    bool readOpusFile(QFile& file, TrackInfo& info, QByteArray* cover_data)
+    {
+        OggStream stream;
+        if (!readOggStream(file, 2, stream))
+            return false;
+
+        const QByteArray& identification = stream.packets[0];
+        const QByteArray& comment_packet = stream.packets[1];
+
+        if (identification.size() < 19 || !identification.startsWith("OpusHead"))
+            return false;
+        if (!comment_packet.startsWith("OpusTags"))
+            return false;
+
+        TrackInfo result;
+
+        VorbisComment comment;
+        if (!readVorbisComment(comment_packet.constData() + 8, comment_packet.size() - 8, comment) || !readXiphComment(file, comment, result, cover_data))
+            return false;
+
+        // opus always decodes at 48 kHz
+        result.channels = uchar(identification[9]);
+        result.samplerate_hz = 48000;
+        const quint16 pre_skip = qFromLittleEndian<quint16>(identification.constData() + 10);
+
+        if (stream.last_granule > stream.first_granule + pre_skip)
+        {
+            const double length = (stream.last_granule - stream.first_granule - pre_skip) * 1000.0 / 48000.0;
+            const qint64 stream_length = file.size() - stream.packets[0].size() - stream.packets[1].size();
+            result.length_milliseconds = static_cast<int>(length + 0.5);
+            result.bitrate_kbs = static_cast<int>(stream_length * 8.0 / length + 0.5);
+        }
+
+        info = result;
+        return true;
+    }
+}
+
+bool readTrackInfoNative(const QString& filepath, TrackInfo& info, AudioPropertiesMode mode, QByteArray* cover_data)
+{
+    // TagLib also picks the format from the file extension
+    const QString suffix = QFileInfo(filepath).suffix().toLower();
+
+    if (suffix != "mp3" && suffix != "flac" && suffix != "ogg" && suffix != "opus")
+        return false;
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    if (suffix == "mp3")
+        return readMPEGFile(file, info, mode, cover_data);
+    if (suffix == "flac")
+        return readFLACFile(file, info, cover_data);
+    if (suffix == "ogg")
+        return readOggVorbisFile(file, info, cover_data);
+
+    return readOpusFile(file, info, cover_data);
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include "TrackInfoReader.h"
+
+/**
+* Reads the track info of the most common formats (MP3 with ID3v1/ID3v2, FLAC, Ogg Vorbis, Opus) without TagLib.
+*
+* Only the tag region at the start of the file and a small window at its end are read.
+* The results are meant to match what TagLib reports for the same file.
+* Returns false for unsupported formats and on anything unusual, so the caller can fall back to TagLib.
+* In that case, info is left unchanged.
+*
+* MP3 files without a Xing/Info/VBRI header are assumed to have a constant bitrate, like TagLib does.
+* In accurate mode, their length is measured up to the last frame, which is searched near the end of the file.
+* In fast mode, it is estimated from the file size.
+*
+* If cover_data is given, the picture data of the cover is copied there.
+*/
+bool readTrackInfoNative(const QString& filepath, TrackInfo& info, AudioPropertiesMode mode = AudioPropertiesMode::ACCURATE, QByteArray* cover_data = nullptr);
\ No newline at end of file
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "PerformanceCounters.h"
+
+#include <algorithm>
+
+void PerformanceCounters::addParseLatency(std::chrono::steady_clock::duration duration)
+{
+    const double milliseconds = std::chrono::duration<double, std::milli>(duration).count();
+    const auto bucket = static_cast<size_t>(std::ranges::lower_bound(PARSE_LATENCY_LIMITS_MS, milliseconds) - PARSE_LATENCY_LIMITS_MS.begin());
+
+    parse_latency_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PerformanceCounters::addLockWait(std::chrono::steady_clock::duration duration)
+{
+    lock_wait_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(), std::memory_order_relaxed);
+    lock_contentions.fetch_add(1, std::memory_order_relaxed);
+}
+
+PerformanceCounters& getPerformanceCounters()
+{
+    static PerformanceCounters counters;
+    return counters;
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <QtCore/qglobal.h>
+
+/**
+* Live numbers for the performance window. They are written from the GUI and the loader threads,
+* so every counter is atomic. Durations are in nanoseconds.
+*/
+struct PerformanceCounters
+{
+    //! upper limits of the tag parse latency buckets, the last bucket takes everything slower
+    static constexpr std::array<double, 11> PARSE_LATENCY_LIMITS_MS = { 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250 };
+
+    std::atomic<float> scan_files_per_sec = 0;
+    std::atomic<float> scan_megabytes_per_sec = 0;
+    std::array<std::atomic<quint64>, PARSE_LATENCY_LIMITS_MS.size() + 1> parse_latency_histogram = {};
+
+    std::atomic<qint64> lock_wait_ns = 0;         //!< total time spent waiting for the library lock
+    std::atomic<quint64> lock_contentions = 0;    //!< number of lock acquisitions which had to wait
+    std::atomic<qint64> last_snapshot_ns = 0;     //!< time to update the snapshot for the readers, outside of the library lock
+
+    std::atomic<qint64> last_view_build_ns = 0;
+    std::atomic<int> last_view_rows = 0;
+    std::atomic<qint64> last_sort_ns = 0;
+
+    std::atomic<qint64> cache_load_ns = 0;
+    std::atomic<qint64> cache_save_ns = 0;
+
+    void addParseLatency(std::chrono::steady_clock::duration duration);
+    void addLockWait(std::chrono::steady_clock::duration duration);
+};
+
+PerformanceCounters& getPerformanceCounters();
+
+/**
+* Stores the time from construction to destruction in a counter.
+*/
+class ScopedDurationCounter
+{
+public:
+    explicit ScopedDurationCounter(std::atomic<qint64>& counter_ns)
+        : _counter_ns(counter_ns)
+        , _start_time(std::chrono::steady_clock::now())
+    {}
+
+    ~ScopedDurationCounter()
+    {
+        _counter_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start_time).count();
+    }
+
+    ScopedDurationCounter(const ScopedDurationCounter&) = delete;
+    ScopedDurationCounter& operator=(const ScopedDurationCounter&) = delete;
+
+private:
+    std::atomic<qint64>& _counter_ns;
+    std::chrono::steady_clock::time_point _start_time;
+};
\ No newline at end of file
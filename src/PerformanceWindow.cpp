@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "PerformanceWindow.h"
+
+#include <algorithm>
+#include <climits>
+#include <QtCore/qtimer.h>
+#include <QtWidgets/qboxlayout.h>
+#include <QtWidgets/qformlayout.h>
+#include <QtWidgets/qgroupbox.h>
+#include <QtWidgets/qlabel.h>
+#include <QtWidgets/qprogressbar.h>
+#include <QtWidgets/qpushbutton.h>
+#include "PerformanceCounters.h"
+
+namespace {
+    QString formatMilliseconds(qint64 nanoseconds)
+    {
+        return QString("%1 ms").arg(nanoseconds / 1000000.0, 0, 'f', 1);
+    }
+
+    QString formatMegabytes(qint64 bytes)
+    {
+        return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+    QFormLayout* addGroup(QVBoxLayout* layout, const QString& title)
+    {
+        auto group = new QGroupBox(title);
+        layout->addWidget(group);
+
+        return new QFormLayout(group);
+    }
+}
+
+PerformanceDialog::PerformanceDialog(QWidget* parent, ThreadSafeAudioLibrary& library, std::function<const AudioLibraryModel*()> get_current_model)
+    : QDialog(parent)
+    , _library(library)
+    , _get_current_model(get_current_model)
+{
+    setWindowTitle(tr("Performance"));
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    auto layout = new QVBoxLayout(this);
+
+    QFormLayout* scan_layout = addGroup(layout, tr("Scan"));
+    _scan_throughput = new QLabel();
+    scan_layout->addRow(tr("Throughput:"), _scan_throughput);
+
+    // one bar per latency bucket, relative to the total number of parsed files
+
+    QFormLayout* parse_layout = addGroup(layout, tr("Tag parse latency"));
+    for (size_t i = 0; i <= PerformanceCounters::PARSE_LATENCY_LIMITS_MS.size(); ++i)
+    {
+        const QString label = i < PerformanceCounters::PARSE_LATENCY_LIMITS_MS.size() ?
+            QString(QChar(0x2264)) + QString(" %1 ms").arg(PerformanceCounters::PARSE_LATENCY_LIMITS_MS[i]) :
+            QString("> %1 ms").arg(PerformanceCounters::PARSE_LATENCY_LIMITS_MS.back());
+
+        auto bar = new QProgressBar();
+        bar->setFormat("%v");
+        _parse_latency_bars.push_back(bar);
+        parse_layout->addRow(label, bar);
+    }
+
+    QFormLayout* lock_layout = addGroup(layout, tr("Library lock"));
+    _lock_wait_time = new QLabel();
+    _snapshot_time = new QLabel();
+    lock_layout->addRow(tr("Wait time:"), _lock_wait_time);
+    lock_layout->addRow(tr("Last snapshot time:"), _snapshot_time);
+
+    QFormLayout* view_layout = addGroup(layout, tr("View"));
+    _view_build_time = new QLabel();
+    _view_rows = new QLabel();
+    _sort_time = new QLabel();
+    view_layout->addRow(tr("Last build time:"), _view_build_time);
+    view_layout->addRow(tr("Rows:"), _view_rows);
+    view_layout->addRow(tr("Last sort time:"), _sort_time);
+
+    QFormLayout* decoration_layout = addGroup(layout, tr("Covers"));
+    _decorations_pending = new QLabel();
+    _decorations_decoded = new QLabel();
+    _decoration_memory = new QLabel();
+    decoration_layout->addRow(tr("Pending:"), _decorations_pending);
+    decoration_layout->addRow(tr("Decoded:"), _decorations_decoded);
+    decoration_layout->addRow(tr("Memory:"), _decoration_memory);
+
+    QFormLayout* cache_layout = addGroup(layout, tr("Cache"));
+    _cache_load_time = new QLabel();
+    _cache_save_time = new QLabel();
+    cache_layout->addRow(tr("Load time:"), _cache_load_time);
+    cache_layout->addRow(tr("Save time:"), _cache_save_time);
+
+    QFormLayout* memory_layout = addGroup(layout, tr("Memory"));
+    _library_memory = new QLabel();
+    _model_memory = new QLabel();
+    auto measure_button = new QPushButton(tr("Measure"));
+    connect(measure_button, &QPushButton::clicked, this, &PerformanceDialog::measureMemory);
+    memory_layout->addRow(tr("Library:"), _library_memory);
+    memory_layout->addRow(tr("View:"), _model_memory);
+    memory_layout->addRow(QString(), measure_button);
+
+    auto timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &PerformanceDialog::updateCounters);
+    timer->start(500);
+
+    updateCounters();
+}
+
+void PerformanceDialog::updateCounters()
+{
+    const PerformanceCounters& counters = getPerformanceCounters();
+
+    _scan_throughput->setText(tr("%1 files/s, %2 MB/s").arg(counters.scan_files_per_sec.load(), 0, 'f', 0).arg(counters.scan_megabytes_per_sec.load(), 0, 'f', 1));
+
+    quint64 files_parsed = 0;
+    for (const auto& count : counters.parse_latency_histogram)
+        files_parsed += count.load();
+
+    // progress bars only take int, the counts are scaled down for very large scans
+
+    const quint64 scale = files_parsed / INT_MAX + 1;
+
+    for (size_t i = 0; i < _parse_latency_bars.size(); ++i)
+    {
+        _parse_latency_bars[i]->setMaximum(static_cast<int>(std::max<quint64>(files_parsed / scale, 1)));
+        _parse_latency_bars[i]->setValue(static_cast<int>(counters.parse_latency_histogram[i].load() / scale));
+    }
+
+    _lock_wait_time->setText(tr("%1 in %n contended acquisitions", "", static_cast<int>(counters.lock_contentions.load())).arg(formatMilliseconds(counters.lock_wait_ns.load())));
+
+    _snapshot_time->setText(formatMilliseconds(counters.last_snapshot_ns.load()));
+
+    _view_build_time->setText(formatMilliseconds(counters.last_view_build_ns.load()));
+    _view_rows->setText(QString::number(counters.last_view_rows.load()));
+    _sort_time->setText(formatMilliseconds(counters.last_sort_ns.load()));
+
+    const AudioLibraryModel::DecorationStatistics decoration_statistics = _get_current_model()->getDecorationStatistics();
+    _decorations_pending->setText(QString::number(decoration_statistics.pending));
+    _decorations_decoded->setText(QString::number(decoration_statistics.decoded));
+    _decoration_memory->setText(formatMegabytes(decoration_statistics.memory_bytes));
+
+    _cache_load_time->setText(formatMilliseconds(counters.cache_load_ns.load()));
+    _cache_save_time->setText(formatMilliseconds(counters.cache_save_ns.load()));
+}
+
+void PerformanceDialog::measureMemory()
+{
+    AudioLibrary::MemoryUsage library_usage;
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+        library_usage = acc.getLibrary().getMemoryUsage();
+    }
+
+    _library_memory->setText(tr("%1 (strings %2, tracks %3, albums %4, covers %5, maps %6, search index %7)")
+        .arg(formatMegabytes(library_usage.total()))
+        .arg(formatMegabytes(library_usage.strings))
+        .arg(formatMegabytes(library_usage.tracks))
+        .arg(formatMegabytes(library_usage.albums))
+        .arg(formatMegabytes(library_usage.covers))
+        .arg(formatMegabytes(library_usage.maps))
+        .arg(formatMegabytes(library_usage.search_index)));
+
+    const AudioLibraryModel::MemoryUsage model_usage = _get_current_model()->getMemoryUsage();
+
+    _model_memory->setText(tr("%1 (rows %2, display strings %3, sort strings %4, covers %5)")
+        .arg(formatMegabytes(model_usage.total()))
+        .arg(formatMegabytes(model_usage.rows))
+        .arg(formatMegabytes(model_usage.display_strings))
+        .arg(formatMegabytes(model_usage.sort_strings))
+        .arg(formatMegabytes(model_usage.decorations)));
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <functional>
+#include <QtWidgets/qdialog.h>
+#include "AudioLibraryModel.h"
+#include "ThreadSafeAudioLibrary.h"
+
+class QLabel;
+class QProgressBar;
+
+/**
+* Shows the performance counters and the decoration state of the current model, updated twice a second.
+* Measuring the memory walks the whole library, so it's only done on request.
+*/
+class PerformanceDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    PerformanceDialog(QWidget* parent, ThreadSafeAudioLibrary& library, std::function<const AudioLibraryModel*()> get_current_model);
+
+private:
+    void updateCounters();
+    void measureMemory();
+
+    ThreadSafeAudioLibrary& _library;
+    std::function<const AudioLibraryModel*()> _get_current_model;
+
+    QLabel* _scan_throughput = nullptr;
+    std::vector<QProgressBar*> _parse_latency_bars;
+    QLabel* _lock_wait_time = nullptr;
+    QLabel* _snapshot_time = nullptr;
+    QLabel* _view_build_time = nullptr;
+    QLabel* _view_rows = nullptr;
+    QLabel* _sort_time = nullptr;
+    QLabel* _decorations_pending = nullptr;
+    QLabel* _decorations_decoded = nullptr;
+    QLabel* _decoration_memory = nullptr;
+    QLabel* _cache_load_time = nullptr;
+    QLabel* _cache_save_time = nullptr;
+    QLabel* _library_memory = nullptr;
+    QLabel* _model_memory = nullptr;
+};
\ No newline at end of file
@@ -73,5 +73,6 @@ Settings::Settings()
     , main_window_icon_size(_settings, "main_window_icon_size", 0)
     , details_splitter_sizes(_settings, "details_splitter_sizes", QVariantList())
     , language(_settings, "language", "")
+    , fast_audio_properties(_settings, "fast_audio_properties", true)
 {
 }
\ No newline at end of file
@@ -104,4 +104,5 @@ public:
     SettingsItem<int> main_window_icon_size;
     SettingsItem<QVariantList> details_splitter_sizes;
     SettingsItem<QString> language;
+    SettingsItem<bool> fast_audio_properties;
 };
\ No newline at end of file
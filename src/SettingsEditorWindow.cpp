@@ -13,6 +13,7 @@
 #include <QtWidgets/qlistview.h>
 #include <QtWidgets/qpushbutton.h>
 #include <QtWidgets/qshortcut.h>
+#include <QtWidgets/qcheckbox.h>
 #include <QtWidgets/qcombobox.h>
 #include <QtWidgets/qgroupbox.h>
 
@@ -257,6 +258,44 @@ void LanguageSelect::applyChanges() const
 
 //=============================================================================
 
+class ScanModeSelect : public AbstractSettingsWidget
+{
+public:
+    ScanModeSelect(QWidget* parent, SettingsItem<bool>& item);
+
+    QWidget* getWidget() const override;
+    void applyChanges() const override;
+
+private:
+    SettingsItem<bool>& _item;
+    QCheckBox* _checkbox = nullptr;
+    QGroupBox* _container = nullptr;
+};
+
+ScanModeSelect::ScanModeSelect(QWidget* parent, SettingsItem<bool>& item)
+    : _item(item)
+{
+    _container = new QGroupBox(QObject::tr("Scanning"), parent);
+
+    _checkbox = new QCheckBox(QObject::tr("Fast scan (estimate length and bitrate first, read exact values in the background)"));
+    _checkbox->setChecked(item.getValue());
+
+    auto layout = new QVBoxLayout(_container);
+    layout->addWidget(_checkbox);
+}
+
+QWidget* ScanModeSelect::getWidget() const
+{
+    return _container;
+}
+
+void ScanModeSelect::applyChanges() const
+{
+    _item.setValue(_checkbox->isChecked());
+}
+
+//=============================================================================
+
 FirstStartDialog::FirstStartDialog(QWidget* parent, Settings& settings)
     : QDialog(parent)
 {
@@ -292,6 +331,7 @@ SettingsEditorDialog::SettingsEditorDialog(QWidget* parent, Settings& settings)
     setWindowTitle(tr("Preferences"));
 
     _widgets.push_back(std::make_unique<LanguageSelect>(this, settings.language));
+    _widgets.push_back(std::make_unique<ScanModeSelect>(this, settings.fast_audio_properties));
     _widgets.push_back(std::unique_ptr<AbstractSettingsWidget>(new SettingsWidgetDirPaths(this, settings.audio_dir_paths)));
 
     for(const auto& w : _widgets)
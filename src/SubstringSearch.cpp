@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "SubstringSearch.h"
+
+#include <bit>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define AUDIO_EXPLORER_X86_64
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define AUDIO_EXPLORER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define AUDIO_EXPLORER_TARGET_AVX2
+#endif
+
+namespace {
+
+    bool containsSubstringScalar(const char16_t* haystack, size_t haystack_size, const char16_t* needle, size_t needle_size)
+    {
+        return std::u16string_view(haystack, haystack_size).find(std::u16string_view(needle, needle_size)) != std::u16string_view::npos;
+    }
+
+    /**
+    * Compares the characters between the first and the last one, which were already checked by the block filter.
+    */
+    bool matchesInner(const char16_t* candidate, const char16_t* needle, size_t needle_size)
+    {
+        return needle_size <= 2 || std::memcmp(candidate + 1, needle + 1, (needle_size - 2) * sizeof(char16_t)) == 0;
+    }
+
+#ifdef AUDIO_EXPLORER_X86_64
+
+    bool containsSubstringSse2(const char16_t* haystack, size_t haystack_size, const char16_t* needle, size_t needle_size)
+    {
+        const __m128i first = _mm_set1_epi16(static_cast<short>(needle[0]));
+        const __m128i last = _mm_set1_epi16(static_cast<short>(needle[needle_size - 1]));
+
+        size_t i = 0;
+
+        for (; i + 8 + needle_size - 1 <= haystack_size; i += 8)
+        {
+            const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+            const __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + needle_size - 1));
+
+            // two mask bits per character
+
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(first, block_first), _mm_cmpeq_epi16(last, block_last))));
+
+            while (mask != 0)
+            {
+                const int bit = std::countr_zero(mask);
+
+                if (matchesInner(haystack + i + bit / 2, needle, needle_size))
+                    return true;
+
+                mask &= ~(3u << bit);
+            }
+        }
+
+        return containsSubstringScalar(haystack + i, haystack_size - i, needle, needle_size);
+    }
+
+    AUDIO_EXPLORER_TARGET_AVX2 bool containsSubstringAvx2(const char16_t* haystack, size_t haystack_size, const char16_t* needle, size_t needle_size)
+    {
+        const __m256i first = _mm256_set1_epi16(static_cast<short>(needle[0]));
+        const __m256i last = _mm256_set1_epi16(static_cast<short>(needle[needle_size - 1]));
+
+        size_t i = 0;
+
+        for (; i + 16 + needle_size - 1 <= haystack_size; i += 16)
+        {
+            const __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i));
+            const __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(haystack + i + needle_size - 1));
+
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(first, block_first), _mm256_cmpeq_epi16(last, block_last))));
+
+            while (mask != 0)
+            {
+                const int bit = std::countr_zero(mask);
+
+                if (matchesInner(haystack + i + bit / 2, needle, needle_size))
+                    return true;
+
+                mask &= ~(3u << bit);
+            }
+        }
+
+        // the remaining positions fit into a smaller block
+        return containsSubstringSse2(haystack + i, haystack_size - i, needle, needle_size);
+    }
+
+    bool isAvx2Supported()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+
+        // the OS has to save the AVX registers on context switches
+
+        __cpuid(info, 1);
+        const bool has_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        if (!has_avx)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+#endif
+
+    std::vector<SubstringSearchKernel> detectSupportedKernels()
+    {
+        std::vector<SubstringSearchKernel> kernels = { SubstringSearchKernel::SCALAR };
+
+#ifdef AUDIO_EXPLORER_X86_64
+        // SSE2 is part of x86-64
+        kernels.push_back(SubstringSearchKernel::SSE2);
+
+        if (isAvx2Supported())
+            kernels.push_back(SubstringSearchKernel::AVX2);
+#endif
+
+        return kernels;
+    }
+
+    bool containsSubstringWithKernel(const char16_t* haystack, size_t haystack_size, const char16_t* needle, size_t needle_size, SubstringSearchKernel kernel)
+    {
+        if (needle_size == 0)
+            return true;
+        if (needle_size > haystack_size)
+            return false;
+
+        switch (kernel)
+        {
+#ifdef AUDIO_EXPLORER_X86_64
+        case SubstringSearchKernel::SSE2:
+            return containsSubstringSse2(haystack, haystack_size, needle, needle_size);
+        case SubstringSearchKernel::AVX2:
+            return containsSubstringAvx2(haystack, haystack_size, needle, needle_size);
+#endif
+        default:
+            return containsSubstringScalar(haystack, haystack_size, needle, needle_size);
+        }
+    }
+}
+
+const std::vector<SubstringSearchKernel>& getSupportedSubstringSearchKernels()
+{
+    static const std::vector<SubstringSearchKernel> kernels = detectSupportedKernels();
+    return kernels;
+}
+
+bool containsSubstring(QStringView haystack, QStringView needle, SubstringSearchKernel kernel)
+{
+    return containsSubstringWithKernel(haystack.utf16(), size_t(haystack.size()), needle.utf16(), size_t(needle.size()), kernel);
+}
+
+bool containsSubstring(QStringView haystack, QStringView needle)
+{
+    static const SubstringSearchKernel best_kernel = getSupportedSubstringSearchKernels().back();
+    return containsSubstring(haystack, needle, best_kernel);
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <vector>
+#include <QtCore/qstringview.h>
+
+/**
+* Implementations of the exact UTF-16 substring search. The SIMD kernels compare the first and the last character
+* of the needle against a whole block of positions at once and only verify the positions where both match.
+*/
+enum class SubstringSearchKernel
+{
+    SCALAR,
+    SSE2,
+    AVX2,
+};
+
+/**
+* The kernels that can run on this CPU, the fastest one last.
+*/
+const std::vector<SubstringSearchKernel>& getSupportedSubstringSearchKernels();
+
+bool containsSubstring(QStringView haystack, QStringView needle, SubstringSearchKernel kernel);
+
+/**
+* Case-sensitive search with the fastest kernel. The filters search folded text, so case is handled before.
+*/
+bool containsSubstring(QStringView haystack, QStringView needle);
\ No newline at end of file
@@ -3,8 +3,12 @@
 #include "ThreadSafeAudioLibrary.h"
 
 #include <QtCore/qsavefile.h>
+#include "Tracing.h"
 
 namespace {
+    const std::chrono::milliseconds PROGRESS_INTERVAL(250);
+    const std::chrono::milliseconds SNAPSHOT_INTERVAL(1000);
+
     template<class T, class V>
     class SetValueOnDestroy
     {
@@ -29,8 +33,11 @@ namespace {
         V _value;
     };
 
+    /**
+    * Calls func with the files of each directory in the tree, until it returns false.
+    */
     template<class FUNC>
-    void forEachFileInDirectory(const QString& dirpath, FUNC func)
+    void forEachDirectory(const QString& dirpath, FUNC func)
     {
         std::vector<QString> queue;
         queue.push_back(dirpath);
@@ -46,13 +53,51 @@ namespace {
             for (const QString& subdir : subdirs)
                 queue.push_back(current_dir + "/" + subdir);
 
-            QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
-            for (const QFileInfo& file : files)
+            const QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+            if (!files.isEmpty() && !func(files))
+                return;
+        }
+    }
+
+    struct ParsedTrack
+    {
+        QString filepath;
+        QDateTime last_modified;
+        qint64 file_size = 0;
+        TrackInfo info;
+    };
+
+    /**
+    * Adds the parsed tracks to the library, releasing the lock in between after max_lock_hold_time.
+    * Returns the number of lock acquisitions.
+    */
+    int addParsedTracks(ThreadSafeAudioLibrary& library, std::vector<ParsedTrack>& batch, std::chrono::milliseconds max_lock_hold_time)
+    {
+        int lock_acquisitions = 0;
+
+        auto it = batch.begin();
+        while (it != batch.end())
+        {
+            // give the GUI a chance to take the lock in between
+            if (it != batch.begin())
+                std::this_thread::yield();
+
+            ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+            ++lock_acquisitions;
+
+            // don't block the GUI for too long with large batches
+            const auto lock_start_time = std::chrono::steady_clock::now();
+
+            do
             {
-                if (!func(file))
-                    return;
-            }
+                acc.getLibraryForUpdate().addTrack(it->filepath, it->last_modified, it->file_size, it->info);
+                ++it;
+            } while (it != batch.end() && std::chrono::steady_clock::now() - lock_start_time < max_lock_hold_time);
         }
+
+        batch.clear();
+
+        return lock_acquisitions;
     }
 } // namespace
 
@@ -76,6 +121,71 @@ AudioLibrary& ThreadSafeAudioLibrary::LibraryAccessor::getLibraryForUpdate() con
 
 //=============================================================================
 
+ThreadSafeAudioLibrary::ThreadSafeAudioLibrary()
+    : _snapshot(std::make_shared<AudioLibrary>())
+{
+    _library.enableChangeTracking();
+}
+
+quint64 ThreadSafeAudioLibrary::getGeneration() const
+{
+    return _library.getGeneration();
+}
+
+std::shared_ptr<const AudioLibrary> ThreadSafeAudioLibrary::getSnapshot() const
+{
+    std::lock_guard lock(_snapshot_spin_lock);
+    return _snapshot;
+}
+
+void ThreadSafeAudioLibrary::publishSnapshot()
+{
+    TraceSpan span("publishSnapshot");
+
+    // only one thread publishes at a time, so the last snapshot and the spare one can't change in between
+    std::lock_guard publish_lock(_publish_mutex);
+
+    AudioLibrary::Changes changes;
+
+    {
+        LibraryAccessor acc(*this);
+
+        if (acc.getLibrary().getGeneration() == _snapshot->getGeneration())
+            return;
+
+        changes = acc.getLibraryForUpdate().takeChanges();
+    }
+
+    ScopedDurationCounter duration_counter(getPerformanceCounters().last_snapshot_ns);
+
+    std::shared_ptr<AudioLibrary> snapshot;
+
+    if (_spare_snapshot && _spare_snapshot.use_count() == 1)
+    {
+        // the readers have released the spare snapshot, the acquire fence orders their last reads before the changes
+        std::atomic_thread_fence(std::memory_order_acquire);
+        snapshot = std::move(_spare_snapshot);
+        snapshot->applyChanges(_spare_snapshot_changes);
+    }
+    else
+    {
+        // the last snapshot doesn't change, so it can be copied without any lock
+        snapshot = std::make_shared<AudioLibrary>(*_snapshot);
+    }
+
+    snapshot->applyChanges(changes);
+
+    {
+        std::lock_guard lock(_snapshot_spin_lock);
+        std::swap(_snapshot, snapshot);
+    }
+
+    // readers may still hold the old snapshot, it's updated when it's reused
+
+    _spare_snapshot = std::move(snapshot);
+    _spare_snapshot_changes = std::move(changes);
+}
+
 bool ThreadSafeAudioLibrary::hasFinishedLoadingFromCache() const
 {
     return _has_finished_loading_from_cache;
@@ -96,29 +206,33 @@ QString ThreadSafeAudioLibrary::getCacheLocation() const
     return _cache_location;
 }
 
-void ThreadSafeAudioLibrary::saveToCache()
+bool ThreadSafeAudioLibrary::saveToCache()
 {
+    TraceSpan span("saveToCache");
+
     if (!_has_finished_loading_from_cache)
-        return; // don't save back a partially loaded library
+        return false; // don't save back a partially loaded library
 
     {
         ThreadSafeAudioLibrary::LibraryAccessor acc(*this);
 
         if (!acc.getLibrary().isModified())
-            return; // no need to save if the library has not changed
+            return true; // no need to save if the library has not changed
     }
 
+    ScopedDurationCounter duration_counter(getPerformanceCounters().cache_save_ns);
+
     {
         const QString cache_dir = QFileInfo(_cache_location).path();
 
         QDir dir(cache_dir);
         if (!dir.mkpath(cache_dir))
-            return;
+            return false;
     }
 
     QSaveFile file(_cache_location);
     if (!file.open(QIODevice::WriteOnly))
-        return;
+        return false;
 
     {
         QDataStream stream(&file);
@@ -126,9 +240,16 @@ void ThreadSafeAudioLibrary::saveToCache()
         ThreadSafeAudioLibrary::LibraryAccessor acc(*this);
 
         acc.getLibrary().save(stream);
+
+        // keep the previous cache if the disk is full
+        if (stream.status() != QDataStream::Ok)
+        {
+            file.cancelWriting();
+            return false;
+        }
     }
 
-    file.commit();
+    return file.commit();
 }
 
 //=============================================================================
@@ -156,11 +277,41 @@ void AudioFilesLoader::startLoading(const QStringList& audio_dir_paths)
     _thread_abort_flag = false;
     _is_loading = true;
 
-    _audio_file_loading_thread = std::thread([this, cache_location, audio_dir_paths](){
-        threadLoadAudioFiles(cache_location, audio_dir_paths);
+    _audio_file_loading_thread = std::thread([this, cache_location, audio_dir_paths, mode = _audio_properties_mode, tuning = _tuning](){
+        threadLoadAudioFiles(cache_location, audio_dir_paths, mode, tuning);
     });
 }
 
+void AudioFilesLoader::startPruning()
+{
+    const QString cache_location = _library.getCacheLocation();
+
+    stopLoading();
+
+    _thread_abort_flag = false;
+    _is_loading = true;
+
+    _audio_file_loading_thread = std::thread([this, cache_location, tuning = _tuning](){
+        threadPruneMissingFiles(cache_location, tuning);
+    });
+}
+
+void AudioFilesLoader::setAudioPropertiesMode(AudioPropertiesMode mode)
+{
+    _audio_properties_mode = mode;
+}
+
+void AudioFilesLoader::setTuning(const AudioFilesLoaderTuning& tuning)
+{
+    _tuning = tuning;
+}
+
+AudioFilesLoader::Statistics AudioFilesLoader::getStatistics() const
+{
+    std::lock_guard lock(_statistics_mutex);
+    return _statistics;
+}
+
 bool AudioFilesLoader::isLoading() const
 {
     return _is_loading;
@@ -176,10 +327,14 @@ void AudioFilesLoader::stopLoading()
 
 void AudioFilesLoader::loadFromCache(const QString& cache_location)
 {
+    TraceSpan span("loadFromCache");
+
     QFile file(cache_location);
     if (!file.open(QIODevice::ReadOnly))
         return;
 
+    ScopedDurationCounter duration_counter(getPerformanceCounters().cache_load_ns);
+
     QDataStream stream(&file);
 
     AudioLibrary::Loader loader;
@@ -187,13 +342,21 @@ void AudioFilesLoader::loadFromCache(const QString& cache_location)
     {
         ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
 
-        loader.init(acc.getLibraryForUpdate(), stream);
+        // the blocks are read and decoded without the lock, the loader thread only adds the decoded albums
+        loader.init(acc.getLibraryForUpdate(), stream, std::max(int(std::thread::hardware_concurrency()) - 1, 1));
     }
 
     int album_counter = 0;
+    auto last_snapshot_time = std::chrono::steady_clock::now();
 
     while (loader.hasNextAlbum())
     {
+        // the decoders may still be busy, the others would spin on the lock while the loader waits for them
+        loader.waitForNextAlbum();
+
+        if (!loader.hasNextAlbum())
+            break;
+
         {
             ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
 
@@ -203,69 +366,199 @@ void AudioFilesLoader::loadFromCache(const QString& cache_location)
         ++album_counter;
 
         if ((album_counter % 10) == 0)
+        {
+            // the views show the snapshot, so it has to follow the loading now and then
+            if (std::chrono::steady_clock::now() - last_snapshot_time >= SNAPSHOT_INTERVAL)
+            {
+                _library.publishSnapshot();
+                last_snapshot_time = std::chrono::steady_clock::now();
+            }
+
             libraryCacheLoading();
+        }
     }
 }
 
-void AudioFilesLoader::threadLoadAudioFiles(const QString& cache_location, const QStringList& audio_dir_paths)
+void AudioFilesLoader::loadFromCacheOnce(const QString& cache_location)
+{
+    if (_library.hasFinishedLoadingFromCache())
+        return;
+
+    loadFromCache(cache_location);
+    _library.setFinishedLoadingFromCache();
+    _library.publishSnapshot();
+    libraryCacheLoading();
+}
+
+void AudioFilesLoader::threadLoadAudioFiles(const QString& cache_location, const QStringList& audio_dir_paths, AudioPropertiesMode mode, const AudioFilesLoaderTuning& tuning)
 {
     SetValueOnDestroy<std::atomic_bool, bool> reset_loading_flag(_is_loading, false);
 
-    int files_loaded = 0;
+    setTraceThreadName("Loader");
+    TraceSpan span("threadLoadAudioFiles");
+
+    std::atomic_int files_loaded = 0;
     int files_in_cache = 0;
+    std::atomic<qint64> bytes_loaded = 0;
     auto start_time = std::chrono::system_clock::now();
 
-    if (!_library.hasFinishedLoadingFromCache())
-    {
-        loadFromCache(cache_location);
-        _library.setFinishedLoadingFromCache();
-        libraryCacheLoading();
-    }
+    loadFromCacheOnce(cache_location);
 
     std::unordered_set<QString> visited_audio_files;
 
+    std::atomic_int lock_acquisitions = 0;
+    std::atomic_int unbatched_lock_acquisitions = 0;
+
+    // progress is reported at a fixed rate, a queued signal per file would flood the GUI event loop
+
+    const auto scan_start_time = std::chrono::steady_clock::now();
+    auto last_progress_time = scan_start_time;
+    auto last_snapshot_time = scan_start_time;
+
+    auto reportProgress = [&]() {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - last_progress_time < PROGRESS_INTERVAL)
+            return;
+
+        last_progress_time = now;
+
+        if (now - last_snapshot_time >= SNAPSHOT_INTERVAL)
+        {
+            _library.publishSnapshot();
+            last_snapshot_time = std::chrono::steady_clock::now();
+        }
+
+        const float duration_sec = std::chrono::duration<float>(now - scan_start_time).count();
+        const float files_per_sec = (files_loaded + files_in_cache) / duration_sec;
+        const float megabytes_per_sec = bytes_loaded / (1024.0f * 1024.0f) / duration_sec;
+
+        getPerformanceCounters().scan_files_per_sec = files_per_sec;
+        getPerformanceCounters().scan_megabytes_per_sec = megabytes_per_sec;
+
+        libraryLoadProgressed(files_loaded, files_in_cache, files_per_sec, megabytes_per_sec);
+    };
+
+    // parsed tracks are collected and added in batches, to keep the number of lock acquisitions low
+
+    auto commitBatch = [this, &tuning, &lock_acquisitions](std::vector<ParsedTrack>& batch) {
+        lock_acquisitions += addParsedTracks(_library, batch, tuning.max_lock_hold_time);
+    };
+
+    // files which are not in the library yet are collected over several directories,
+    // so that all parser threads have enough work
+
+    const int thread_count = std::max(1, tuning.thread_count);
+    const size_t chunk_size = tuning.batch_size * thread_count;
+
+    std::vector<QFileInfo> files_to_read;
+
+    auto readFiles = [&]() {
+        std::atomic_size_t next_file_index = 0;
+        std::mutex visited_audio_files_mutex;
+
+        // the loader thread takes part in parsing, it's also the one that reports progress
+        auto parseFiles = [&](bool is_loader_thread) {
+            if (!is_loader_thread)
+                setTraceThreadName("Parser");
+
+            std::vector<ParsedTrack> batch;
+            auto batch_start_time = std::chrono::steady_clock::now();
+
+            for (size_t i = next_file_index++; i < files_to_read.size() && !_thread_abort_flag; i = next_file_index++)
+            {
+                const QFileInfo& file = files_to_read[i];
+                const QString filepath = file.filePath();
+
+                const auto parse_start_time = std::chrono::steady_clock::now();
+
+                TrackInfo track_info;
+                const bool parsed = readTrackInfo(filepath, track_info, mode);
+
+                getPerformanceCounters().addParseLatency(std::chrono::steady_clock::now() - parse_start_time);
+
+                if (parsed)
+                {
+                    if (batch.empty())
+                        batch_start_time = std::chrono::steady_clock::now();
+
+                    batch.push_back({ filepath, file.lastModified(), file.size(), track_info });
+
+                    ++unbatched_lock_acquisitions;
+                    ++files_loaded;
+                    bytes_loaded += file.size();
+
+                    std::lock_guard lock(visited_audio_files_mutex);
+                    visited_audio_files.insert(filepath);
+                }
+
+                if (is_loader_thread)
+                    reportProgress();
+
+                if (!batch.empty() && (batch.size() >= tuning.batch_size || std::chrono::steady_clock::now() - batch_start_time >= tuning.batch_interval))
+                    commitBatch(batch);
+            }
+
+            commitBatch(batch);
+        };
+
+        std::vector<std::thread> parser_threads;
+        for (int i = 1; i < thread_count; ++i)
+            parser_threads.emplace_back(parseFiles, false);
+
+        parseFiles(true);
+
+        for (std::thread& thread : parser_threads)
+            thread.join();
+
+        files_to_read.clear();
+    };
+
     for (const QString& dirpath : audio_dir_paths)
     {
-        forEachFileInDirectory(dirpath, [this, &files_loaded, &files_in_cache, &visited_audio_files](const QFileInfo& file) {
+        forEachDirectory(dirpath, [&](const QFileInfoList& files) {
             if (_thread_abort_flag)
                 return false; // stop iteration
 
-            const QString filepath = file.filePath();
-            const QDateTime last_modified = file.lastModified();
+            // look up all files of the directory at once
 
             {
                 ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+                ++lock_acquisitions;
+
+                for (const QFileInfo& file : files)
+                {
+                    const QString filepath = file.filePath();
 
-                if (const AudioLibraryTrack * track = acc.getLibrary().findTrack(filepath))
-                    if (track->getLastModified() == last_modified)
+                    const AudioLibraryTrack* track = acc.getLibrary().findTrack(filepath);
+                    if (track && track->getLastModified() == file.lastModified())
                     {
                         ++files_in_cache;
                         visited_audio_files.insert(filepath);
-                        libraryLoadProgressed(files_loaded, files_in_cache);
-                        return true; // nothing to do
                     }
+                    else
+                    {
+                        files_to_read.push_back(file);
+                    }
+                }
             }
 
-            TrackInfo track_info;
-            if (readTrackInfo(filepath, track_info))
-            {
-                {
-                    ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+            unbatched_lock_acquisitions += static_cast<int>(files.size());
+            reportProgress();
 
-                    acc.getLibraryForUpdate().addTrack(filepath, last_modified, file.size(), track_info);
-                }
+            if (files_to_read.size() >= chunk_size)
+                readFiles();
 
-                ++files_loaded;
-                visited_audio_files.insert(filepath);
-                libraryLoadProgressed(files_loaded, files_in_cache);
-            }
-            return true;
+            return !_thread_abort_flag;
             });
     }
 
+    readFiles();
+
     if (!_thread_abort_flag)
     {
         ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+        ++lock_acquisitions;
+        ++unbatched_lock_acquisitions;
 
         acc.getLibraryForUpdate().removeTracksExcept(visited_audio_files);
     }
@@ -273,5 +566,132 @@ void AudioFilesLoader::threadLoadAudioFiles(const QString& cache_location, const
     auto end_time = std::chrono::system_clock::now();
     auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
 
+    {
+        std::lock_guard lock(_statistics_mutex);
+
+        _statistics.files_loaded = files_loaded;
+        _statistics.files_in_cache = files_in_cache;
+        _statistics.bytes_loaded = bytes_loaded;
+        _statistics.duration_sec = float(millis.count()) / 1000.0f;
+        _statistics.lock_acquisitions = lock_acquisitions;
+        _statistics.unbatched_lock_acquisitions = unbatched_lock_acquisitions;
+        _statistics.completed = !_thread_abort_flag;
+    }
+
+    if (millis.count() > 0)
+    {
+        getPerformanceCounters().scan_files_per_sec = (files_loaded + files_in_cache) * 1000.0f / float(millis.count());
+        getPerformanceCounters().scan_megabytes_per_sec = bytes_loaded / (1024.0f * 1024.0f) * 1000.0f / float(millis.count());
+    }
+
+    _library.publishSnapshot();
+
     libraryLoadFinished(files_loaded, files_in_cache, float(millis.count()) / 1000.0);
+
+    // the library is complete, now take the time to read exact lengths and bitrates
+
+    if (mode == AudioPropertiesMode::FAST && !_thread_abort_flag)
+    {
+        const int tracks_refined = refineEstimatedAudioProperties(tuning);
+        if (tracks_refined > 0)
+        {
+            _library.publishSnapshot();
+            libraryAudioPropertiesRefined(tracks_refined);
+        }
+    }
+}
+
+void AudioFilesLoader::threadPruneMissingFiles(const QString& cache_location, const AudioFilesLoaderTuning& tuning)
+{
+    SetValueOnDestroy<std::atomic_bool, bool> reset_loading_flag(_is_loading, false);
+
+    setTraceThreadName("Loader");
+    TraceSpan span("threadPruneMissingFiles");
+
+    const auto start_time = std::chrono::steady_clock::now();
+
+    loadFromCacheOnce(cache_location);
+
+    // AudioFilesLoader runs one job at a time, and pruning doesn't start any parser threads, so only this thread
+    // changes the library until the missing files are removed. The snapshot stays up to date while it's checked
+    // without holding the lock.
+
+    _library.publishSnapshot();
+    const std::vector<QString> missing_files = _library.getSnapshot()->findMissingFiles(tuning.prune_thread_count, _thread_abort_flag);
+
+    // like parsed tracks, the missing files are removed in batches
+
+    int files_removed = 0;
+
+    auto it = missing_files.begin();
+    while (it != missing_files.end() && !_thread_abort_flag)
+    {
+        // give the GUI a chance to take the lock in between
+        if (it != missing_files.begin())
+            std::this_thread::yield();
+
+        ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+
+        const auto lock_start_time = std::chrono::steady_clock::now();
+
+        do
+        {
+            if (acc.getLibraryForUpdate().removeTrack(*it))
+                ++files_removed;
+            ++it;
+        } while (it != missing_files.end() && std::chrono::steady_clock::now() - lock_start_time < tuning.max_lock_hold_time);
+    }
+
+    _library.publishSnapshot();
+
+    libraryMissingFilesPruned(files_removed, std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count());
+}
+
+int AudioFilesLoader::refineEstimatedAudioProperties(const AudioFilesLoaderTuning& tuning)
+{
+    TraceSpan span("refineEstimatedAudioProperties");
+
+    std::vector<QString> filepaths;
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(_library);
+
+        for (const AudioLibraryAlbum* album : acc.getLibrary().getAlbums())
+            for (const AudioLibraryTrack* track : album->getTracks())
+                if (track->areAudioPropertiesEstimated())
+                    filepaths.push_back(track->getFilepath());
+    }
+
+    // like parsed tracks, the refined tracks are added in batches.
+    // The modification time is taken before reading, so the next scan reads a file again if it changes in the meantime.
+
+    int tracks_refined = 0;
+
+    std::vector<ParsedTrack> batch;
+    auto batch_start_time = std::chrono::steady_clock::now();
+
+    for (const QString& filepath : filepaths)
+    {
+        if (_thread_abort_flag)
+            break;
+
+        const QFileInfo file(filepath);
+
+        TrackInfo track_info;
+        if (readTrackInfo(filepath, track_info, AudioPropertiesMode::ACCURATE))
+        {
+            if (batch.empty())
+                batch_start_time = std::chrono::steady_clock::now();
+
+            batch.push_back({ filepath, file.lastModified(), file.size(), std::move(track_info) });
+            ++tracks_refined;
+        }
+
+        if (!batch.empty() && (batch.size() >= tuning.batch_size || std::chrono::steady_clock::now() - batch_start_time >= tuning.batch_interval))
+            addParsedTracks(_library, batch, tuning.max_lock_hold_time);
+    }
+
+    addParsedTracks(_library, batch, tuning.max_lock_hold_time);
+
+    return tracks_refined;
 }
\ No newline at end of file
@@ -2,18 +2,29 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <mutex>
 #include <thread>
 #include <QtCore/qobject.h>
 #include "AudioLibrary.h"
+#include "PerformanceCounters.h"
 
 class SpinLock
 {
 public:
     void lock()
     {
+        if (!locked.test_and_set(std::memory_order_acquire))
+            return;
+
+        // only a contended lock is timed, to keep the common case cheap
+
+        const auto wait_start_time = std::chrono::steady_clock::now();
+
         while (locked.test_and_set(std::memory_order_acquire))
             ;
+
+        getPerformanceCounters().addLockWait(std::chrono::steady_clock::now() - wait_start_time);
     }
 
     void unlock()
@@ -25,9 +36,16 @@ private:
     std::atomic_flag locked = ATOMIC_FLAG_INIT;
 };
 
+/**
+* Every change takes the lock, whether it comes from the loader thread, the parser threads committing their
+* batches or the refinement of estimated audio properties. Readers that don't need the latest state, like
+* building views, use a snapshot instead, which never blocks the writers.
+*/
 class ThreadSafeAudioLibrary
 {
 public:
+    ThreadSafeAudioLibrary();
+
     class LibraryAccessor
     {
     public:
@@ -41,45 +59,133 @@ public:
         AudioLibrary& _library;
     };
 
+    /**
+    * See AudioLibrary::getGeneration, doesn't take the lock.
+    */
+    quint64 getGeneration() const;
+
+    /**
+    * Returns the last published copy of the library. It doesn't change and stays valid as long as it's held.
+    */
+    std::shared_ptr<const AudioLibrary> getSnapshot() const;
+
+    /**
+    * Publishes a new snapshot if the library has changed since the last one. Only the changes are taken under
+    * the library lock, they are applied to the snapshot before the last one once no reader holds it anymore,
+    * otherwise to a copy of the last snapshot. Either way the library isn't copied under its lock.
+    */
+    void publishSnapshot();
+
     bool hasFinishedLoadingFromCache() const;
     void setFinishedLoadingFromCache();
 
     void setCacheLocation(const QString& cache_location);
     QString getCacheLocation() const;
-    void saveToCache();
+
+    /**
+    * Returns false if the cache could not be written, or if the library was only partially loaded from it.
+    * An unchanged library is not written again, which counts as success.
+    */
+    bool saveToCache();
 
 private:
     SpinLock _library_spin_lock;
     AudioLibrary _library;
+    mutable SpinLock _snapshot_spin_lock;       //!< only guards the pointer, not the snapshot
+    std::shared_ptr<AudioLibrary> _snapshot;    //!< not changed anymore once it's published
+
+    // the previous snapshot and the changes it lacks, it's reused when the readers have released it.
+    // Keeping it costs the memory of another copy of the library.
+    std::mutex _publish_mutex;
+    std::shared_ptr<AudioLibrary> _spare_snapshot;
+    AudioLibrary::Changes _spare_snapshot_changes;
     std::atomic_bool _has_finished_loading_from_cache = ATOMIC_VAR_INIT(false);
     QString _cache_location;
 };
 
+/**
+* Controls how the scanner shares the library lock with the GUI.
+*/
+struct AudioFilesLoaderTuning
+{
+    size_t batch_size = 256;                              //!< parsed tracks are added to the library in batches of this size
+    std::chrono::milliseconds batch_interval{ 50 };       //!< an incomplete batch is added after this time
+    std::chrono::milliseconds max_lock_hold_time{ 10 };   //!< adding a batch releases the lock in between after this time
+    int thread_count = 1;                                 //!< number of threads parsing files, including the loader thread
+    int prune_thread_count = 8;                           //!< number of threads checking whether files still exist, they mostly wait for the file system
+};
+
 class AudioFilesLoader : public QObject
 {
     Q_OBJECT
 
 public:
+    /**
+    * Describes the last completed scan.
+    */
+    struct Statistics
+    {
+        int files_loaded = 0;
+        int files_in_cache = 0;
+        qint64 bytes_loaded = 0;     //!< size of the files that have been parsed
+        float duration_sec = 0;
+
+        int lock_acquisitions = 0;
+        int unbatched_lock_acquisitions = 0; //!< what one acquisition per lookup and per insertion would need
+
+        bool completed = false;      //!< false if the scan was stopped before all files were read
+    };
+
     AudioFilesLoader(ThreadSafeAudioLibrary& library);
     ~AudioFilesLoader();
 
     void startLoading(const QStringList& audio_dir_paths);
+
+    /**
+    * Removes the tracks whose files don't exist anymore, without reading the tags of the other files.
+    */
+    void startPruning();
+
     bool isLoading() const;
 
+    /**
+    * In fast mode, estimated audio properties are refined in the background after the scan.
+    * Takes effect on the next call of startLoading.
+    */
+    void setAudioPropertiesMode(AudioPropertiesMode mode);
+
+    /**
+    * Takes effect on the next call of startLoading.
+    */
+    void setTuning(const AudioFilesLoaderTuning& tuning);
+
+    Statistics getStatistics() const;
+
 signals:
     void libraryCacheLoading();
-    void libraryLoadProgressed(int files_loaded, int files_in_cache);
+    void libraryLoadProgressed(int files_loaded, int files_in_cache, float files_per_sec, float megabytes_per_sec);
     void libraryLoadFinished(int files_loaded, int files_in_cache, float duration_sec);
+    void libraryAudioPropertiesRefined(int tracks_refined);
+    void libraryMissingFilesPruned(int files_removed, float duration_sec);
 
 private:
     void stopLoading();
     void loadFromCache(const QString& cache_location);
-    void threadLoadAudioFiles(const QString& cache_location, const QStringList& audio_dir_paths);
+    void loadFromCacheOnce(const QString& cache_location);
+    void threadLoadAudioFiles(const QString& cache_location, const QStringList& audio_dir_paths, AudioPropertiesMode mode, const AudioFilesLoaderTuning& tuning);
+    void threadPruneMissingFiles(const QString& cache_location, const AudioFilesLoaderTuning& tuning);
+    int refineEstimatedAudioProperties(const AudioFilesLoaderTuning& tuning);
 
     ThreadSafeAudioLibrary& _library;
 
     std::thread _audio_file_loading_thread;
 
+    AudioPropertiesMode _audio_properties_mode = AudioPropertiesMode::ACCURATE;
+    AudioFilesLoaderTuning _tuning;
+
+    mutable std::mutex _statistics_mutex;
+    Statistics _statistics;
+
     std::atomic_bool _thread_abort_flag = ATOMIC_VAR_INIT(false);
 
     std::atomic_bool _is_loading = ATOMIC_VAR_INIT(false);
@@ -0,0 +1,225 @@
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "Tracing.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qsavefile.h>
+
+namespace {
+    const quint64 EVENTS_PER_THREAD = 16384;
+
+    const std::chrono::steady_clock::time_point TRACE_START_TIME = std::chrono::steady_clock::now();
+
+    /**
+    * The fields are atomic, because a trace can be saved while the owning thread overwrites old events.
+    */
+    struct TraceEvent
+    {
+        std::atomic<const char*> name = nullptr;
+        std::atomic<qint64> start_ns = 0;
+        std::atomic<qint64> duration_ns = 0;
+    };
+
+    /**
+    * Ring buffer with a single writer, the owning thread.
+    * The writer publishes each event by incrementing event_count, readers never block it.
+    */
+    struct ThreadTrace
+    {
+        int id = 0;
+        std::atomic<const char*> thread_name = nullptr;
+        std::atomic<quint64> event_count = 0;
+        std::array<TraceEvent, EVENTS_PER_THREAD> events;
+    };
+
+    /**
+    * Owns the traces of all threads. The traces of finished threads are reused by new threads,
+    * so that threads started per task don't add a ring buffer each.
+    */
+    class TraceRegistry
+    {
+    public:
+        static TraceRegistry& instance()
+        {
+            static TraceRegistry registry;
+            return registry;
+        }
+
+        ThreadTrace* acquire()
+        {
+            std::lock_guard lock(_mutex);
+
+            if (!_unused_traces.empty())
+            {
+                ThreadTrace* trace = _unused_traces.back();
+                _unused_traces.pop_back();
+                return trace;
+            }
+
+            auto trace = std::make_unique<ThreadTrace>();
+            trace->id = static_cast<int>(_traces.size()) + 1;
+            _traces.push_back(std::move(trace));
+            return _traces.back().get();
+        }
+
+        void release(ThreadTrace* trace)
+        {
+            std::lock_guard lock(_mutex);
+
+            // the name is kept for the recorded events, until another thread takes over the trace
+            _unused_traces.push_back(trace);
+        }
+
+        template<class FUNC>
+        void forEachTrace(FUNC func)
+        {
+            std::lock_guard lock(_mutex);
+
+            for (const auto& trace : _traces)
+                func(*trace);
+        }
+
+    private:
+        std::mutex _mutex;
+        std::vector<std::unique_ptr<ThreadTrace>> _traces;
+        std::vector<ThreadTrace*> _unused_traces;
+    };
+
+    class ThreadTraceHolder
+    {
+    public:
+        ThreadTraceHolder()
+            : _trace(TraceRegistry::instance().acquire())
+        {}
+
+        ~ThreadTraceHolder()
+        {
+            TraceRegistry::instance().release(_trace);
+        }
+
+        ThreadTraceHolder(const ThreadTraceHolder&) = delete;
+        ThreadTraceHolder& operator=(const ThreadTraceHolder&) = delete;
+
+        ThreadTrace& get() const
+        {
+            return *_trace;
+        }
+
+    private:
+        ThreadTrace* _trace;
+    };
+
+    ThreadTrace& getThreadTrace()
+    {
+        thread_local ThreadTraceHolder holder;
+        return holder.get();
+    }
+
+    qint64 toNanoseconds(std::chrono::steady_clock::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    }
+}
+
+TraceSpan::TraceSpan(const char* name)
+    : _name(name)
+    , _start_time(std::chrono::steady_clock::now())
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+    const auto end_time = std::chrono::steady_clock::now();
+
+    ThreadTrace& trace = getThreadTrace();
+
+    const quint64 index = trace.event_count.load(std::memory_order_relaxed);
+    TraceEvent& event = trace.events[index % EVENTS_PER_THREAD];
+
+    event.name.store(_name, std::memory_order_relaxed);
+    event.start_ns.store(toNanoseconds(_start_time - TRACE_START_TIME), std::memory_order_relaxed);
+    event.duration_ns.store(toNanoseconds(end_time - _start_time), std::memory_order_relaxed);
+
+    trace.event_count.store(index + 1, std::memory_order_release);
+}
+
+void setTraceThreadName(const char* name)
+{
+    getThreadTrace().thread_name = name;
+}
+
+bool saveChromeTrace(const QString& filepath)
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray trace_events;
+
+    TraceRegistry::instance().forEachTrace([&](const ThreadTrace& trace) {
+        const char* thread_name = trace.thread_name;
+
+        QJsonObject metadata;
+        metadata["name"] = "thread_name";
+        metadata["ph"] = "M";
+        metadata["pid"] = pid;
+        metadata["tid"] = trace.id;
+        metadata["args"] = QJsonObject{ { "name", thread_name ? QString::fromUtf8(thread_name) : QString("Thread %1").arg(trace.id) } };
+        trace_events.append(metadata);
+
+        const quint64 event_count = trace.event_count.load(std::memory_order_acquire);
+        const quint64 first_event = event_count > EVENTS_PER_THREAD ? event_count - EVENTS_PER_THREAD : 0;
+
+        std::vector<std::tuple<quint64, const char*, qint64, qint64>> events;
+        for (quint64 i = first_event; i < event_count; ++i)
+        {
+            const TraceEvent& event = trace.events[i % EVENTS_PER_THREAD];
+            events.emplace_back(i, event.name.load(std::memory_order_relaxed), event.start_ns.load(std::memory_order_relaxed), event.duration_ns.load(std::memory_order_relaxed));
+        }
+
+        // the writer may have overwritten the oldest events while they were copied, skip those
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const quint64 event_count_after_copy = trace.event_count.load(std::memory_order_relaxed);
+
+        for (const auto& [i, name, start_ns, duration_ns] : events)
+        {
+            if (i + EVENTS_PER_THREAD <= event_count_after_copy)
+                continue;
+
+            QJsonObject event;
+            event["name"] = QString::fromUtf8(name);
+            event["ph"] = "X";
+            event["pid"] = pid;
+            event["tid"] = trace.id;
+            event["ts"] = double(start_ns) / 1000.0;
+            event["dur"] = double(duration_ns) / 1000.0;
+            trace_events.append(event);
+        }
+        });
+
+    QJsonObject root;
+    root["traceEvents"] = trace_events;
+    root["displayTimeUnit"] = "ms";
+
+    QSaveFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+void saveChromeTraceFromEnvironment()
+{
+    const QString filepath = qEnvironmentVariable("AUDIO_EXPLORER_TRACE");
+    if (!filepath.isEmpty())
+        saveChromeTrace(filepath);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#pragma once
+
+#include <chrono>
+#include <QtCore/qstring.h>
+
+/**
+* Measures the time from construction to destruction and records it in the trace of the current thread.
+*
+* Each thread writes into its own ring buffer without locking, so spans are cheap enough to stay enabled all the time.
+* Only the most recent events of each thread are kept.
+*
+* The name must be a string literal, or at least outlive the trace.
+*/
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* _name;
+    std::chrono::steady_clock::time_point _start_time;
+};
+
+/**
+* Names the current thread in the trace. The name must outlive the trace.
+*/
+void setTraceThreadName(const char* name);
+
+/**
+* Writes the recorded spans of all threads as Chrome trace event JSON,
+* which can be opened in chrome://tracing or https://ui.perfetto.dev.
+*/
+bool saveChromeTrace(const QString& filepath);
+
+/**
+* Writes the trace to the file given in the environment variable AUDIO_EXPLORER_TRACE, if it is set.
+*/
+void saveChromeTraceFromEnvironment();
\ No newline at end of file
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "TrackInfoReader.h"
+#include "NativeTrackInfoReader.h"
 
 #include <taglib/tstring.h>
 #include <taglib/fileref.h>
@@ -27,6 +28,11 @@
 #include <taglib/apetag.h>
 #include <taglib/attachedpictureframe.h>
 
+#include <QtCore/qbuffer.h>
+#include <QtCore/qfile.h>
+#include <QtGui/qimagereader.h>
+#include "Tracing.h"
+
 namespace{
     QString toQString(const TagLib::String& s)
     {
@@ -44,6 +50,15 @@ namespace{
         info.comment = toQString(tag->comment());
     }
 
+    void setCover(const TagLib::ByteVector& bytes, TrackInfo& info, QByteArray* cover_data)
+    {
+        // TagLib doesn't tell where the picture is located, so it needs to be extracted again later
+        info.cover = createCoverLocation(QString(), QByteArrayView(bytes.data(), bytes.size()), -1);
+
+        if (cover_data)
+            *cover_data = QByteArray(bytes.data(), bytes.size());
+    }
+
     void appendTagType(const QString& type, TrackInfo& info)
     {
         if (!info.tag_types.isEmpty())
@@ -56,7 +71,7 @@ namespace{
         appendTagType("ID3v1", info);
     }
 
-    void readID3v2Info(TagLib::ID3v2::Tag* tag, TrackInfo& info)
+    void readID3v2Info(TagLib::ID3v2::Tag* tag, TrackInfo& info, QByteArray* cover_data)
     {
         appendTagType("ID3v2", info);
 
@@ -83,7 +98,7 @@ namespace{
                 if (picture_frame)
                 {
                     const TagLib::ByteVector bytes = picture_frame->picture();
-                    info.cover = QByteArray(bytes.data(), bytes.size());
+                    setCover(bytes, info, cover_data);
                 }
             }
         }
@@ -111,7 +126,7 @@ namespace{
         }
     }
 
-    void readXiphCommentInfo(TagLib::Ogg::XiphComment* tag, TrackInfo& info)
+    void readXiphCommentInfo(TagLib::Ogg::XiphComment* tag, TrackInfo& info, QByteArray* cover_data)
     {
         appendTagType("Vorbis comment", info);
 
@@ -138,7 +153,7 @@ namespace{
             if (picture)
             {
                 TagLib::ByteVector bytes = picture->data();
-                info.cover = QByteArray(bytes.data(), bytes.size());
+                setCover(bytes, info, cover_data);
             }
         }
 
@@ -168,7 +183,7 @@ namespace{
         }
     }
 
-    void readMP4Info(TagLib::MP4::Tag* tag, TrackInfo& info)
+    void readMP4Info(TagLib::MP4::Tag* tag, TrackInfo& info, QByteArray* cover_data)
     {
         appendTagType("MP4", info);
 
@@ -182,7 +197,7 @@ namespace{
                 if (!cover_art_list.isEmpty())
                 {
                     const TagLib::ByteVector bytes = cover_art_list.front().data();
-                    info.cover = QByteArray(bytes.data(), bytes.size());
+                    setCover(bytes, info, cover_data);
                 }
             }
         }
@@ -214,7 +229,7 @@ namespace{
         }
     }
 
-    void readAPEInfo(TagLib::APE::Tag* tag, TrackInfo& info)
+    void readAPEInfo(TagLib::APE::Tag* tag, TrackInfo& info, QByteArray* cover_data)
     {
         appendTagType("APE", info);
 
@@ -230,7 +245,7 @@ namespace{
                 if (pos != -1)
                 {
                     const TagLib::ByteVector bytes = item.mid(pos + 1);
-                    info.cover = QByteArray(bytes.data(), bytes.size());
+                    setCover(bytes, info, cover_data);
                 }
             }
         }
@@ -258,7 +273,7 @@ namespace{
         }
     }
 
-    void readASFInfo(TagLib::ASF::Tag* tag, TrackInfo& info)
+    void readASFInfo(TagLib::ASF::Tag* tag, TrackInfo& info, QByteArray* cover_data)
     {
         appendTagType("ASF", info);
 
@@ -279,7 +294,7 @@ namespace{
                         found = attr_list.begin();
 
                     const TagLib::ByteVector bytes = found->toPicture().picture();
-                    info.cover = QByteArray(bytes.data(), bytes.size());
+                    setCover(bytes, info, cover_data);
                 }
             }
         }
@@ -319,16 +334,50 @@ namespace{
     {
         appendTagType("Info", info);
     }
+
+    template<class ARRAY>
+    bool compareSignature(const ARRAY& signature, QByteArrayView bytes)
+    {
+        const size_t signature_size = std::distance(std::begin(signature), std::end(signature));
+
+        return bytes.size() >= static_cast<qsizetype>(signature_size) &&
+            memcmp(bytes.data(), signature, signature_size) == 0;
+    }
+
+    QString getCoverFormat(QByteArrayView bytes)
+    {
+        const uint8_t JPG_SIGNATURE[] = { 0xff, 0xd8 };
+        const uint8_t PNG_SIGNATURE[] = { 0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A };
+        const uint8_t BMP_SIGNATURE[] = { 0x42, 0x4d };
+
+        if (compareSignature(JPG_SIGNATURE, bytes))
+            return "jpg";
+
+        if (compareSignature(PNG_SIGNATURE, bytes))
+            return "png";
+
+        if (compareSignature(BMP_SIGNATURE, bytes))
+            return "bmp";
+
+        if (!bytes.isEmpty())
+        {
+            return "unknown signature: " + QString::fromLatin1(bytes.first(std::min<qsizetype>(bytes.size(), 32)).toByteArray().toHex());
+        }
+
+        return QString();
+    }
 }
 
-bool readTrackInfo(const QString& filepath, TrackInfo& info)
+bool readTrackInfoTagLib(const QString& filepath, TrackInfo& info, AudioPropertiesMode mode, QByteArray* cover_data)
 {
     {
+        const TagLib::AudioProperties::ReadStyle read_style = mode == AudioPropertiesMode::FAST ? TagLib::AudioProperties::Fast : TagLib::AudioProperties::Average;
+
         // TagLib::FileName is a different type on Windows
 #if _WIN32
-        TagLib::FileRef file_ref(TagLib::FileName(filepath.toStdWString().data()));
+        TagLib::FileRef file_ref(TagLib::FileName(filepath.toStdWString().data()), true, read_style);
 #else
-        TagLib::FileRef file_ref(TagLib::FileName(filepath.toStdString().data()));
+        TagLib::FileRef file_ref(TagLib::FileName(filepath.toStdString().data()), true, read_style);
 #endif
 
         if (file_ref.tag())
@@ -340,74 +389,78 @@ bool readTrackInfo(const QString& filepath, TrackInfo& info)
             info.bitrate_kbs         = file_ref.audioProperties()->bitrate();
             info.samplerate_hz       = file_ref.audioProperties()->sampleRate();
 
+            // TagLib doesn't tell if the fast read style had to estimate anything, and most formats
+            // ignore it. Reading the file again would mostly give the same values, so nothing is flagged.
+            info.audio_properties_estimated = false;
+
             if (TagLib::MPEG::File* file = dynamic_cast<TagLib::MPEG::File*>(file_ref.file()))
             {
                 if (file->hasID3v1Tag())
                     readID3v1Info(info);
                 if (file->hasID3v2Tag())
-                    readID3v2Info(file->ID3v2Tag(), info);
+                    readID3v2Info(file->ID3v2Tag(), info, cover_data);
                 if (file->hasAPETag())
-                    readAPEInfo(file->APETag(), info);
+                    readAPEInfo(file->APETag(), info, cover_data);
             }
             if (TagLib::Ogg::Vorbis::File* file = dynamic_cast<TagLib::Ogg::Vorbis::File*>(file_ref.file()))
             {
-                readXiphCommentInfo(file->tag(), info);
+                readXiphCommentInfo(file->tag(), info, cover_data);
             }
             if (TagLib::Ogg::Opus::File* file = dynamic_cast<TagLib::Ogg::Opus::File*>(file_ref.file()))
             {
-                readXiphCommentInfo(file->tag(), info);
+                readXiphCommentInfo(file->tag(), info, cover_data);
             }
             if (TagLib::Ogg::FLAC::File* file = dynamic_cast<TagLib::Ogg::FLAC::File*>(file_ref.file()))
             {
-                readXiphCommentInfo(file->tag(), info);
+                readXiphCommentInfo(file->tag(), info, cover_data);
             }
             if (TagLib::Ogg::Speex::File* file = dynamic_cast<TagLib::Ogg::Speex::File*>(file_ref.file()))
             {
-                readXiphCommentInfo(file->tag(), info);
+                readXiphCommentInfo(file->tag(), info, cover_data);
             }
             if (TagLib::RIFF::WAV::File* file = dynamic_cast<TagLib::RIFF::WAV::File*>(file_ref.file()))
             {
                 if (file->hasID3v2Tag())
-                    readID3v2Info(file->ID3v2Tag(), info);
+                    readID3v2Info(file->ID3v2Tag(), info, cover_data);
                 if (file->hasInfoTag())
                     readInfoInfo(info);
             }
             if (TagLib::RIFF::AIFF::File* file = dynamic_cast<TagLib::RIFF::AIFF::File*>(file_ref.file()))
             {
                 if (file->hasID3v2Tag())
-                    readID3v2Info(file->tag(), info);
+                    readID3v2Info(file->tag(), info, cover_data);
             }
             if (TagLib::MPC::File* file = dynamic_cast<TagLib::MPC::File*>(file_ref.file()))
             {
                 if (file->hasID3v1Tag())
                     readID3v1Info(info);
                 if (file->hasAPETag())
-                    readAPEInfo(file->APETag(), info);
+                    readAPEInfo(file->APETag(), info, cover_data);
             }
             if (TagLib::MP4::File* file = dynamic_cast<TagLib::MP4::File*>(file_ref.file()))
             {
                 if (file->hasMP4Tag())
-                    readMP4Info(file->tag(), info);
+                    readMP4Info(file->tag(), info, cover_data);
             }
             if (TagLib::FLAC::File* file = dynamic_cast<TagLib::FLAC::File*>(file_ref.file()))
             {
                 if (file->hasID3v1Tag())
                     readID3v1Info(info);
                 if (file->hasID3v2Tag())
-                    readID3v2Info(file->ID3v2Tag(), info);
+                    readID3v2Info(file->ID3v2Tag(), info, cover_data);
                 if (file->hasXiphComment())
-                    readXiphCommentInfo(file->xiphComment(), info);
+                    readXiphCommentInfo(file->xiphComment(), info, cover_data);
             }
             if (TagLib::ASF::File* file = dynamic_cast<TagLib::ASF::File*>(file_ref.file()))
             {
-                readASFInfo(file->tag(), info);
+                readASFInfo(file->tag(), info, cover_data);
             }
             if (TagLib::APE::File* file = dynamic_cast<TagLib::APE::File*>(file_ref.file()))
             {
                 if (file->hasID3v1Tag())
                     readID3v1Info(info);
                 if (file->hasAPETag())
-                    readAPEInfo(file->APETag(), info);
+                    readAPEInfo(file->APETag(), info, cover_data);
             }
             if (dynamic_cast<TagLib::IT::File*>(file_ref.file()))
             {
@@ -430,19 +483,82 @@ bool readTrackInfo(const QString& filepath, TrackInfo& info)
                 if (file->hasID3v1Tag())
                     readID3v1Info(info);
                 if (file->hasID3v2Tag())
-                    readID3v2Info(file->ID3v2Tag(), info);
+                    readID3v2Info(file->ID3v2Tag(), info, cover_data);
             }
             if (TagLib::WavPack::File* file = dynamic_cast<TagLib::WavPack::File*>(file_ref.file()))
             {
                 if (file->hasID3v1Tag())
                     readID3v1Info(info);
                 if (file->hasAPETag())
-                    readAPEInfo(file->APETag(), info);
+                    readAPEInfo(file->APETag(), info, cover_data);
             }
 
+            if (!info.cover.isEmpty())
+                info.cover.filepath = filepath;
+
             return true;
         }
     }
 
     return false;
+}
+
+bool readTrackInfo(const QString& filepath, TrackInfo& info, AudioPropertiesMode mode)
+{
+    TraceSpan span("readTrackInfo");
+
+    if (readTrackInfoNative(filepath, info, mode))
+        return true;
+
+    return readTrackInfoTagLib(filepath, info, mode);
+}
+
+CoverLocation createCoverLocation(const QString& filepath, QByteArrayView data, qint64 offset)
+{
+    CoverLocation cover;
+    if (data.isEmpty())
+        return cover;
+
+    cover.filepath = filepath;
+    cover.offset = offset;
+    cover.data_size = data.size();
+    cover.checksum = qChecksum(data);
+    cover.format = getCoverFormat(data);
+
+    // only the image header is parsed, fromRawData doesn't copy
+    QByteArray raw_data = QByteArray::fromRawData(data.data(), data.size());
+    QBuffer buffer(&raw_data);
+    buffer.open(QIODevice::ReadOnly);
+    const QSize image_size = QImageReader(&buffer).size();
+    if (image_size.isValid())
+        cover.image_size = image_size;
+
+    return cover;
+}
+
+QByteArray readCover(const CoverLocation& cover)
+{
+    if (cover.isEmpty())
+        return QByteArray();
+
+    QByteArray data;
+
+    if (cover.offset >= 0)
+    {
+        QFile file(cover.filepath);
+        if (file.open(QIODevice::ReadOnly) && file.seek(cover.offset))
+            data = file.read(cover.data_size);
+    }
+    else
+    {
+        // the picture is encoded in the tags, extract it again
+        TrackInfo info;
+        if (!readTrackInfoNative(cover.filepath, info, AudioPropertiesMode::FAST, &data))
+            readTrackInfoTagLib(cover.filepath, info, AudioPropertiesMode::FAST, &data);
+    }
+
+    if (data.size() != cover.data_size || qChecksum(data) != cover.checksum)
+        return QByteArray();
+
+    return data;
 }
\ No newline at end of file
@@ -3,6 +3,31 @@
 
 #include <QtCore/qstring.h>
 #include <QtCore/qdatetime.h>
+#include <QtCore/qsize.h>
+
+enum class AudioPropertiesMode
+{
+    ACCURATE, //!< reads as much as TagLib's average read style, may seek to the end of the file
+    FAST,     //!< only reads headers, length and bitrate may be estimated
+};
+
+/**
+* Describes a cover picture embedded in an audio file, without holding the picture data.
+* The data is read on demand with readCover.
+*/
+struct CoverLocation
+{
+    QString filepath;
+    qint64 offset = -1;     //!< position of the raw picture data in the file, -1 if the tags need to be read again to extract it
+    qint64 data_size = 0;
+    quint16 checksum = 0;   //!< qChecksum of the picture data
+    QString format;         //!< "jpg", "png", "bmp" or a description of the unknown signature
+    QSize image_size{0, 0}; //!< from the image header, the picture is not decoded
+
+    bool isEmpty() const { return data_size == 0; }
+
+    bool operator==(const CoverLocation&) const = default;
+};
 
 struct TrackInfo
 {
@@ -11,7 +36,7 @@ struct TrackInfo
     QString album;
     int year = 0;
     QString genre;
-    QByteArray cover;
+    CoverLocation cover;
     int disc_number = 0;
 
     QString title;
@@ -24,6 +49,28 @@ struct TrackInfo
     int channels = 0;
     int bitrate_kbs = 0;
     int samplerate_hz = 0;
+
+    bool audio_properties_estimated = false; //!< length and bitrate are not exact, see AudioPropertiesMode
 };
 
-bool readTrackInfo(const QString& filepath, TrackInfo& info);
\ No newline at end of file
+/**
+* Reads tags and audio properties. Common formats are parsed natively, everything else is read with TagLib.
+*/
+bool readTrackInfo(const QString& filepath, TrackInfo& info, AudioPropertiesMode mode = AudioPropertiesMode::ACCURATE);
+
+/**
+* Reads the track info with TagLib only.
+* If cover_data is given, the picture data of the cover is copied there.
+*/
+bool readTrackInfoTagLib(const QString& filepath, TrackInfo& info, AudioPropertiesMode mode = AudioPropertiesMode::ACCURATE, QByteArray* cover_data = nullptr);
+
+/**
+* Describes the picture data found at the given position.
+* The checksum is computed in place and the image size comes from the header only, the data is not copied.
+*/
+CoverLocation createCoverLocation(const QString& filepath, QByteArrayView data, qint64 offset);
+
+/**
+* Reads the picture data of a cover. Returns an empty array if the file has changed since the location was recorded.
+*/
+QByteArray readCover(const CoverLocation& cover);
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <QtWidgets/QStyleFactory>
 #include <QtGui/QStyleHints>
 #include "project_version.h"
+#include "Tracing.h"
 
 class TranslationManager
 {
@@ -190,6 +191,8 @@ int main(int argc, char** argv)
     QApplication app(argc, argv);
     app.setApplicationName(APPLICATION_NAME);
 
+    setTraceThreadName("Main");
+
     enableDarkModeSupport();
 
     Settings settings;
@@ -200,6 +203,7 @@ int main(int argc, char** argv)
     library.setCacheLocation(filepath);
 
     AudioFilesLoader audio_files_loader(library);
+    audio_files_loader.setAudioPropertiesMode(settings.fast_audio_properties.getValue() ? AudioPropertiesMode::FAST : AudioPropertiesMode::ACCURATE);
     audio_files_loader.startLoading(settings.audio_dir_paths.getValue());
 
     TranslationManager translation_manager(&app);
@@ -208,5 +212,9 @@ int main(int argc, char** argv)
     MainWindowCreator main_creator(settings, library, audio_files_loader, translation_manager);
     main_creator.create();
 
-    return app.exec();
+    const int result = app.exec();
+
+    saveChromeTraceFromEnvironment();
+
+    return result;
 }
\ No newline at end of file
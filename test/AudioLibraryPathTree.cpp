@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <QtCore/qbuffer.h>
+
+#include <AudioLibrary.h>
+#include "tools.h"
+
+namespace {
+
+    QStringList getDirectoryPaths(const AudioLibrary& library)
+    {
+        QStringList paths;
+
+        for (const AudioLibraryDirectory* directory : library.getPathTree().getDirectories())
+            paths.push_back(directory->getPath());
+
+        paths.sort();
+        return paths;
+    }
+
+    QStringList getFilepaths(const std::vector<const AudioLibraryTrack*>& tracks)
+    {
+        QStringList filepaths;
+
+        for (const AudioLibraryTrack* track : tracks)
+            filepaths.push_back(track->getFilepath());
+
+        filepaths.sort();
+        return filepaths;
+    }
+}
+
+TEST(AudioExplorer, AudioLibraryPathTree)
+{
+    const QStringList filepaths = {
+        "/music/Blind Guardian/Somewhere Far Beyond/01.mp3",
+        "/music/Blind Guardian/Somewhere Far Beyond/02.mp3",
+        "/music/Blind Guardian/Live/CD1/01.mp3",
+        "/music/Blind Guardian/Live/CD2/01.mp3",
+        "/music/Kreator/Pleasure to Kill/01.mp3",
+        "C:/music/various.mp3",
+        "relative.mp3",
+    };
+
+    AudioLibrary library;
+    for (const QString& filepath : filepaths)
+        library.addTrack(filepath, QDateTime(), 0, createTrackInfo("artist", QString(), "album", 2000, "genre", CoverLocation(), filepath, 1));
+
+    for (const QString& filepath : filepaths)
+    {
+        const AudioLibraryTrack* track = library.findTrack(filepath);
+        ASSERT_NE(track, nullptr);
+        EXPECT_EQ(track->getFilepath(), filepath);
+    }
+
+    EXPECT_EQ(library.findTrack("/music/Blind Guardian/Live/01.mp3"), nullptr);
+    EXPECT_EQ(library.findTrack("/music/Blind Guardian/Somewhere Far Beyond/03.mp3"), nullptr);
+
+    // every directory path is stored once, the root has the relative file
+
+    EXPECT_EQ(getDirectoryPaths(library), QStringList({
+        "/",
+        "/music/",
+        "/music/Blind Guardian/",
+        "/music/Blind Guardian/Live/",
+        "/music/Blind Guardian/Live/CD1/",
+        "/music/Blind Guardian/Live/CD2/",
+        "/music/Blind Guardian/Somewhere Far Beyond/",
+        "/music/Kreator/",
+        "/music/Kreator/Pleasure to Kill/",
+        "C:/",
+        "C:/music/",
+    }));
+
+    EXPECT_EQ(library.getPathTree().getRoot()->getTracks().size(), 1);
+
+    EXPECT_EQ(getFilepaths(library.findTracksInDirectory("/music/Blind Guardian")), QStringList({
+        "/music/Blind Guardian/Live/CD1/01.mp3",
+        "/music/Blind Guardian/Live/CD2/01.mp3",
+        "/music/Blind Guardian/Somewhere Far Beyond/01.mp3",
+        "/music/Blind Guardian/Somewhere Far Beyond/02.mp3",
+    }));
+    EXPECT_TRUE(library.findTracksInDirectory("/music/Blind").empty());
+
+    // the copy and the loaded library have the same directories
+
+    EXPECT_EQ(getDirectoryPaths(AudioLibrary(library)), getDirectoryPaths(library));
+
+    {
+        QByteArray bytes;
+        QBuffer buffer(&bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::WriteOnly));
+        QDataStream out(&buffer);
+        library.save(out);
+
+        QDataStream in(bytes);
+        AudioLibrary loaded_library;
+        loaded_library.load(in);
+
+        EXPECT_TRUE(compareLibraries(library, loaded_library));
+        EXPECT_EQ(getDirectoryPaths(loaded_library), getDirectoryPaths(library));
+    }
+
+    // removing a subtree removes its directories, and the parents which became empty
+
+    library.removeTracksInDirectory("/music/Blind Guardian/Live/");
+
+    EXPECT_EQ(library.getNumberOfTracks(), 5);
+    EXPECT_EQ(library.findTrack("/music/Blind Guardian/Live/CD1/01.mp3"), nullptr);
+    EXPECT_FALSE(getDirectoryPaths(library).contains("/music/Blind Guardian/Live/"));
+
+    library.removeTracksInDirectory("/music/Blind Guardian");
+    library.removeTracksInDirectory("/music/Kreator");
+
+    EXPECT_EQ(getDirectoryPaths(library), QStringList({ "C:/", "C:/music/" }));
+
+    library.removeTracksInDirectory(QString());
+
+    EXPECT_EQ(library.getNumberOfTracks(), 0);
+    EXPECT_TRUE(library.getPathTree().getDirectories().empty());
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+#include <AudioLibrary.h>
+#include <AudioLibraryQuery.h>
+#include "tools.h"
+
+namespace {
+
+    void addTrack(AudioLibrary& library, const QString& filepath, TrackInfo info, int bitrate_kbs)
+    {
+        info.bitrate_kbs = bitrate_kbs;
+        library.addTrack(filepath, QDateTime(), 0, info);
+    }
+
+    AudioLibrary createLibrary()
+    {
+        AudioLibrary library;
+
+        addTrack(library, "/music/Blind Guardian/01.mp3", createTrackInfo("Blind Guardian", QString(), "Somewhere Far Beyond", 1992, "Power Metal", CoverLocation(), "Time What Is Time", 1, 346000), 320);
+        addTrack(library, "/music/Blind Guardian/02.mp3", createTrackInfo("Blind Guardian", QString(), "Somewhere Far Beyond", 1992, "Power Metal", CoverLocation(), "The Bard's Song - In the Forest", 7, 190000), 192);
+        addTrack(library, "/music/Kreator/01.mp3", createTrackInfo("Kreator", QString(), "Pleasure to Kill", 1986, "Thrash Metal", CoverLocation(), "Choir of the Damned", 1, 97000), 128);
+        addTrack(library, "/music/Various/01.flac", createTrackInfo("Kreator", "Various Artists", "Thrash Classics", 2001, "Thrash Metal", CoverLocation(), "Re:Flagellation", 3, 250000), 900);
+
+        return library;
+    }
+
+    /**
+    * Sorted titles of the matching tracks, words without a field are searched in the title.
+    */
+    QStringList findTitles(const AudioLibrary& library, const QString& text)
+    {
+        const AudioLibraryQuery query(text, AudioLibraryQuery::Field::TITLE);
+
+        QStringList result;
+
+        for (const AudioLibraryTrack* track : query.findCandidates(library))
+            if (query.matches(track, track->getFoldedText(AudioLibrarySearchIndex::TrackField::TITLE)))
+                result.push_back(track->getTitle());
+
+        result.sort();
+        return result;
+    }
+}
+
+TEST(AudioExplorer, AudioLibraryQueryWords)
+{
+    const AudioLibrary library = createLibrary();
+
+    ASSERT_EQ(findTitles(library, QString()).size(), 4);
+    ASSERT_EQ(findTitles(library, "the"), QStringList({ "Choir of the Damned", "The Bard's Song - In the Forest" }));
+    ASSERT_EQ(findTitles(library, "the !bard"), QStringList({ "Choir of the Damned" }));
+    ASSERT_EQ(findTitles(library, "\"time what\""), QStringList({ "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "time what"), QStringList({ "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "Re:Flag"), QStringList({ "Re:Flagellation" }));
+    ASSERT_EQ(findTitles(library, "\"OR\""), QStringList({ "The Bard's Song - In the Forest" }));
+}
+
+TEST(AudioExplorer, AudioLibraryQueryFields)
+{
+    const AudioLibrary library = createLibrary();
+
+    ASSERT_EQ(findTitles(library, "artist:kreator"), QStringList({ "Choir of the Damned", "Re:Flagellation" }));
+    ASSERT_EQ(findTitles(library, "artist:various"), QStringList({ "Re:Flagellation" }));
+    ASSERT_EQ(findTitles(library, "album:\"far beyond\""), QStringList({ "The Bard's Song - In the Forest", "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "genre:thrash path:.flac"), QStringList({ "Re:Flagellation" }));
+    ASSERT_EQ(findTitles(library, "year:1990..1999"), QStringList({ "The Bard's Song - In the Forest", "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "year:..1992"), QStringList({ "Choir of the Damned", "The Bard's Song - In the Forest", "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "bitrate:>320"), QStringList({ "Re:Flagellation" }));
+    ASSERT_EQ(findTitles(library, "bitrate:>=320"), QStringList({ "Re:Flagellation", "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "length:<3m"), QStringList({ "Choir of the Damned" }));
+    ASSERT_EQ(findTitles(library, "length:3:10"), QStringList({ "The Bard's Song - In the Forest" }));
+    ASSERT_EQ(findTitles(library, "length:>5m30s"), QStringList({ "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "track:7"), QStringList({ "The Bard's Song - In the Forest" }));
+
+    // invalid values match nothing, missing ones are ignored
+
+    ASSERT_TRUE(findTitles(library, "year:abc").isEmpty());
+    ASSERT_EQ(findTitles(library, "year:").size(), 4);
+}
+
+TEST(AudioExplorer, AudioLibraryQueryOperators)
+{
+    const AudioLibrary library = createLibrary();
+
+    ASSERT_EQ(findTitles(library, "choir OR artist:blind track:7"), QStringList({ "Choir of the Damned", "The Bard's Song - In the Forest" }));
+    ASSERT_EQ(findTitles(library, "(choir | forest) year:<1990"), QStringList({ "Choir of the Damned" }));
+    ASSERT_EQ(findTitles(library, "NOT (artist:kreator OR bitrate:<200)"), QStringList({ "Time What Is Time" }));
+    ASSERT_EQ(findTitles(library, "!(genre:power) AND !flag"), QStringList({ "Choir of the Damned" }));
+
+    // incomplete input while typing
+
+    ASSERT_EQ(findTitles(library, "(choir | forest"), QStringList({ "Choir of the Damned", "The Bard's Song - In the Forest" }));
+    ASSERT_EQ(findTitles(library, "choir)"), QStringList({ "Choir of the Damned" }));
+    ASSERT_EQ(findTitles(library, "choir OR").size(), 1);
+    ASSERT_EQ(findTitles(library, "choir !").size(), 1);
+}
+
+TEST(AudioExplorer, AudioLibraryQueryFormat)
+{
+    ASSERT_TRUE(AudioLibraryQuery("  ", AudioLibraryQuery::Field::TITLE).isEmpty());
+    ASSERT_EQ(AudioLibraryQuery("the !bard", AudioLibraryQuery::Field::TITLE).format(), QString("\"the\", not \"bard\""));
+    ASSERT_EQ(AudioLibraryQuery("Artist:\"blind guardian\" year:1990..1999", AudioLibraryQuery::Field::TITLE).format(), QString("artist:\"blind guardian\", year:1990..1999"));
+    ASSERT_EQ(AudioLibraryQuery("a OR b c", AudioLibraryQuery::Field::TITLE).format(), QString("\"a\" or (\"b\", \"c\")"));
+}
+
+TEST(AudioExplorer, AudioLibraryQueryCandidateOrder)
+{
+    const AudioLibrary library = createLibrary();
+
+    // the candidates from the search index are in the same order as the tracks of the library
+
+    const std::vector<const AudioLibraryTrack*> candidates = AudioLibraryQuery("the", AudioLibraryQuery::Field::TITLE).findCandidates(library);
+    ASSERT_GE(candidates.size(), 2u);
+
+    std::vector<const AudioLibraryTrack*> all_tracks = AudioLibraryQuery(QString(), AudioLibraryQuery::Field::TITLE).findCandidates(library);
+    ASSERT_EQ(all_tracks.size(), 4u);
+
+    std::erase_if(all_tracks, [&candidates](const AudioLibraryTrack* track) { return std::ranges::find(candidates, track) == candidates.end(); });
+    ASSERT_EQ(candidates, all_tracks);
+}
\ No newline at end of file
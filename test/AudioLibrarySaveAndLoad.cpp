@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "gtest/gtest.h"
 
+#include <map>
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qbuffer.h>
 
@@ -15,11 +16,13 @@ TEST(AudioExplorer, AudioLibrarySaveAndLoad)
 
     AudioLibrary lib;
 
-    lib.addTrack("a", QDateTime(), 0, createTrackInfo("artist 1", QString(), "album 1", 2000, "genre 1", QByteArray(), "title 1", 1));
-    lib.addTrack("b", QDateTime(), 0, createTrackInfo("artist 1", QString(), "album 1", 2000, "genre 1", QByteArray(), "title 2", 2));
-    lib.addTrack("c", QDateTime(), 0, createTrackInfo("artist 1", QString(), "album 1", 2000, "genre 1", QByteArray(), "title 3", 3));
+    lib.addTrack("a", QDateTime(), 0, createTrackInfo("artist 1", QString(), "album 1", 2000, "genre 1", CoverLocation(), "title 1", 1));
+    lib.addTrack("b", QDateTime(), 0, createTrackInfo("artist 1", QString(), "album 1", 2000, "genre 1", CoverLocation(), "title 2", 2));
+    lib.addTrack("c", QDateTime(), 0, createTrackInfo("artist 1", QString(), "album 1", 2000, "genre 1", CoverLocation(), "title 3", 3));
 
-    lib.addTrack("d", QDateTime(), 0, createTrackInfo("artist 2", QString(), "album 2", 2000, "genre 1", QByteArray(), "title 1", 1));
+    TrackInfo estimated_track = createTrackInfo("artist 2", QString(), "album 2", 2000, "genre 1", CoverLocation(), "title 1", 1);
+    estimated_track.audio_properties_estimated = true;
+    lib.addTrack("d", QDateTime(), 0, estimated_track);
 
     QByteArray bytes;
 
@@ -47,4 +50,162 @@ TEST(AudioExplorer, AudioLibrarySaveAndLoad)
             ASSERT_TRUE(compareLibraries(lib, lib2));
         }
     }
+}
+
+TEST(AudioExplorer, AudioLibrarySaveAndLoadBlocks)
+{
+    int argc = 1;
+    char* argv = const_cast<char*>("");
+    QCoreApplication app(argc, &argv);
+
+    // enough albums for several blocks, the last one not full
+
+    AudioLibrary lib;
+
+    for (int a = 0; a < 300; ++a)
+        for (int t = 0; t < 3; ++t)
+            lib.addTrack(QString("/music/%1/%2.mp3").arg(a).arg(t), QDateTime(), 0, createTrackInfo(QString("artist %1").arg(a % 7), QString(), QString("album %1").arg(a), 2000, "genre 1", CoverLocation(), QString("title %1").arg(t), t + 1));
+
+    QByteArray bytes;
+
+    {
+        QBuffer buffer(&bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::WriteOnly));
+        QDataStream s(&buffer);
+
+        lib.save(s);
+    }
+
+    {
+        AudioLibrary lib2;
+
+        QBuffer buffer(&bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::ReadOnly));
+        QDataStream s(&buffer);
+        lib2.load(s);
+
+        ASSERT_TRUE(compareLibraries(lib, lib2));
+        ASSERT_EQ(lib2.findTracksInDirectory("/music/42").size(), 3u);
+    }
+
+    {
+        // a truncated cache loads the albums of its complete blocks
+
+        QByteArray truncated_bytes = bytes.left(bytes.size() / 2);
+
+        AudioLibrary lib2;
+
+        QBuffer buffer(&truncated_bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::ReadOnly));
+        QDataStream s(&buffer);
+        lib2.load(s);
+
+        ASSERT_GT(lib2.getAlbums().size(), 0u);
+        ASSERT_LT(lib2.getAlbums().size(), lib.getAlbums().size());
+    }
+
+    {
+        // with one thread, fewer blocks are read ahead than the cache has
+
+        AudioLibrary lib2;
+
+        QBuffer buffer(&bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::ReadOnly));
+        QDataStream s(&buffer);
+
+        AudioLibrary::Loader loader;
+        loader.init(lib2, s, 1);
+        while (loader.hasNextAlbum())
+            loader.loadNextAlbum(lib2);
+
+        ASSERT_TRUE(compareLibraries(lib, lib2));
+    }
+
+    {
+        // a loader that is destroyed early stops reading
+
+        AudioLibrary lib2;
+
+        QBuffer buffer(&bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::ReadOnly));
+        QDataStream s(&buffer);
+
+        {
+            AudioLibrary::Loader loader;
+            loader.init(lib2, s, 1);
+            loader.loadNextAlbum(lib2);
+        }
+
+        ASSERT_EQ(lib2.getAlbums().size(), 1u);
+    }
+}
+
+TEST(AudioExplorer, AudioLibraryLoadDuplicatePaths)
+{
+    // a damaged cache where a path belongs to two albums, once in the same block and once in another block
+
+    AudioLibrary lib;
+
+    for (int a = 0; a < 70; ++a)
+    {
+        static const std::map<int, QString> SPECIAL_FILENAMES = { { 0, "aaaa" }, { 1, "cccc" }, { 2, "dddd" }, { 69, "bbbb" } };
+
+        const auto special = SPECIAL_FILENAMES.find(a);
+        const QString filename = special != SPECIAL_FILENAMES.end() ? special->second : QString("file %1").arg(a);
+
+        lib.addTrack(QString("/music/%1.mp3").arg(filename), QDateTime(), 0, createTrackInfo("artist", QString(), QString("album %1").arg(a, 3, 10, QChar('0')), 2000, "genre", CoverLocation(), "title", 1));
+    }
+
+    QByteArray bytes;
+
+    {
+        QBuffer buffer(&bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::WriteOnly));
+        QDataStream s(&buffer);
+
+        lib.save(s);
+    }
+
+    // the strings are stored as UTF-16, a file name of the same length keeps the sizes of the blocks
+
+    auto utf16 = [](const QString& text) {
+        QByteArray bytes;
+        QDataStream s(&bytes, QIODevice::WriteOnly);
+        s << text;
+        return bytes.mid(sizeof(quint32));
+    };
+
+    ASSERT_EQ(bytes.count(utf16("bbbb")), 1);
+    ASSERT_EQ(bytes.count(utf16("dddd")), 1);
+    bytes.replace(utf16("bbbb"), utf16("aaaa"));
+    bytes.replace(utf16("dddd"), utf16("cccc"));
+
+    AudioLibrary lib2;
+
+    {
+        QBuffer buffer(&bytes);
+        ASSERT_TRUE(buffer.open(QBuffer::ReadOnly));
+        QDataStream s(&buffer);
+        lib2.load(s);
+    }
+
+    // the first track of each path is kept, the albums of the rejected tracks aren't kept empty
+
+    ASSERT_EQ(lib2.getNumberOfTracks(), 68u);
+    ASSERT_EQ(lib2.getAlbums().size(), 68u);
+    ASSERT_EQ(lib2.findTrack("/music/aaaa.mp3")->getAlbum()->getKey().getAlbum(), QString("album 000"));
+    ASSERT_EQ(lib2.findTrack("/music/cccc.mp3")->getAlbum()->getKey().getAlbum(), QString("album 001"));
+
+    for (const AudioLibraryAlbum* album : lib2.getAlbums())
+        ASSERT_FALSE(album->getTracks().empty());
+
+    // removing the tracks must not leave anything behind
+
+    ASSERT_TRUE(lib2.removeTrack("/music/aaaa.mp3"));
+    ASSERT_TRUE(lib2.removeTrack("/music/cccc.mp3"));
+    ASSERT_EQ(lib2.getSearchIndex().findTracks(AudioLibrarySearchIndex::TrackField::TITLE, { "title" }, {}).size(), 66u);
+
+    lib2.removeTracksExcept({});
+    ASSERT_TRUE(lib2.getAlbums().empty());
+    ASSERT_TRUE(lib2.getSearchIndex().findTracks(AudioLibrarySearchIndex::TrackField::TITLE, { "title" }, {}).empty());
 }
\ No newline at end of file
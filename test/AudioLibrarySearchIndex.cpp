@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <set>
+
+#include <AudioLibrary.h>
+#include "../benchmark/SyntheticLibrary.h"
+#include "tools.h"
+
+namespace {
+
+    const std::vector<std::vector<QString>> QUERIES = {
+        {},
+        { "" },
+        { "Th" },
+        { "the" },
+        { "NIGHT" },
+        { "fire", "the" },
+        { "über" },
+        { "ÅNGSTRÖM" },
+        { "angstrom" },
+        { "cafe" },
+        { "Beatles" },
+        { "xyz" },
+    };
+
+    bool containsAllWords(const QString& text, const std::vector<QString>& words, const std::vector<QString>& forbidden_words)
+    {
+        const QString folded_text = AudioLibrarySearchIndex::foldText(text);
+
+        for (const QString& word : forbidden_words)
+            if (folded_text.contains(AudioLibrarySearchIndex::foldText(word)))
+                return false;
+
+        for (const QString& word : words)
+            if (!folded_text.contains(AudioLibrarySearchIndex::foldText(word)))
+                return false;
+
+        return true;
+    }
+
+    template<class ITEM>
+    std::set<ITEM> toSet(const std::vector<ITEM>& items)
+    {
+        return std::set<ITEM>(items.begin(), items.end());
+    }
+
+    void checkSearchIndex(const AudioLibrary& library)
+    {
+        const AudioLibrarySearchIndex& search_index = library.getSearchIndex();
+
+        for (const std::vector<QString>& words : QUERIES)
+        {
+            for (const std::vector<QString>& forbidden_words : std::vector<std::vector<QString>>{ {}, { "dark" } })
+            {
+                std::set<const AudioLibraryTrack*> expected_titles;
+                std::set<const AudioLibraryTrack*> expected_artists;
+                std::set<const AudioLibraryAlbum*> expected_albums;
+                std::set<const AudioLibraryAlbum*> expected_genres;
+
+                for (const AudioLibraryAlbum* album : library.getAlbums())
+                {
+                    if (containsAllWords(album->getKey().getAlbum(), words, forbidden_words))
+                        expected_albums.insert(album);
+
+                    if (containsAllWords(album->getKey().getGenre(), words, forbidden_words))
+                        expected_genres.insert(album);
+
+                    for (const AudioLibraryTrack* track : album->getTracks())
+                    {
+                        if (containsAllWords(track->getTitle(), words, forbidden_words))
+                            expected_titles.insert(track);
+
+                        if (containsAllWords(track->getArtist(), words, forbidden_words))
+                            expected_artists.insert(track);
+                    }
+                }
+
+                const auto titles = search_index.findTracks(AudioLibrarySearchIndex::TrackField::TITLE, words, forbidden_words);
+                const auto artists = search_index.findTracks(AudioLibrarySearchIndex::TrackField::ARTIST, words, forbidden_words);
+                const auto albums = search_index.findAlbums(AudioLibrarySearchIndex::AlbumField::ALBUM, words, forbidden_words);
+                const auto genres = search_index.findAlbums(AudioLibrarySearchIndex::AlbumField::GENRE, words, forbidden_words);
+
+                // every item is only returned once
+
+                ASSERT_EQ(titles.size(), expected_titles.size());
+                ASSERT_EQ(artists.size(), expected_artists.size());
+                ASSERT_EQ(albums.size(), expected_albums.size());
+                ASSERT_EQ(genres.size(), expected_genres.size());
+
+                ASSERT_EQ(toSet(titles), expected_titles);
+                ASSERT_EQ(toSet(artists), expected_artists);
+                ASSERT_EQ(toSet(albums), expected_albums);
+                ASSERT_EQ(toSet(genres), expected_genres);
+            }
+        }
+    }
+}
+
+TEST(AudioExplorer, AudioLibrarySearchIndex)
+{
+    const std::vector<SyntheticTrack> tracks = SyntheticLibraryGenerator().createTracks(200, 10);
+
+    AudioLibrary library;
+    addSyntheticTracks(library, tracks);
+    checkSearchIndex(library);
+
+    // removing tracks frees entries, which are reused by the tracks added afterwards
+
+    std::vector<AudioLibraryTrack*> tracks_to_remove;
+    for (size_t i = 0; i < tracks.size(); i += 3)
+        tracks_to_remove.push_back(const_cast<AudioLibraryTrack*>(library.findTrack(tracks[i].filepath)));
+
+    for (AudioLibraryTrack* track : tracks_to_remove)
+        library.removeTrack(track);
+
+    checkSearchIndex(library);
+
+    addSyntheticTracks(library, SyntheticLibraryGenerator(2).createTracks(50, 10));
+    checkSearchIndex(library);
+
+    // replacing a track updates its fields
+
+    library.addTrack(tracks[1].filepath, QDateTime(), 0, createTrackInfo("Beatles", QString(), "Help", 1965, "Rock", CoverLocation(), "Yesterday", 1));
+    checkSearchIndex(library);
+
+    ASSERT_EQ(library.getSearchIndex().findTracks(AudioLibrarySearchIndex::TrackField::ARTIST, { "beatles" }, {}).size(), 1u);
+}
+
+TEST(AudioExplorer, AudioLibrarySearchIndexSharedValue)
+{
+    // all tracks have the same artist and an empty album artist, so removing one moves another into its place
+
+    AudioLibrary library;
+
+    for (int i = 0; i < 5; ++i)
+        library.addTrack(QString("/music/%1.mp3").arg(i), QDateTime(), 0, createTrackInfo("Blind Guardian", QString(), "Nightfall", 1998, "Metal", CoverLocation(), QString("Title %1").arg(i), i + 1));
+
+    auto find_artist_tracks = [](const AudioLibrary& library) {
+        std::vector<const AudioLibraryTrack*> found = library.getSearchIndex().findTracks(AudioLibrarySearchIndex::TrackField::ARTIST, { "guardian" }, {});
+        return std::set<const AudioLibraryTrack*>(found.begin(), found.end());
+    };
+
+    ASSERT_TRUE(library.removeTrack("/music/0.mp3"));
+
+    // the track that was moved is removed next, which only works if its position was updated
+
+    const AudioLibraryTrack* moved_track = library.findTrack("/music/4.mp3");
+    ASSERT_EQ(find_artist_tracks(library).size(), 4u);
+    ASSERT_TRUE(find_artist_tracks(library).contains(moved_track));
+
+    ASSERT_TRUE(library.removeTrack("/music/4.mp3"));
+    ASSERT_EQ(find_artist_tracks(library), std::set<const AudioLibraryTrack*>({ library.findTrack("/music/1.mp3"), library.findTrack("/music/2.mp3"), library.findTrack("/music/3.mp3") }));
+    checkSearchIndex(library);
+
+    // a copy keeps the order of the items, so the positions stay valid in it
+
+    AudioLibrary copy(library);
+    ASSERT_TRUE(copy.removeTrack("/music/1.mp3"));
+    ASSERT_EQ(find_artist_tracks(copy), std::set<const AudioLibraryTrack*>({ copy.findTrack("/music/2.mp3"), copy.findTrack("/music/3.mp3") }));
+    checkSearchIndex(copy);
+
+    ASSERT_EQ(find_artist_tracks(library).size(), 3u);
+}
+
+TEST(AudioExplorer, AudioLibrarySearchIndexSaveAndLoad)
+{
+    AudioLibrary library;
+    addSyntheticTracks(library, SyntheticLibraryGenerator().createTracks(100, 10));
+
+    QByteArray data;
+
+    {
+        QDataStream s(&data, QIODevice::WriteOnly);
+        library.save(s);
+    }
+
+    AudioLibrary loaded_library;
+    addSyntheticTracks(loaded_library, SyntheticLibraryGenerator(2).createTracks(10, 10));
+
+    {
+        QDataStream s(data);
+        loaded_library.load(s);
+    }
+
+    checkSearchIndex(loaded_library);
+}
+
+TEST(AudioExplorer, AudioLibrarySearchIndexFolding)
+{
+    ASSERT_EQ(AudioLibrarySearchIndex::foldText("Blind Guardian"), QString("blind guardian"));
+    ASSERT_EQ(AudioLibrarySearchIndex::foldText(QString::fromUtf8("Ångström Café")), QString("angstrom cafe"));
+    ASSERT_EQ(AudioLibrarySearchIndex::foldText(QString::fromUtf8("ÜBER")), QString("uber"));
+
+    AudioLibrary library;
+    library.addTrack("/music/01.mp3", QDateTime(), 0, createTrackInfo(QString::fromUtf8("Mötley Crüe"), QString(), "Dr. Feelgood", 1989, "Hard Rock", CoverLocation(), "Kickstart My Heart", 1));
+
+    const AudioLibraryTrack* track = library.findTrack("/music/01.mp3");
+    ASSERT_EQ(track->getFoldedText(AudioLibrarySearchIndex::TrackField::ARTIST).toString(), QString("motley crue"));
+    ASSERT_EQ(track->getFoldedText(AudioLibrarySearchIndex::TrackField::ALBUM_ARTIST).toString(), QString());
+    ASSERT_EQ(track->getFoldedText(AudioLibrarySearchIndex::TrackField::TITLE).toString(), QString("kickstart my heart"));
+    ASSERT_EQ(track->getAlbum()->getFoldedText(AudioLibrarySearchIndex::AlbumField::GENRE).toString(), QString("hard rock"));
+
+    ASSERT_EQ(library.getSearchIndex().findTracks(AudioLibrarySearchIndex::TrackField::ARTIST, { "motley" }, {}).size(), 1u);
+    ASSERT_EQ(library.getSearchIndex().findTracks(AudioLibrarySearchIndex::TrackField::ARTIST, { QString::fromUtf8("CRÜE") }, {}).size(), 1u);
+}
\ No newline at end of file
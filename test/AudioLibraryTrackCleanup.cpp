@@ -62,4 +62,106 @@ TEST(AudioExplorer, AudioLibraryTrackCleanup)
     library2.addTrack(new_filepath3, QDateTime(), 0, TrackInfo());
 
     ASSERT_TRUE(compareLibraries(library, library2));
+}
+
+TEST(AudioExplorer, AudioLibraryRemoveTracksFromAlbum)
+{
+    AudioLibrary library;
+    std::unordered_set<QString> remaining_files;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        const QString filepath = QString("/music/%1.mp3").arg(i);
+        library.addTrack(filepath, QDateTime(), 0, createTrackInfo("artist", QString(), "album", 2000, "genre", CoverLocation(), QString::number(i), i + 1));
+
+        if (i % 3 == 1)
+            remaining_files.insert(filepath);
+    }
+
+    // removing tracks moves others into their place, the positions must stay consistent
+
+    library.removeTracksExcept(remaining_files);
+
+    ASSERT_EQ(library.getAlbums().size(), 1);
+
+    const auto tracks = library.getAlbums().front()->getTracks();
+    ASSERT_EQ(tracks.size(), remaining_files.size());
+
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        EXPECT_EQ(tracks[i]->getAlbumIndex(), i);
+        EXPECT_TRUE(remaining_files.contains(tracks[i]->getFilepath()));
+    }
+
+    library.removeTracksExcept({});
+    EXPECT_TRUE(library.getAlbums().empty());
+}
+
+TEST(AudioExplorer, AudioLibraryFindMissingFiles)
+{
+    // one directory with enough tracks to be listed, one where the files are looked up
+
+    QString dirpath1 = "test_AudioLibraryFindMissingFiles1";
+    QString dirpath2 = "test_AudioLibraryFindMissingFiles2";
+
+    for (const QString& dirpath : { dirpath1, dirpath2 })
+    {
+        ASSERT_TRUE(QDir(dirpath).removeRecursively());
+        ASSERT_TRUE(QDir().mkpath(dirpath));
+    }
+
+    AudioLibrary library;
+    std::vector<QString> expected_missing_files;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        const QString filepath = dirpath1 + QString("/file%1.txt").arg(i);
+        ASSERT_TRUE(createEmptyFile(filepath));
+        library.addTrack(filepath, QDateTime(), 0, TrackInfo());
+
+        if (i % 3 == 0)
+        {
+            ASSERT_TRUE(QFile::remove(filepath));
+            expected_missing_files.push_back(filepath);
+        }
+    }
+
+    const QString filepath2 = dirpath2 + "/file.txt";
+    const QString filepath3 = dirpath2 + "/missing.txt";
+    ASSERT_TRUE(createEmptyFile(filepath2));
+    library.addTrack(filepath2, QDateTime(), 0, TrackInfo());
+    library.addTrack(filepath3, QDateTime(), 0, TrackInfo());
+    expected_missing_files.push_back(filepath3);
+
+    const std::atomic_bool abort_flag = false;
+    std::vector<QString> missing_files = library.findMissingFiles(4, abort_flag);
+
+    std::ranges::sort(missing_files);
+    std::ranges::sort(expected_missing_files);
+    EXPECT_EQ(missing_files, expected_missing_files);
+
+    library.removeTracksWithInvalidPaths();
+
+    EXPECT_EQ(library.getNumberOfTracks(), 7);
+    EXPECT_NE(library.findTrack(filepath2), nullptr);
+    EXPECT_EQ(library.findTrack(filepath3), nullptr);
+
+    // a removed directory has no files left
+
+    ASSERT_TRUE(QDir(dirpath1).removeRecursively());
+
+    EXPECT_EQ(library.findMissingFiles(4, abort_flag).size(), 6);
+
+    // the files below an empty mount point are on a drive that isn't mounted, they aren't missing
+
+    const QString mount_point = "test_AudioLibraryFindMissingFiles3";
+    ASSERT_TRUE(QDir(mount_point).removeRecursively());
+    ASSERT_TRUE(QDir().mkpath(mount_point));
+
+    AudioLibrary unmounted_library;
+    for (int i = 0; i < 10; ++i)
+        unmounted_library.addTrack(mount_point + QString("/Artist/Album/file%1.txt").arg(i), QDateTime(), 0, TrackInfo());
+    unmounted_library.addTrack(mount_point + "/Artist/Single/file.txt", QDateTime(), 0, TrackInfo());
+
+    EXPECT_TRUE(unmounted_library.findMissingFiles(4, abort_flag).empty());
 }
\ No newline at end of file
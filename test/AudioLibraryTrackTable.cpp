@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <set>
+
+#include <AudioLibrary.h>
+#include "../benchmark/SyntheticLibrary.h"
+
+namespace {
+
+    std::set<const AudioLibraryTrack*> getAllTracks(const AudioLibrary& library)
+    {
+        std::set<const AudioLibraryTrack*> tracks;
+
+        for (const AudioLibraryAlbum* album : library.getAlbums())
+            tracks.insert(album->getTracks().begin(), album->getTracks().end());
+
+        return tracks;
+    }
+
+    void checkTable(const AudioLibrary& library)
+    {
+        using Column = AudioLibraryTrackTable::Column;
+        using StringColumn = AudioLibraryTrackTable::StringColumn;
+
+        const AudioLibraryTrackTable& track_table = library.getTrackTable();
+        const std::set<const AudioLibraryTrack*> tracks = getAllTracks(library);
+
+        // every track is in its row
+
+        size_t number_of_tracks = 0;
+
+        for (size_t row = 0; row < track_table.getNumberOfRows(); ++row)
+        {
+            const AudioLibraryTrack* track = track_table.getTrack(static_cast<quint32>(row));
+            if (!track)
+                continue;
+
+            ++number_of_tracks;
+            ASSERT_TRUE(tracks.contains(track));
+            ASSERT_EQ(track->getTableRow(), row);
+            ASSERT_EQ(track_table.getColumn(Column::YEAR)[row], track->getAlbum()->getKey().getYear());
+            ASSERT_EQ(track_table.getColumn(Column::LENGTH_MS)[row], track->getLengthMs());
+            ASSERT_EQ(track_table.getColumn(Column::BITRATE_KBS)[row], track->getBitrateKbs());
+            ASSERT_EQ(track_table.getColumn(StringColumn::ARTIST)[row], track_table.findString(track->getArtist()));
+            ASSERT_EQ(track_table.getColumn(StringColumn::ALBUM_ARTIST)[row], track_table.findString(track->getAlbumArtist()));
+        }
+
+        ASSERT_EQ(number_of_tracks, tracks.size());
+
+        // scans find the same tracks as a comparison of every track
+
+        for (const auto& [min, max] : { std::pair<qint64, qint64>(0, 200), std::pair<qint64, qint64>(256, 320), std::pair<qint64, qint64>(1000, 0) })
+        {
+            const std::vector<const AudioLibraryTrack*> found = track_table.findTracks(Column::BITRATE_KBS, min, max);
+
+            std::set<const AudioLibraryTrack*> expected;
+            for (const AudioLibraryTrack* track : tracks)
+                if (track->getBitrateKbs() >= min && track->getBitrateKbs() <= max)
+                    expected.insert(track);
+
+            ASSERT_EQ(std::set<const AudioLibraryTrack*>(found.begin(), found.end()), expected);
+            ASSERT_EQ(found.size(), expected.size());
+        }
+    }
+
+}
+
+TEST(AudioExplorer, AudioLibraryTrackTable)
+{
+    AudioLibrary library;
+    addSyntheticTracks(library, SyntheticLibraryGenerator().createTracks(200, 10));
+
+    checkTable(library);
+
+    const QString artist = SyntheticLibraryGenerator::artistName(0);
+    ASSERT_NE(library.getTrackTable().findString(artist), AudioLibraryTrackTable::NO_STRING);
+
+    // removed rows are reused, strings without tracks are removed from the pool
+
+    const size_t number_of_rows = library.getTrackTable().getNumberOfRows();
+
+    std::unordered_set<QString> remaining_files;
+    for (const AudioLibraryTrack* track : getAllTracks(library))
+        if (track->getArtist() != artist && track->getAlbumArtist() != artist)
+            remaining_files.insert(track->getFilepath());
+
+    library.removeTracksExcept(remaining_files);
+    checkTable(library);
+    ASSERT_EQ(library.getTrackTable().findString(artist), AudioLibraryTrackTable::NO_STRING);
+
+    addSyntheticTracks(library, SyntheticLibraryGenerator(2).createTracks(10, 10));
+    checkTable(library);
+    ASSERT_EQ(library.getTrackTable().getNumberOfRows(), number_of_rows);
+
+    // the snapshot copy refers to its own tracks
+
+    const AudioLibrary copy(library);
+    checkTable(copy);
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <AudioLibraryViewBuilder.h>
+#include "../benchmark/SyntheticLibrary.h"
+
+TEST(AudioExplorer, AudioLibraryViewBuilder)
+{
+    ThreadSafeAudioLibrary library;
+    size_t number_of_albums = 0;
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        addSyntheticTracks(acc.getLibraryForUpdate(), SyntheticLibraryGenerator().createTracks(100, 10));
+        number_of_albums = acc.getLibrary().getAlbums().size();
+    }
+
+    library.publishSnapshot();
+
+    AudioLibraryViewBuilder builder(library);
+
+    // the first build is canceled by the second one, only the second one delivers its rows
+
+    builder.startBuilding(AudioLibraryViewAllTracks(QString()), AudioLibraryView::DisplayMode::TRACKS);
+    builder.startBuilding(AudioLibraryViewAllAlbums(QString()), AudioLibraryView::DisplayMode::ALBUMS);
+    ASSERT_TRUE(builder.isBuilding());
+
+    std::unique_ptr<AudioLibraryViewBuilder::Result> result;
+    while (!(result = builder.takeResult()))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    ASSERT_FALSE(builder.isBuilding());
+    ASSERT_EQ(result->view_id, AudioLibraryViewAllAlbums(QString()).getId());
+    ASSERT_EQ(result->display_mode, AudioLibraryView::DisplayMode::ALBUMS);
+    ASSERT_EQ(result->rows.size(), number_of_albums);
+
+    // the rows are copies, they don't change with the library
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        acc.getLibraryForUpdate().removeTracksExcept({});
+    }
+
+    library.publishSnapshot();
+
+    const std::vector<AudioLibraryRowSet::Row> rows = result->rows.takeRows();
+    ASSERT_EQ(rows.size(), number_of_albums);
+    ASSERT_FALSE(rows.front().display_role_data[AudioLibraryView::ALBUM].toString().isEmpty());
+}
+
+TEST(AudioExplorer, AudioLibraryViewBuilderCache)
+{
+    ThreadSafeAudioLibrary library;
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        addSyntheticTracks(acc.getLibraryForUpdate(), SyntheticLibraryGenerator().createTracks(100, 10));
+    }
+
+    library.publishSnapshot();
+
+    AudioLibraryViewBuilder builder(library);
+
+    auto waitForResult = [&builder]() {
+        std::unique_ptr<AudioLibraryViewBuilder::Result> result;
+        while (!(result = builder.takeResult()))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return result;
+    };
+
+    builder.startBuilding(AudioLibraryViewAllArtists(QString()), AudioLibraryView::DisplayMode::ARTISTS);
+    const size_t number_of_artists = waitForResult()->rows.size();
+
+    builder.startBuilding(AudioLibraryViewAllAlbums(QString()), AudioLibraryView::DisplayMode::ALBUMS);
+    waitForResult();
+
+    // going back to a view of the same generation delivers the cached rows right away
+
+    builder.startBuilding(AudioLibraryViewAllArtists(QString()), AudioLibraryView::DisplayMode::ARTISTS);
+    std::unique_ptr<AudioLibraryViewBuilder::Result> result = builder.takeResult();
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result->view_id, AudioLibraryViewAllArtists(QString()).getId());
+    ASSERT_EQ(result->rows.size(), number_of_artists);
+
+    // the cached group views are copies, taking the rows doesn't empty the cache
+
+    ASSERT_TRUE(result->rows.takeRows().front().view);
+
+    builder.startBuilding(AudioLibraryViewAllArtists(QString()), AudioLibraryView::DisplayMode::ARTISTS);
+    result = builder.takeResult();
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result->rows.size(), number_of_artists);
+
+    // a modification invalidates the cache once it's published
+
+    const quint64 generation = library.getGeneration();
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        acc.getLibraryForUpdate().removeTracksExcept({});
+    }
+
+    ASSERT_NE(library.getGeneration(), generation);
+
+    builder.startBuilding(AudioLibraryViewAllArtists(QString()), AudioLibraryView::DisplayMode::ARTISTS);
+    result = builder.takeResult();
+    ASSERT_TRUE(result);
+    ASSERT_EQ(result->rows.size(), number_of_artists);
+
+    library.publishSnapshot();
+
+    builder.startBuilding(AudioLibraryViewAllArtists(QString()), AudioLibraryView::DisplayMode::ARTISTS);
+    ASSERT_TRUE(builder.isBuilding());
+    ASSERT_EQ(waitForResult()->rows.size(), 0u);
+}
\ No newline at end of file
@@ -1,11 +1,16 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "gtest/gtest.h"
 
+#include <map>
+#include <set>
+#include <tuple>
+
 #include <QtGui/qstandarditemmodel.h>
 #include <QtWidgets/qapplication.h>
 
 #include <AudioLibrary.h>
 #include <AudioLibraryModel.h>
+#include "../benchmark/SyntheticLibrary.h"
 #include "tools.h"
 
 bool testAudioLibraryView(const AudioLibrary& library, const AudioLibraryView& view, AudioLibraryView::DisplayMode display_mode, QStringList& result_list)
@@ -15,7 +20,9 @@ bool testAudioLibraryView(const AudioLibrary& library, const AudioLibraryView& v
     AudioLibraryGroupUuidCache group_uuids;
     AudioLibraryModel model(nullptr, group_uuids);
 
-    view.createItems(library, display_mode, &model);
+    AudioLibraryRowSet rows;
+    view.createItems(library, display_mode, rows);
+    model.addRows(std::move(rows));
     model.getModel()->sort(AudioLibraryView::ZERO);
 
     // serialize model
@@ -103,7 +110,7 @@ void AlbumCreator::addTrack(QString title, int min, int sec)
     const int length_milliseconds = (min * 60 + sec) * 1000;
 
     _library.addTrack(QString("%1 %2 %3").arg(_artist).arg(_year).arg(title), QDateTime(), 0,
-        createTrackInfo(_artist, _album_artist, _album, _year, _genre, QByteArray(), title, _track_number, length_milliseconds));
+        createTrackInfo(_artist, _album_artist, _album, _year, _genre, CoverLocation(), title, _track_number, length_milliseconds));
 
     ++_track_number;
 }
@@ -195,4 +202,96 @@ TEST(AudioExplorer, AudioLibraryViews)
     ASSERT_TRUE(testAudioLibraryView(library, AudioLibraryViewDuplicateAlbums(), AudioLibraryView::DisplayMode::ALBUMS, result_list));
 
     ASSERT_TRUE(checkAgainstReferenceDataFile("test_data/AudioLibraryViews.txt", result_list.join('\n')));
+}
+
+namespace {
+
+    /**
+    * Number of albums, number of tracks and uuid of the showcase album by the name of the group.
+    */
+    using GroupSummary = std::tuple<int, int, QUuid>;
+
+    std::map<QString, GroupSummary> getGroups(const AudioLibrary& library, const AudioLibraryView& view, AudioLibraryView::DisplayMode display_mode)
+    {
+        AudioLibraryRowSet rows;
+        view.createItems(library, display_mode, rows);
+
+        std::map<QString, GroupSummary> result;
+
+        for (const AudioLibraryRowSet::Row& row : rows.takeRows())
+            result[row.group_name] = { row.number_of_albums, row.number_of_tracks, row.decoration_album_id };
+
+        return result;
+    }
+
+    /**
+    * Aggregates the groups on one thread, in the order of the library.
+    */
+    class SequentialGroups
+    {
+    public:
+        void add(const QString& name, const AudioLibraryAlbum* album, int num_tracks)
+        {
+            Group& group = _groups[name];
+
+            // the first album with a cover, otherwise the last one
+            if (!group.showcase_album || group.showcase_album->getCover().isEmpty())
+                group.showcase_album = album;
+
+            group.albums.insert(album);
+            group.num_tracks += num_tracks;
+        }
+
+        std::map<QString, GroupSummary> getSummaries() const
+        {
+            std::map<QString, GroupSummary> result;
+
+            for (const auto& [name, group] : _groups)
+                result[name] = { static_cast<int>(group.albums.size()), group.num_tracks, group.showcase_album->getUuid() };
+
+            return result;
+        }
+
+    private:
+        struct Group
+        {
+            const AudioLibraryAlbum* showcase_album = nullptr;
+            std::set<const AudioLibraryAlbum*> albums;
+            int num_tracks = 0;
+        };
+
+        std::map<QString, Group> _groups;
+    };
+}
+
+TEST(AudioExplorer, AudioLibraryViewsLargeGroups)
+{
+    int argc = 1;
+    char* argv = const_cast<char*>("");
+    QApplication app(argc, &argv);
+
+    // a thread aggregates at least 16384 items, so the years need more albums than that for several slices.
+    // One in five synthetic albums has no cover, so the showcase albums depend on the order of the merge.
+
+    AudioLibrary library;
+    addSyntheticTracks(library, SyntheticLibraryGenerator().createTracks(70000, 2));
+
+    SequentialGroups artists;
+    SequentialGroups years;
+
+    for (const AudioLibraryAlbum* album : library.getAlbums())
+    {
+        for (const AudioLibraryTrack* track : album->getTracks())
+        {
+            artists.add(track->getArtist(), album, 1);
+
+            if (!track->getAlbumArtist().isEmpty() && track->getAlbumArtist() != track->getArtist())
+                artists.add(track->getAlbumArtist(), album, 1);
+        }
+
+        years.add(QString::number(album->getKey().getYear()), album, static_cast<int>(album->getTracks().size()));
+    }
+
+    ASSERT_EQ(getGroups(library, AudioLibraryViewAllArtists(QString()), AudioLibraryView::DisplayMode::ARTISTS), artists.getSummaries());
+    ASSERT_EQ(getGroups(library, AudioLibraryViewAllYears(), AudioLibraryView::DisplayMode::YEARS), years.getSummaries());
 }
\ No newline at end of file
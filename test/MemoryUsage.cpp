@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <QtWidgets/qapplication.h>
+
+#include <AudioLibraryModel.h>
+#include "../benchmark/SyntheticLibrary.h"
+
+namespace {
+
+    // budgets per track, roughly twice the current usage, so that only real regressions fail
+
+    const size_t LIBRARY_BYTES_PER_TRACK = 1536;
+    const size_t MODEL_BYTES_PER_ROW = 5120;
+
+    const int NUMBER_OF_ALBUMS = 1000;
+    const int TRACKS_PER_ALBUM = 10;
+}
+
+TEST(AudioExplorer, MemoryUsageLibrary)
+{
+    AudioLibrary library;
+    addSyntheticTracks(library, SyntheticLibraryGenerator().createTracks(NUMBER_OF_ALBUMS, TRACKS_PER_ALBUM));
+
+    const AudioLibrary::MemoryUsage usage = library.getMemoryUsage();
+    const size_t number_of_tracks = library.getNumberOfTracks();
+
+    ASSERT_EQ(number_of_tracks, size_t(NUMBER_OF_ALBUMS * TRACKS_PER_ALBUM));
+
+    ASSERT_GE(usage.tracks, number_of_tracks * sizeof(AudioLibraryTrack));
+    ASSERT_GT(usage.strings, 0u);
+    ASSERT_GT(usage.maps, 0u);
+    ASSERT_GT(usage.covers, 0u);
+
+    ASSERT_LE(usage.total() / number_of_tracks, LIBRARY_BYTES_PER_TRACK);
+}
+
+TEST(AudioExplorer, MemoryUsageModel)
+{
+    int argc = 1;
+    char* argv = const_cast<char*>("");
+    QApplication app(argc, &argv);
+
+    AudioLibrary library;
+    addSyntheticTracks(library, SyntheticLibraryGenerator().createTracks(NUMBER_OF_ALBUMS, TRACKS_PER_ALBUM));
+
+    AudioLibraryGroupUuidCache group_uuids;
+    AudioLibraryModel model(nullptr, group_uuids);
+    AudioLibraryRowSet rows;
+    AudioLibraryViewAllTracks(QString()).createItems(library, AudioLibraryView::DisplayMode::TRACKS, rows);
+    model.addRows(std::move(rows));
+
+    const AudioLibraryModel::MemoryUsage usage = model.getMemoryUsage();
+    const size_t number_of_rows = static_cast<size_t>(model.getModel()->rowCount());
+
+    ASSERT_EQ(number_of_rows, library.getNumberOfTracks());
+
+    ASSERT_GT(usage.rows, 0u);
+    ASSERT_GT(usage.display_strings, 0u);
+    ASSERT_GT(usage.decorations, 0u);
+
+    // nothing has been painted, so no cover is decoded
+
+    ASSERT_EQ(model.getDecorationStatistics().decoded, 0);
+
+    ASSERT_LE(usage.total() / number_of_rows, MODEL_BYTES_PER_ROW);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <PerformanceCounters.h>
+
+TEST(AudioExplorer, PerformanceCounters)
+{
+    using namespace std::chrono_literals;
+
+    PerformanceCounters counters;
+
+    // the limits are inclusive, everything beyond the last limit goes into the last bucket
+
+    counters.addParseLatency(50us);
+    counters.addParseLatency(100us);
+    counters.addParseLatency(101us);
+    counters.addParseLatency(1ms);
+    counters.addParseLatency(3ms);
+    counters.addParseLatency(10s);
+
+    const size_t last_bucket = PerformanceCounters::PARSE_LATENCY_LIMITS_MS.size();
+
+    ASSERT_EQ(counters.parse_latency_histogram[0].load(), 2u);
+    ASSERT_EQ(counters.parse_latency_histogram[1].load(), 1u);
+    ASSERT_EQ(counters.parse_latency_histogram[3].load(), 1u);
+    ASSERT_EQ(counters.parse_latency_histogram[5].load(), 1u);
+    ASSERT_EQ(counters.parse_latency_histogram[last_bucket].load(), 1u);
+
+    counters.addLockWait(2ms);
+    counters.addLockWait(3ms);
+
+    ASSERT_EQ(counters.lock_contentions.load(), 2u);
+    ASSERT_EQ(counters.lock_wait_ns.load(), 5000000);
+
+    {
+        ScopedDurationCounter duration_counter(counters.last_sort_ns);
+    }
+
+    ASSERT_GE(counters.last_sort_ns.load(), 0);
+}
\ No newline at end of file
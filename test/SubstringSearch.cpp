@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <random>
+
+#include <SubstringSearch.h>
+
+TEST(AudioExplorer, SubstringSearch)
+{
+    // small alphabets produce many partial matches, the last character exercises the sign of the 16 bit comparison
+
+    const QString alphabet = QString::fromUtf8("abcä") + QChar(0xFFFF);
+
+    std::mt19937 rng(1);
+    auto random = [&rng](int n) { return static_cast<int>(rng() % static_cast<quint32>(n)); };
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        const int alphabet_size = 1 + random(static_cast<int>(alphabet.size()));
+
+        QString haystack;
+        for (int j = 0, n = random(80); j < n; ++j)
+            haystack += alphabet[random(alphabet_size)];
+
+        QString needle;
+        if (!haystack.isEmpty() && random(2) == 0)
+        {
+            const int start = random(static_cast<int>(haystack.size()));
+            needle = haystack.mid(start, random(static_cast<int>(haystack.size()) - start + 1));
+        }
+        else
+        {
+            for (int j = 0, n = random(8); j < n; ++j)
+                needle += alphabet[random(alphabet_size)];
+        }
+
+        const bool expected = haystack.contains(needle);
+
+        for (SubstringSearchKernel kernel : getSupportedSubstringSearchKernels())
+            ASSERT_EQ(containsSubstring(haystack, needle, kernel), expected) << static_cast<int>(kernel) << " " << haystack.toStdString() << " " << needle.toStdString();
+
+        ASSERT_EQ(containsSubstring(haystack, needle), expected);
+    }
+
+    // matches in a view don't continue after its end
+
+    const QString text = "0123456789abcdefghijklmnopqrstuvwxyz";
+    EXPECT_TRUE(containsSubstring(QStringView(text).first(20), u"9abcdefghij"));
+    EXPECT_FALSE(containsSubstring(QStringView(text).first(20), u"9abcdefghijk"));
+    EXPECT_TRUE(containsSubstring(QStringView(text).sliced(3), u"3456"));
+    EXPECT_FALSE(containsSubstring(QStringView(text).sliced(3), u"2345"));
+}
\ No newline at end of file
@@ -1,10 +1,14 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "gtest/gtest.h"
 
+#include <algorithm>
+
+#include <QtCore/qtemporarydir.h>
 #include <QtWidgets/qapplication.h>
 
 #include <ThreadSafeAudioLibrary.h>
 #include "tools.h"
+#include "../benchmark/SyntheticLibrary.h"
 
 TEST(AudioExplorer, ThreadSafeAudioLibrary)
 {
@@ -15,7 +19,14 @@ TEST(AudioExplorer, ThreadSafeAudioLibrary)
     ThreadSafeAudioLibrary library;
     library.setCacheLocation(QString());
 
+    // no time limits, so that the number of batches doesn't depend on the machine
+
+    AudioFilesLoaderTuning tuning;
+    tuning.batch_interval = std::chrono::hours(1);
+    tuning.max_lock_hold_time = std::chrono::hours(1);
+
     AudioFilesLoader audio_files_loader(library);
+    audio_files_loader.setTuning(tuning);
     audio_files_loader.startLoading({ "test_data" });
 
     // wait until the thread is finished
@@ -28,4 +39,209 @@ TEST(AudioExplorer, ThreadSafeAudioLibrary)
     ThreadSafeAudioLibrary::LibraryAccessor acc(library);
 
     ASSERT_EQ(acc.getLibrary().getAlbums().size(), 1);
+
+    // the loader publishes the finished library for the readers
+
+    ASSERT_EQ(library.getSnapshot()->getGeneration(), acc.getLibrary().getGeneration());
+    ASSERT_EQ(library.getSnapshot()->getAlbums().size(), 1);
+
+    // all files are in one directory, so lookups and insertions need one lock acquisition each
+
+    const AudioFilesLoader::Statistics statistics = audio_files_loader.getStatistics();
+    EXPECT_EQ(statistics.lock_acquisitions, 3);
+    EXPECT_GT(statistics.unbatched_lock_acquisitions, statistics.lock_acquisitions);
+    EXPECT_TRUE(statistics.completed);
+}
+
+TEST(AudioExplorer, ThreadSafeAudioLibrarySnapshot)
+{
+    ThreadSafeAudioLibrary library;
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        addSyntheticTracks(acc.getLibraryForUpdate(), SyntheticLibraryGenerator().createTracks(10, 10));
+    }
+
+    ASSERT_EQ(library.getSnapshot()->getNumberOfTracks(), 0);
+
+    library.publishSnapshot();
+    const std::shared_ptr<const AudioLibrary> snapshot = library.getSnapshot();
+    ASSERT_EQ(snapshot->getNumberOfTracks(), 100);
+
+    // an unchanged library isn't copied again
+
+    library.publishSnapshot();
+    ASSERT_EQ(library.getSnapshot(), snapshot);
+
+    // the copies have the same uuids, their pointers and the search index refer to the copies
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+
+        for (const AudioLibraryAlbum* album : acc.getLibrary().getAlbums())
+        {
+            const AudioLibraryAlbum* album_copy = snapshot->getAlbum(album->getKey());
+            ASSERT_TRUE(album_copy);
+            ASSERT_NE(album_copy, album);
+            ASSERT_EQ(album_copy->getUuid(), album->getUuid());
+            ASSERT_EQ(album_copy->getTracks().size(), album->getTracks().size());
+
+            for (const AudioLibraryTrack* track_copy : album_copy->getTracks())
+            {
+                ASSERT_EQ(track_copy->getAlbum(), album_copy);
+                ASSERT_EQ(snapshot->findTrack(track_copy->getFilepath()), track_copy);
+                ASSERT_EQ(track_copy->getUuid(), acc.getLibrary().findTrack(track_copy->getFilepath())->getUuid());
+            }
+        }
+
+        const AudioLibraryTrack* track = snapshot->getAlbums().front()->getTracks().front();
+        const std::vector<const AudioLibraryTrack*> found = snapshot->getSearchIndex().findTracks(AudioLibrarySearchIndex::TrackField::TITLE, { track->getTitle() }, {});
+        ASSERT_NE(std::ranges::find(found, track), found.end());
+
+        acc.getLibraryForUpdate().removeTracksExcept({});
+    }
+
+    // the snapshot doesn't change with the library
+
+    ASSERT_EQ(snapshot->getNumberOfTracks(), 100);
+    ASSERT_EQ(library.getSnapshot()->getNumberOfTracks(), 100);
+
+    library.publishSnapshot();
+    ASSERT_EQ(library.getSnapshot()->getNumberOfTracks(), 0);
+}
+
+TEST(AudioExplorer, ThreadSafeAudioLibrarySnapshotChanges)
+{
+    ThreadSafeAudioLibrary library;
+
+    auto expect_snapshot_up_to_date = [&library]() {
+        const std::shared_ptr<const AudioLibrary> snapshot = library.getSnapshot();
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+
+        EXPECT_EQ(snapshot->getGeneration(), acc.getLibrary().getGeneration());
+        EXPECT_EQ(snapshot->getNumberOfTracks(), acc.getLibrary().getNumberOfTracks());
+        EXPECT_TRUE(compareLibraries(*snapshot, acc.getLibrary()));
+
+        for (const AudioLibraryAlbum* album : acc.getLibrary().getAlbums())
+        {
+            const AudioLibraryAlbum* album_copy = snapshot->getAlbum(album->getKey());
+            ASSERT_TRUE(album_copy);
+            EXPECT_EQ(album_copy->getUuid(), album->getUuid());
+
+            for (const AudioLibraryTrack* track : album->getTracks())
+                EXPECT_EQ(snapshot->findTrack(track->getFilepath())->getUuid(), track->getUuid());
+        }
+    };
+
+    std::vector<SyntheticTrack> tracks = SyntheticLibraryGenerator().createTracks(20, 10);
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        addSyntheticTracks(acc.getLibraryForUpdate(), tracks);
+    }
+
+    library.publishSnapshot();
+    expect_snapshot_up_to_date();
+
+    // the first snapshot has been released, so it's updated with the changes of both publications
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+
+        for (size_t i = 0; i < tracks.size(); i += 3)
+            acc.getLibraryForUpdate().removeTrack(tracks[i].filepath);
+
+        for (size_t i = 1; i < tracks.size(); i += 7)
+        {
+            tracks[i].info.title += " (Live)";
+            addSyntheticTracks(acc.getLibraryForUpdate(), { tracks[i] });
+        }
+    }
+
+    library.publishSnapshot();
+    expect_snapshot_up_to_date();
+
+    // a snapshot that is still held isn't changed, the last one is copied instead
+
+    const std::shared_ptr<const AudioLibrary> held_snapshot = library.getSnapshot();
+    const size_t held_number_of_tracks = held_snapshot->getNumberOfTracks();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        {
+            ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+            addSyntheticTracks(acc.getLibraryForUpdate(), { tracks[i * 3] });
+        }
+
+        library.publishSnapshot();
+        expect_snapshot_up_to_date();
+    }
+
+    ASSERT_EQ(held_snapshot->getNumberOfTracks(), held_number_of_tracks);
+
+    // everything is removed and added again
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        acc.getLibraryForUpdate().removeTracksExcept({});
+        addSyntheticTracks(acc.getLibraryForUpdate(), SyntheticLibraryGenerator(2).createTracks(5, 10));
+    }
+
+    library.publishSnapshot();
+    expect_snapshot_up_to_date();
+
+    // loading a cache clears the library first
+
+    {
+        AudioLibrary cached_library;
+        addSyntheticTracks(cached_library, SyntheticLibraryGenerator(3).createTracks(8, 10));
+
+        QByteArray data;
+        QDataStream out(&data, QIODevice::WriteOnly);
+        cached_library.save(out);
+
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        QDataStream in(data);
+        acc.getLibraryForUpdate().load(in);
+        ASSERT_EQ(acc.getLibrary().getNumberOfTracks(), 80);
+    }
+
+    library.publishSnapshot();
+    expect_snapshot_up_to_date();
+
+    library.publishSnapshot();
+    expect_snapshot_up_to_date();
+}
+
+TEST(AudioExplorer, ThreadSafeAudioLibrarySaveToCache)
+{
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    ThreadSafeAudioLibrary library;
+
+    {
+        ThreadSafeAudioLibrary::LibraryAccessor acc(library);
+        addSyntheticTracks(acc.getLibraryForUpdate(), SyntheticLibraryGenerator().createTracks(1, 10));
+    }
+
+    // a partially loaded library isn't saved
+
+    library.setCacheLocation(dir.filePath("cache/AudioLibrary"));
+    EXPECT_FALSE(library.saveToCache());
+
+    library.setFinishedLoadingFromCache();
+
+    // the cache directory can't be created below a file
+
+    QFile file(dir.filePath("file"));
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    library.setCacheLocation(dir.filePath("file/AudioLibrary"));
+    EXPECT_FALSE(library.saveToCache());
+
+    library.setCacheLocation(dir.filePath("cache/AudioLibrary"));
+    EXPECT_TRUE(library.saveToCache());
+    EXPECT_TRUE(QFileInfo::exists(dir.filePath("cache/AudioLibrary")));
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qfile.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qjsonobject.h>
+
+#include <Tracing.h>
+
+TEST(AudioExplorer, Tracing)
+{
+    int argc = 1;
+    char* argv = const_cast<char*>("");
+    QCoreApplication app(argc, &argv);
+
+    {
+        TraceSpan outer("TracingTestOuter");
+        TraceSpan inner("TracingTestInner");
+    }
+
+    std::thread thread([]() {
+        setTraceThreadName("TracingTestThread");
+        TraceSpan span("TracingTestThreadSpan");
+        });
+    thread.join();
+
+    const QString filepath = "test_data/trace.json";
+    ASSERT_TRUE(saveChromeTrace(filepath));
+
+    QFile file(filepath);
+    ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    const QJsonArray trace_events = document.object()["traceEvents"].toArray();
+
+    QJsonObject outer, inner, thread_span;
+    int test_thread_id = -1;
+
+    for (const QJsonValue& value : trace_events)
+    {
+        const QJsonObject event = value.toObject();
+        const QString name = event["name"].toString();
+
+        if (name == "TracingTestOuter")
+            outer = event;
+        else if (name == "TracingTestInner")
+            inner = event;
+        else if (name == "TracingTestThreadSpan")
+            thread_span = event;
+        else if (name == "thread_name" && event["args"].toObject()["name"].toString() == "TracingTestThread")
+            test_thread_id = event["tid"].toInt();
+    }
+
+    // complete events, the inner span lies within the outer one
+
+    ASSERT_EQ(outer["ph"].toString(), "X");
+    ASSERT_EQ(inner["ph"].toString(), "X");
+    ASSERT_EQ(outer["tid"].toInt(), inner["tid"].toInt());
+    ASSERT_GE(inner["ts"].toDouble(), outer["ts"].toDouble());
+    ASSERT_LE(inner["ts"].toDouble() + inner["dur"].toDouble(), outer["ts"].toDouble() + outer["dur"].toDouble() + 0.001);
+
+    // spans of other threads are listed under their own thread
+
+    ASSERT_NE(test_thread_id, -1);
+    ASSERT_EQ(thread_span["tid"].toInt(), test_thread_id);
+    ASSERT_NE(thread_span["tid"].toInt(), outer["tid"].toInt());
+}
\ No newline at end of file
@@ -2,8 +2,10 @@
 #include "gtest/gtest.h"
 
 #include <QtCore/qcoreapplication.h>
+#include <QtCore/qtemporarydir.h>
 
 #include <AudioLibrary.h>
+#include <NativeTrackInfoReader.h>
 #include "tools.h"
 
 void readAndAssertTrackInfo(const QString& audio_filepath, const QString& cover_filepath)
@@ -19,7 +21,12 @@ void readAndAssertTrackInfo(const QString& audio_filepath, const QString& cover_
 
     const QByteArray original_cover = cover_file.readAll();
     EXPECT_TRUE(!original_cover.isEmpty());
-    EXPECT_EQ(info.cover, original_cover);
+    EXPECT_EQ(info.cover.filepath, audio_filepath);
+    EXPECT_EQ(info.cover.data_size, original_cover.size());
+    EXPECT_EQ(info.cover.checksum, qChecksum(original_cover));
+    EXPECT_EQ(info.cover.format, "jpg");
+    EXPECT_FALSE(info.cover.image_size.isEmpty());
+    EXPECT_EQ(readCover(info.cover), original_cover);
 
     EXPECT_EQ(info.album_artist, "albumartist");
     EXPECT_EQ(info.disc_number, 1);
@@ -39,4 +46,151 @@ TEST(AudioExplorer, TrackInfo)
     readAndAssertTrackInfo("test_data/noise.m4a", original_cover_filepath);
     readAndAssertTrackInfo("test_data/noise.wma", original_cover_filepath);
     readAndAssertTrackInfo("test_data/noise.ape", original_cover_filepath);
+}
+
+void compareNativeAndTagLibTrackInfo(const QString& audio_filepath, bool is_native_supported)
+{
+    TrackInfo native_info;
+    ASSERT_EQ(readTrackInfoNative(audio_filepath, native_info), is_native_supported);
+
+    if (!is_native_supported)
+        return;
+
+    TrackInfo taglib_info;
+    ASSERT_TRUE(readTrackInfoTagLib(audio_filepath, taglib_info));
+
+    EXPECT_EQ(native_info.artist, taglib_info.artist);
+    EXPECT_EQ(native_info.album_artist, taglib_info.album_artist);
+    EXPECT_EQ(native_info.album, taglib_info.album);
+    EXPECT_EQ(native_info.year, taglib_info.year);
+    EXPECT_EQ(native_info.genre, taglib_info.genre);
+    // taglib doesn't know the position of the picture, so only the description can be compared
+    EXPECT_EQ(native_info.cover.filepath, taglib_info.cover.filepath);
+    EXPECT_EQ(native_info.cover.data_size, taglib_info.cover.data_size);
+    EXPECT_EQ(native_info.cover.checksum, taglib_info.cover.checksum);
+    EXPECT_EQ(native_info.cover.format, taglib_info.cover.format);
+    EXPECT_EQ(native_info.cover.image_size, taglib_info.cover.image_size);
+    EXPECT_EQ(readCover(native_info.cover), readCover(taglib_info.cover));
+    EXPECT_EQ(native_info.disc_number, taglib_info.disc_number);
+    EXPECT_EQ(native_info.title, taglib_info.title);
+    EXPECT_EQ(native_info.track_number, taglib_info.track_number);
+    EXPECT_EQ(native_info.comment, taglib_info.comment);
+    EXPECT_EQ(native_info.tag_types, taglib_info.tag_types);
+
+    // audio properties use the same formulas as taglib, but allow for rounding differences between taglib versions
+    EXPECT_NEAR(native_info.length_milliseconds, taglib_info.length_milliseconds, 2);
+    EXPECT_EQ(native_info.channels, taglib_info.channels);
+    EXPECT_NEAR(native_info.bitrate_kbs, taglib_info.bitrate_kbs, 1);
+    EXPECT_EQ(native_info.samplerate_hz, taglib_info.samplerate_hz);
+}
+
+TEST(AudioExplorer, NativeTrackInfo)
+{
+    int argc = 1;
+    char* argv = const_cast<char*>("");
+    QCoreApplication app(argc, &argv);
+
+    compareNativeAndTagLibTrackInfo("test_data/noise.mp3", true);
+    compareNativeAndTagLibTrackInfo("test_data/noise.ogg", true);
+
+    // formats without a native reader fall back to taglib
+    compareNativeAndTagLibTrackInfo("test_data/noise.m4a", false);
+    compareNativeAndTagLibTrackInfo("test_data/noise.wma", false);
+    compareNativeAndTagLibTrackInfo("test_data/noise.ape", false);
+}
+
+TEST(AudioExplorer, EstimatedAudioProperties)
+{
+    int argc = 1;
+    char* argv = const_cast<char*>("");
+    QCoreApplication app(argc, &argv);
+
+    // the test file has an Info header, the length is known in both modes
+
+    TrackInfo info;
+    ASSERT_TRUE(readTrackInfoNative("test_data/noise.mp3", info, AudioPropertiesMode::FAST));
+    EXPECT_FALSE(info.audio_properties_estimated);
+    EXPECT_EQ(info.length_milliseconds / 1000, 1);
+
+    // without the Info header, only the accurate mode can tell the length
+
+    QFile original_file("test_data/noise.mp3");
+    ASSERT_TRUE(original_file.open(QIODevice::ReadOnly));
+
+    QByteArray bytes = original_file.readAll();
+    ASSERT_TRUE(bytes.contains("Info"));
+    bytes.replace("Info", QByteArray(4, '\0'));
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    const QString filepath = dir.filePath("noise.mp3");
+
+    QFile file(filepath);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    ASSERT_EQ(file.write(bytes), bytes.size());
+    file.close();
+
+    TrackInfo fast_info;
+    ASSERT_TRUE(readTrackInfo(filepath, fast_info, AudioPropertiesMode::FAST));
+    EXPECT_TRUE(fast_info.audio_properties_estimated);
+
+    TrackInfo accurate_info;
+    ASSERT_TRUE(readTrackInfo(filepath, accurate_info, AudioPropertiesMode::ACCURATE));
+    EXPECT_FALSE(accurate_info.audio_properties_estimated);
+    EXPECT_EQ(accurate_info.length_milliseconds / 1000, 1);
+
+    // files read with TagLib are never flagged, reading them again wouldn't change anything
+
+    TrackInfo taglib_info;
+    ASSERT_TRUE(readTrackInfo("test_data/noise.m4a", taglib_info, AudioPropertiesMode::FAST));
+    EXPECT_FALSE(taglib_info.audio_properties_estimated);
+}
+
+TEST(AudioExplorer, CoverLocation)
+{
+    int argc = 1;
+    char* argv = const_cast<char*>("");
+    QCoreApplication app(argc, &argv);
+
+    QFile original_file("test_data/noise.mp3");
+    ASSERT_TRUE(original_file.open(QIODevice::ReadOnly));
+    QByteArray bytes = original_file.readAll();
+
+    QTemporaryDir dir;
+    ASSERT_TRUE(dir.isValid());
+
+    const QString filepath = dir.filePath("noise.mp3");
+
+    QFile file(filepath);
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    ASSERT_EQ(file.write(bytes), bytes.size());
+    file.close();
+
+    // the picture in the ID3v2 tag can be read directly
+
+    TrackInfo info;
+    ASSERT_TRUE(readTrackInfo(filepath, info));
+    ASSERT_GE(info.cover.offset, 0);
+
+    const QByteArray cover = readCover(info.cover);
+    ASSERT_FALSE(cover.isEmpty());
+    EXPECT_EQ(bytes.mid(info.cover.offset, info.cover.data_size), cover);
+
+    // without the offset, the tags are read again
+
+    CoverLocation relocated = info.cover;
+    relocated.offset = -1;
+    EXPECT_EQ(readCover(relocated), cover);
+
+    // modified pictures are detected by the checksum
+
+    bytes[info.cover.offset + info.cover.data_size / 2] = ~bytes[info.cover.offset + info.cover.data_size / 2];
+
+    ASSERT_TRUE(file.open(QIODevice::WriteOnly));
+    ASSERT_EQ(file.write(bytes), bytes.size());
+    file.close();
+
+    EXPECT_TRUE(readCover(info.cover).isEmpty());
+    EXPECT_TRUE(readCover(relocated).isEmpty());
 }
\ No newline at end of file
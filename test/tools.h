@@ -16,7 +16,7 @@ namespace {
         QString album,
         int year,
         QString genre,
-        QByteArray cover,
+        CoverLocation cover,
         QString title,
         int track_number,
         int length_milliseconds = 0)
@@ -58,8 +58,8 @@ namespace {
             if (album_a->getTracks().size() != album_b->getTracks().size())
                 return false;
 
-            auto tracks_a = album_a->getTracks();
-            auto tracks_b = album_b->getTracks();
+            std::vector<const AudioLibraryTrack*> tracks_a(album_a->getTracks().begin(), album_a->getTracks().end());
+            std::vector<const AudioLibraryTrack*> tracks_b(album_b->getTracks().begin(), album_b->getTracks().end());
 
             auto compare_tracks = [](const AudioLibraryTrack* a, const AudioLibraryTrack* b) {
                 return a->getFilepath() < b->getFilepath();
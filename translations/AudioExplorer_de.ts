@@ -89,10 +89,10 @@
         </translation>
     </message>
     <message numerus="yes">
-        <source>%1 files loaded</source>
+        <source>%1 files loaded (%2 files/s, %3 MB/s)</source>
         <translation>
-            <numerusform>%1 Datei geladen</numerusform>
-            <numerusform>%1 Dateien geladen</numerusform>
+            <numerusform>%1 Datei geladen (%2 Dateien/s, %3 MB/s)</numerusform>
+            <numerusform>%1 Dateien geladen (%2 Dateien/s, %3 MB/s)</numerusform>
         </translation>
     </message>
     <message numerus="yes">
@@ -134,12 +134,168 @@
         <source>Select random item</source>
         <translation>Zufälligen Eintrag auswählen</translation>
     </message>
+    <message numerus="yes">
+        <source>Exact length and bitrate read for %1 files</source>
+        <translation>
+            <numerusform>Exakte Länge und Bitrate für %1 Datei gelesen</numerusform>
+            <numerusform>Exakte Länge und Bitrate für %1 Dateien gelesen</numerusform>
+        </translation>
+    </message>
+    <message>
+        <source>Save performance trace...</source>
+        <translation>Performance-Trace speichern...</translation>
+    </message>
+    <message>
+        <source>Save performance trace</source>
+        <translation>Performance-Trace speichern</translation>
+    </message>
+    <message>
+        <source>Chrome trace (*.json)</source>
+        <translation>Chrome-Trace (*.json)</translation>
+    </message>
+    <message>
+        <source>The trace could not be written to &quot;%1&quot;.</source>
+        <translation>Der Trace konnte nicht nach &quot;%1&quot; geschrieben werden.</translation>
+    </message>
+    <message>
+        <source>Performance...</source>
+        <translation>Leistung...</translation>
+    </message>
+    <message>
+        <source>Building view...</source>
+        <translation>Ansicht wird erstellt...</translation>
+    </message>
+    <message>
+        <source>Prune missing files</source>
+        <translation>Fehlende Dateien entfernen</translation>
+    </message>
+    <message numerus="yes">
+        <source>%1 missing files removed in %2s</source>
+        <translation>
+            <numerusform>%1 fehlende Datei entfernt in %2 Sekunden</numerusform>
+            <numerusform>%1 fehlende Dateien entfernt in %2 Sekunden</numerusform>
+        </translation>
+    </message>
+</context>
+<context>
+    <name>PerformanceDialog</name>
+    <message>
+        <source>Performance</source>
+        <translation>Leistung</translation>
+    </message>
+    <message>
+        <source>Scan</source>
+        <translation>Scan</translation>
+    </message>
+    <message>
+        <source>Throughput:</source>
+        <translation>Durchsatz:</translation>
+    </message>
+    <message>
+        <source>Tag parse latency</source>
+        <translation>Dauer des Tag-Lesens</translation>
+    </message>
+    <message>
+        <source>Library lock</source>
+        <translation>Bibliothekssperre</translation>
+    </message>
+    <message>
+        <source>Wait time:</source>
+        <translation>Wartezeit:</translation>
+    </message>
+    <message>
+        <source>View</source>
+        <translation>Ansicht</translation>
+    </message>
+    <message>
+        <source>Last build time:</source>
+        <translation>Letzte Aufbauzeit:</translation>
+    </message>
+    <message>
+        <source>Rows:</source>
+        <translation>Zeilen:</translation>
+    </message>
+    <message>
+        <source>Last sort time:</source>
+        <translation>Letzte Sortierzeit:</translation>
+    </message>
+    <message>
+        <source>Covers</source>
+        <translation>Cover</translation>
+    </message>
+    <message>
+        <source>Pending:</source>
+        <translation>Ausstehend:</translation>
+    </message>
+    <message>
+        <source>Decoded:</source>
+        <translation>Dekodiert:</translation>
+    </message>
+    <message>
+        <source>Memory:</source>
+        <translation>Speicher:</translation>
+    </message>
+    <message>
+        <source>Cache</source>
+        <translation>Cache</translation>
+    </message>
+    <message>
+        <source>Load time:</source>
+        <translation>Ladezeit:</translation>
+    </message>
+    <message>
+        <source>Save time:</source>
+        <translation>Speicherzeit:</translation>
+    </message>
+    <message>
+        <source>%1 files/s, %2 MB/s</source>
+        <translation>%1 Dateien/s, %2 MB/s</translation>
+    </message>
+    <message numerus="yes">
+        <source>%1 in %n contended acquisitions</source>
+        <translation>
+            <numerusform>%1 bei %n blockierten Zugriff</numerusform>
+            <numerusform>%1 bei %n blockierten Zugriffen</numerusform>
+        </translation>
+    </message>
+    <message>
+        <source>Memory</source>
+        <translation>Speicher</translation>
+    </message>
+    <message>
+        <source>Measure</source>
+        <translation>Messen</translation>
+    </message>
+    <message>
+        <source>Library:</source>
+        <translation>Bibliothek:</translation>
+    </message>
+    <message>
+        <source>View:</source>
+        <translation>Ansicht:</translation>
+    </message>
+    <message>
+        <source>%1 (strings %2, tracks %3, albums %4, covers %5, maps %6, search index %7)</source>
+        <translation>%1 (Texte %2, Titel %3, Alben %4, Cover %5, Zuordnungen %6, Suchindex %7)</translation>
+    </message>
+    <message>
+        <source>%1 (rows %2, display strings %3, sort strings %4, covers %5)</source>
+        <translation>%1 (Zeilen %2, Anzeigetexte %3, Sortiertexte %4, Cover %5)</translation>
+    </message>
+    <message>
+        <source>Last snapshot time:</source>
+        <translation>Letzte Snapshot-Dauer:</translation>
+    </message>
 </context>
 <context>
     <name>QObject</name>
     <message>
-        <source>not &quot;%1&quot;</source>
-        <translation>nicht &quot;%1&quot;</translation>
+        <source>not %1</source>
+        <translation>nicht %1</translation>
+    </message>
+    <message>
+        <source> or </source>
+        <translation> oder </translation>
     </message>
     <message>
         <source>Name</source>
@@ -289,6 +445,14 @@
         <source>File size</source>
         <translation>Dateigröße</translation>
     </message>
+    <message>
+        <source>Scanning</source>
+        <translation>Einlesen</translation>
+    </message>
+    <message>
+        <source>Fast scan (estimate length and bitrate first, read exact values in the background)</source>
+        <translation>Schnelles Einlesen (Länge und Bitrate zuerst schätzen, exakte Werte im Hintergrund lesen)</translation>
+    </message>
 </context>
 <context>
     <name>SettingsEditorDialog</name>
@@ -303,5 +467,13 @@
         <source>Filter...</source>
         <translation>Filter...</translation>
     </message>
+    <message>
+        <source>Words are searched in the names of the view. Other fields: artist:, album:, title:, genre:, comment:, path:
+Numbers: year:1990..1999, bitrate:&gt;256, length:&lt;3m, track:, disc:, samplerate:, channels:
+Combine with OR and parentheses, negate with ! or NOT, use quotes for phrases.</source>
+        <translation>Wörter werden in den Namen der Ansicht gesucht. Weitere Felder: artist:, album:, title:, genre:, comment:, path:
+Zahlen: year:1990..1999, bitrate:&gt;256, length:&lt;3m, track:, disc:, samplerate:, channels:
+Mit OR und Klammern kombinieren, mit ! oder NOT verneinen, Anführungszeichen für Wortgruppen.</translation>
+    </message>
 </context>
 </TS>